@@ -0,0 +1,43 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_BATCH_H
+#define __PINT_BATCH_H
+
+#define BATCH_BUFFER_SIZE (256 * 1024)
+#define BATCH_BYTES_PER_LINE 16
+
+/* function externs */
+extern int batch_open(char *);
+extern void batch_close();
+extern void batch_write(int, const unsigned char *, int);
+extern void batch_write_line(const char *);
+extern int batch_pending();
+extern void batch_flush();
+
+/* data externs */
+extern int batch_mode;
+
+#endif
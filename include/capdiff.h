@@ -0,0 +1,103 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_CAPDIFF_H
+#define __PINT_CAPDIFF_H
+
+/* content-defined chunks: a chunk ends where the top DIFF_CHUNK_BITS
+   of the gear hash of its last bytes are clear, but it is never
+   shorter than DIFF_CHUNK_MIN or longer than DIFF_CHUNK_MAX bytes */
+#define DIFF_CHUNK_MIN 64
+#define DIFF_CHUNK_BITS 8
+#define DIFF_CHUNK_MAX 4096
+
+/* chunk edits the alignment tries before the rest of a stream is
+   reported as one differing region */
+#define DIFF_MAX_EDITS 2048
+
+/* bytes per output line, lines shown of each side of a region, and
+   regions shown per stream */
+#define DIFF_LINE_BYTES 16
+#define DIFF_MAX_LINES 8
+#define DIFF_MAX_REGIONS 50
+
+/* a record payload of a stream, at stream offset off */
+typedef struct diff_segment_struct
+{
+    const unsigned char *data;
+    int len;
+    long long off;
+} diff_segment;
+
+/* a chunk of a stream; it ends where the next one starts */
+typedef struct diff_chunk_struct
+{
+    long long off;
+    uint64_t hash;
+} diff_chunk;
+
+/*
+ * One direction of a recorded session, as the record payloads in the
+ * mapped capture. The chunks array has a sentinel at the end of the
+ * stream.
+ */
+typedef struct diff_stream_struct
+{
+    diff_segment *segs;
+    int num_segs;
+    int segs_size;
+    long long bytes;
+    diff_chunk *chunks;
+    int num_chunks;
+} diff_stream;
+
+/* a differing region: bytes [a_off, a_end) of one stream against
+   [b_off, b_end) of the other */
+typedef struct diff_region_struct
+{
+    long long a_off, a_end;
+    long long b_off, b_end;
+} diff_region;
+
+typedef struct diff_session_struct
+{
+    int id;
+    diff_stream in;
+    diff_stream out;
+} diff_session;
+
+typedef struct diff_capture_struct
+{
+    char *path;
+    unsigned char *map;
+    size_t size;
+    diff_session **sessions;
+    int sessions_size;
+} diff_capture;
+
+/* function externs */
+extern int capdiff_run(char *, char *, int);
+
+#endif
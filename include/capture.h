@@ -0,0 +1,112 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef __PINT_CAPTURE_H
+#define __PINT_CAPTURE_H
+
+/*
+ * Capture log format. All fields are in host byte order.
+ *
+ * The file starts with a capture_header. Records follow it back to
+ * back, each a capture_record and its payload, padded with zeros to a
+ * multiple of CAPTURE_ALIGN bytes. A record type of CAPTURE_END (a
+ * zeroed header) ends the log; a log that was not closed properly
+ * ends in zeros where its pre-extended space was not used.
+ */
+#define CAPTURE_MAGIC "PINTCAP1"
+#define CAPTURE_VERSION 1
+#define CAPTURE_ALIGN 8
+
+/* the file is written through a mapping of this size, and grown by
+   this much at a time */
+#define CAPTURE_WINDOW_SIZE (16 * 1024 * 1024)
+#define CAPTURE_EXTEND_SIZE (64 * 1024 * 1024)
+
+/* once this much of the window is written, the next one is prepared
+   by idle work */
+#define CAPTURE_PREPARE_MARK (CAPTURE_WINDOW_SIZE / 2)
+
+enum CAPTURE_RECORD_TYPES
+{
+    CAPTURE_END = 0,
+    CAPTURE_IN,
+    CAPTURE_OUT,
+    CAPTURE_OPEN,
+    CAPTURE_CLOSE
+};
+
+/* timestamps are from CLOCK_MONOTONIC; the header ties them to the
+   wall clock */
+typedef struct capture_header_struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t start_realtime_ns;
+    uint64_t start_monotonic_ns;
+} capture_header;
+
+/* flags of a CAPTURE_OPEN record */
+#define CAPTURE_FLAG_UDP 0x01
+#define CAPTURE_FLAG_ACCEPTED 0x02
+
+/*
+ * A record: bytes received (CAPTURE_IN) or sent (CAPTURE_OUT) by a
+ * session, or a session opened or closed. A UDP server session is
+ * opened again once its peer is known.
+ */
+typedef struct capture_record_struct
+{
+    uint32_t length;
+    uint8_t type;
+    uint8_t flags;
+    uint16_t session;
+    uint64_t timestamp_ns;
+} capture_record;
+
+/* payload of a CAPTURE_OPEN record: the IPv4 endpoints in network
+   byte order, followed by the peer name */
+typedef struct capture_endpoints_struct
+{
+    uint32_t local_addr;
+    uint32_t peer_addr;
+    uint16_t local_port;
+    uint16_t peer_port;
+} capture_endpoints;
+
+/* function externs */
+extern int capture_open(char *);
+extern void capture_close();
+extern void capture_write(int, int, const unsigned char *, int);
+extern void capture_session(int, int, int, char *);
+extern uint64_t capture_clock_ns(int);
+extern unsigned char *capture_map_log(char *, size_t *);
+extern capture_record *capture_next(unsigned char *, size_t, size_t *);
+extern int capture_prepare_pending();
+extern void capture_prepare_step();
+
+/* data externs */
+extern int capturing;
+
+#endif
@@ -37,6 +37,8 @@ SOFTWARE.
 #define HOST_MAXLEN 256
 
 #define SWITCH_LISTEN_MASK 0x0001
+#define SWITCH_BATCH_MASK 0x0002
+#define SWITCH_CORK_MASK 0x0004
 
 typedef struct command_line_params_type
 {
@@ -56,6 +58,34 @@ typedef struct command_line_params_type
     int sock_out_format;
     int sock_in_format;
     int socket_type;
+    int frame_rate;
+    long long history_size;
+    char *output_file;
+    int io_backend;
+    int server_mode;
+    char *record_file;
+    char *pcapng_file;
+    char *convert_file;
+    char *replay_file;
+    double replay_speed;
+    int replay_session;
+    char *view_file;
+    char *diff_files[2];
+    int load_connections;
+    char *load_request;
+    char *load_delimiter;
+    int load_length;
+    int load_requests;
+    double duration;
+    int throughput;
+    int sndbuf;
+    int rcvbuf;
+    char *metrics_name;
+    int nodelay;
+    int quickack;
+    int notsent_lowat;
+    int keepalive;
+    int keepalive_params[3];
 } command_line_params;
 
 /* data externs */
@@ -27,26 +27,54 @@ SOFTWARE.
 #define __PINT_CURSES_H
 
 struct WINDOW;
+struct viewport_struct;
+
+#define DEFAULT_FRAME_RATE 30
+
+/* window masks for mark_dirty() */
+#define DIRTY_SOCK_IN 0x0001
+#define DIRTY_SOCK_OUT 0x0002
+#define DIRTY_INFO 0x0004
+#define DIRTY_FRAMES 0x0008
+#define DIRTY_STATS 0x0010
+#define DIRTY_ALL 0x001f
+
+/* rows of the stats pane below the info window: the traffic in and
+   out, and the TCP state of the connection */
+#define STATS_WND_ROWS 3
+
+/* least rows of the info window, frame included; on a short terminal
+   the stats pane gives up its rows, last ones first, to keep them */
+#define INFO_WND_MIN_ROWS 4
 
 /* function externs */
 extern void init_curses();
 extern void deinit_curses();
 extern void resize_curses();
 
-extern void write_info_wnd(char *);
-extern void write_sock_in_wnd(char *);
-extern void write_sock_out_wnd(char *);
+extern void set_frame_rate(int);
+extern void mark_dirty(int);
+extern long render_delay_usec();
+extern void render_frame();
+extern void flush_curses();
 
-extern void clear_sock_out_wnd();
-extern void clear_sock_in_wnd();
+extern void set_info_title(char *);
+extern void show_views(struct viewport_struct *, struct viewport_struct *, char *);
+extern void write_info_wnd(char *);
+extern void write_stats_wnd(int, char *);
 
 /* data externs */
 extern WINDOW *sock_in_wnd;
 extern WINDOW *sock_out_wnd;
 extern WINDOW *info_wnd;
+extern WINDOW *stats_wnd;
+
+extern struct viewport_struct *sock_in_view;
+extern struct viewport_struct *sock_out_view;
 
-extern int sock_inwnd_cols, sock_in_wnd_rows;
+extern int sock_in_wnd_cols, sock_in_wnd_rows;
 extern int sock_out_wnd_cols, sock_out_wnd_rows;
 extern int info_wnd_cols, info_wnd_rows;
+extern int stats_wnd_rows;
 
 #endif
@@ -0,0 +1,152 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_EVENTLOOP_H
+#define __PINT_EVENTLOOP_H
+
+/* event masks */
+#define EVENT_READ 0x01
+#define EVENT_WRITE 0x02
+
+/* maximum number of events fetched per wait */
+#define EVENT_MAX_EVENTS 64
+
+/* size of the buffer readers are fed from by the readiness backends */
+#define EVENT_READ_BUFFER_SIZE 65536
+
+/* datagrams the readiness backends read with a single recvmmsg(), and
+   the room for each: enough for the largest UDP datagram */
+#define EVENT_DATAGRAM_BATCH 32
+#define EVENT_DATAGRAM_SIZE 65536
+
+/* io_uring backend: ring size, and the provided buffers received data
+   is completed into. The buffer count must be a power of two, and a
+   buffer must hold the largest UDP datagram. */
+#define URING_ENTRIES 256
+#define URING_BUFFERS 32
+#define URING_BUFFER_SIZE 65536
+#define URING_BUFFER_GROUP 0
+
+/* kinds of event sources */
+enum EVENT_SOURCES
+{
+    EVENT_SOURCE_FD = 0,
+    EVENT_SOURCE_READER,
+    EVENT_SOURCE_SIGNAL,
+    EVENT_SOURCE_TIMER
+};
+
+/* I/O backends */
+enum IO_BACKENDS {IO_BACKEND_EPOLL=0, IO_BACKEND_SELECT, IO_BACKEND_URING};
+
+/* io_uring operations, encoded in the user data of submissions */
+enum URING_OPS {URING_OP_READ=0, URING_OP_POLL, URING_OP_CANCEL, URING_OP_POLL_WRITE};
+
+/*
+ * Event callback. For descriptors and timers, fd is the descriptor and
+ * events tells what it is ready for; for signals, fd is the signal
+ * number and events is 0.
+ */
+typedef void (*event_callback)(int fd, int events, void *data);
+
+/*
+ * Reader callback: n bytes were read from fd into buf. n is 0 at end
+ * of file and -1 on error, in which case errno tells the reason.
+ */
+typedef void (*event_reader)(int fd, unsigned char *buf, int n, void *data);
+
+/* datagrams is set for readers added with event_add_datagram_reader();
+   an empty datagram is not the end of file for them and is skipped */
+typedef struct event_handler_struct
+{
+    int source;
+    int events;
+    int polled;
+    int datagrams;
+    event_callback callback;
+    event_reader reader;
+    event_callback writer;
+    void *data;
+} event_handler;
+
+/* io_uring backend state of a descriptor. The generation is bumped
+   whenever the operations of the descriptor are cancelled, so that
+   their late completions can be told apart. armed and write_polling
+   tell whether the read side and the writability poll of a reader are
+   queued. */
+typedef struct uring_fd_state_struct
+{
+    unsigned int gen;
+    int is_socket;
+    int multishot;
+    int waiting;
+    int armed;
+    int write_polling;
+} uring_fd_state;
+
+/*
+ * An I/O backend watches the registered descriptors. wait() waits for
+ * activity (without blocking if timeout is 0) and reports it through
+ * event_dispatch() or event_deliver().
+ */
+typedef struct event_backend_struct
+{
+    char name[8];
+    int (*init)();
+    void (*deinit)();
+    int (*add)(int);
+    int (*modify)(int);
+    void (*remove)(int);
+    int (*wait)(int);
+} event_backend;
+
+/* function externs */
+extern int event_loop_init(int);
+extern void event_loop_deinit();
+extern char *event_backend_name();
+extern int event_add(int, int, event_callback, void *);
+extern int event_add_reader(int, event_reader, void *);
+extern int event_add_datagram_reader(int, event_reader, void *);
+extern int event_modify(int, int);
+extern int event_set_writer(int, event_callback);
+extern void event_remove(int);
+extern int event_add_signal(int, event_callback, void *);
+extern int event_add_timer(event_callback, void *);
+extern int event_set_timer(int, long);
+extern void event_set_prepare(void (*)());
+extern void event_set_idle(int (*)(), void (*)());
+extern void event_loop_run();
+extern void event_loop_stop();
+extern void event_dispatch(int, int);
+extern void event_deliver(int, unsigned char *, int);
+
+/* data externs */
+extern event_handler *event_handlers;
+extern int num_event_handlers;
+extern event_backend select_backend;
+extern event_backend epoll_backend;
+extern event_backend uring_backend;
+
+#endif
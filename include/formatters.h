@@ -35,16 +35,38 @@ enum formatters
   FORMATTER_HEX
 };
 
+/* widest cell produced by any formatter, and the number of bytes a
+   formatter may write past its last cell (including the terminator) */
+#define MAX_CELL_WIDTH 6
+#define FORMAT_SLACK 8
+
+/* size of an output buffer able to hold len formatted bytes */
+#define FORMAT_BUFFER_SIZE(len) ((len) * MAX_CELL_WIDTH + FORMAT_SLACK)
+
+/*
+ * A display format turns a buffer of raw bytes into a string of cells,
+ * cell_width characters per byte. The text format is the exception:
+ * it may drop bytes and emit linefeeds, so its cells are at most one
+ * character wide. The formatter returns the number of characters
+ * written and terminates the output with '\0'.
+ */
 typedef struct display_format_struct
 {
-  char pattern[32];
-  void (*formatter)(char *, int, char *);
+  char name[16];
+  int cell_width;
+  int (*formatter)(const unsigned char *, int, char *);
 } display_format;
 
 /* data externs */
 extern display_format *sock_out_format, *sock_in_format;
+extern display_format display_formats[];
 
 /* function externs */
-extern void wide_formatter(char *, int, char *);
+extern void init_formatters();
+extern int next_format_type(display_format *);
+extern int isprintable(int);
+extern int wide_formatter(const unsigned char *, int, char *);
+extern int text_formatter(const unsigned char *, int, char *);
+extern int hex_formatter(const unsigned char *, int, char *);
 
 #endif
@@ -0,0 +1,58 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_HISTOGRAM_H
+#define __PINT_HISTOGRAM_H
+
+/*
+ * Log-linear histogram of latencies in nanoseconds, in the manner of
+ * HdrHistogram: values below HISTOGRAM_SUB_COUNT are counted exactly,
+ * larger ones in buckets of HISTOGRAM_SUB_COUNT / 2 per power of two,
+ * so that a bucket is never wider than 1 / 128 of its values.
+ */
+#define HISTOGRAM_SUB_BITS 8
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 2) * (HISTOGRAM_SUB_COUNT / 2))
+
+typedef struct histogram_struct
+{
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+} histogram;
+
+/* function externs */
+extern void histogram_reset(histogram *);
+extern void histogram_record(histogram *, uint64_t);
+extern void histogram_add(histogram *, histogram *);
+extern uint64_t histogram_percentile(histogram *, double);
+extern uint64_t histogram_count_below(histogram *, uint64_t);
+extern int histogram_index(uint64_t);
+extern uint64_t histogram_bucket_start(int);
+extern void format_latency(uint64_t, char *);
+
+#endif
@@ -0,0 +1,123 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_HISTORY_H
+#define __PINT_HISTORY_H
+
+#define HISTORY_CHUNK_SIZE 65536
+#define HISTORY_BITMAP_WORDS (HISTORY_CHUNK_SIZE / 64)
+#define HISTORY_BITMAP_SIZE (HISTORY_BITMAP_WORDS * sizeof(unsigned long long))
+#define DEFAULT_HISTORY_SIZE (64LL * 1024 * 1024)
+
+/* newest chunks that are never compressed */
+#define HISTORY_HOT_CHUNKS 4
+
+/* decompressed chunks kept around for the viewport */
+#define HISTORY_CACHE_SIZE 4
+
+/* slots the datagram index starts with; it grows up to an eighth of
+   the budget, after which the oldest datagrams are forgotten */
+#define HISTORY_MIN_RECORDS 1024
+
+/*
+ * History of the bytes sent or received, kept as a ring of fixed-size
+ * chunks. Offsets are absolute stream positions counted from the start
+ * of the connection; chunk n always holds the bytes at offsets
+ * [n * HISTORY_CHUNK_SIZE, (n + 1) * HISTORY_CHUNK_SIZE).
+ *
+ * Each raw chunk also keeps a bitmap of its linefeeds so that line
+ * starts can be found without scanning the data.
+ *
+ * Chunks older than the HISTORY_HOT_CHUNKS newest ones are compressed
+ * by history_compress_step(), which the main loop calls when idle.
+ * A compressed chunk is only unpacked, into a small cache, when it is
+ * read. When the resident memory would exceed the budget, the oldest
+ * chunks are dropped.
+ */
+typedef struct history_chunk_struct
+{
+    unsigned char *data;          /* raw bytes, NULL if compressed */
+    unsigned long long *newlines; /* linefeed bitmap of raw bytes */
+    unsigned char *packed;        /* compressed bytes */
+    int packed_len;
+    long long newline_before; /* last linefeed before the chunk, or -1 */
+} history_chunk;
+
+/*
+ * A datagram kept in a history: where its bytes start, how many there
+ * are, and when it arrived or was sent (CLOCK_REALTIME, in ns).
+ */
+typedef struct history_record_struct
+{
+    long long offset;
+    int len;
+    unsigned long long ns;
+} history_record;
+
+typedef struct history_cache_struct
+{
+    long long chunk_no; /* -1 if unused */
+    unsigned char *data;
+    unsigned long long *newlines;
+    unsigned int last_used;
+} history_cache;
+
+typedef struct history_struct
+{
+    history_chunk *chunks;
+    int num_slots;
+    long long budget;
+    long long start;        /* offset of the oldest byte still kept */
+    long long end;          /* offset one past the newest byte */
+    long long last_newline; /* offset of the newest linefeed, or -1 */
+
+    long long resident;     /* bytes of chunk and cache memory in use */
+    long long packed_raw;   /* raw size of the compressed chunks */
+    long long packed_bytes; /* their compressed size */
+    long long next_pack;    /* next chunk to try to compress */
+
+    history_cache cache[HISTORY_CACHE_SIZE];
+    unsigned int cache_clock;
+
+    /* ring of the datagrams whose bytes are kept, oldest first; the
+       number of slots is a power of two */
+    history_record *records;
+    int records_size;
+    int records_first;
+    int num_records;
+} history;
+
+/* function externs */
+extern history *history_create(long long);
+extern void history_destroy(history *);
+extern void history_append(history *, const unsigned char *, int);
+extern void history_append_record(history *, const unsigned char *, int, unsigned long long);
+extern history_record *history_find_record(history *, long long);
+extern int history_read(history *, long long, unsigned char *, int);
+extern long long history_prev_newline(history *, long long);
+extern int history_compress_pending(history *);
+extern void history_compress_step(history *);
+
+#endif
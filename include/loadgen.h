@@ -0,0 +1,97 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_LOADGEN_H
+#define __PINT_LOADGEN_H
+
+/* size of the buffer responses are read into */
+#define LOAD_BUFFER_SIZE (64 * 1024)
+
+/* interval of the load reports, in microseconds */
+#define LOAD_REPORT_INTERVAL 1000000
+
+/* how long a UDP request waits for its response before it is counted
+   as lost and sent again, in nanoseconds */
+#define LOAD_UDP_TIMEOUT 1000000000ULL
+
+/* longest response delimiter */
+#define LOAD_DELIMITER_SIZE 64
+
+/* failed connections are reported one by one up to this many */
+#define LOAD_REPORT_FAILURES 8
+
+enum LOAD_CONN_STATES
+{
+    LOAD_CONNECTING = 0,
+    LOAD_SENDING,
+    LOAD_WAITING
+};
+
+/*
+ * What to send and how to tell where a response ends. A response is
+ * length bytes long if length is not 0, otherwise it ends with the
+ * delimiter; with neither, a UDP response is one datagram and a TCP
+ * one ends with a linefeed. The request and delimiter are in the
+ * escaped input syntax.
+ */
+typedef struct load_params_struct
+{
+    int connections;
+    char *request;
+    char *delimiter;
+    int length;
+    long long max_requests;
+    double duration;
+} load_params;
+
+/*
+ * A connection of the load generator. It sends a request, waits for
+ * the response, and sends the next one.
+ */
+typedef struct load_conn_struct
+{
+    int id;
+    int sockfd;
+    int state;
+    int writing;
+    int sent;
+    int received;
+    int matched;
+    uint64_t sent_ns;
+    long long requests;
+} load_conn;
+
+/* function externs */
+extern int load_open(char *, int, load_params *);
+extern int load_start();
+extern void load_stop();
+extern int load_print_report();
+
+/* data externs */
+extern int load_mode;
+extern histogram load_interval;
+extern histogram load_total;
+
+#endif
@@ -0,0 +1,43 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_LZ_H
+#define __PINT_LZ_H
+
+/*
+ * Small LZ77 codec for history chunks. A block is a series of
+ * sequences: a token byte with the literal count in the high nibble
+ * and the match length - LZ_MIN_MATCH in the low nibble (15 meaning
+ * more length bytes follow, each adding up to 255), the literals, and
+ * a 16-bit little-endian match offset. The last sequence has no match.
+ */
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+
+/* function externs */
+extern int lz_compress(const unsigned char *, int, unsigned char *, int);
+extern int lz_decompress(const unsigned char *, int, unsigned char *, int);
+
+#endif
@@ -0,0 +1,97 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_METRICS_H
+#define __PINT_METRICS_H
+
+/* where a segment named without a directory goes */
+#define METRICS_DIR "/dev/shm/"
+
+/* "PINT" in the byte order of the host, and the layout version; a
+   reader rejects a segment with either one unknown */
+#define METRICS_MAGIC 0x544e4950
+#define METRICS_VERSION 1
+
+/* how often the segment is updated, in microseconds */
+#define METRICS_INTERVAL 1000000
+
+/* sessions listed in the segment; any others are only counted */
+#define METRICS_MAX_SESSIONS 64
+#define METRICS_NAME_SIZE 64
+#define METRICS_MODE_SIZE 16
+
+/* latency bucket i counts the latencies under 2^i microseconds not
+   counted in the buckets before it; the last one counts the rest */
+#define METRICS_LATENCY_BUCKETS 24
+
+enum METRICS_SESSION_STATES {METRICS_SESSION_CLOSED=0, METRICS_SESSION_OPEN};
+
+typedef struct metrics_session_struct
+{
+    int32_t id;
+    int32_t state;
+    char name[METRICS_NAME_SIZE];
+    int64_t bytes_in;
+    int64_t bytes_out;
+    int64_t queued;
+} metrics_session;
+
+/*
+ * The segment, a file mapped by pint and by its readers. pint makes
+ * the sequence odd before it changes anything and even again after,
+ * so a reader copies the segment and retries if the sequence was odd
+ * or changed meanwhile. The fields before the sequence never change.
+ */
+typedef struct metrics_segment_struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    int32_t pid;
+    uint64_t sequence;
+    uint64_t started_ns;
+    uint64_t updated_ns;
+    char mode[METRICS_MODE_SIZE];
+    int64_t bytes_in;
+    int64_t bytes_out;
+    int64_t reads;
+    int64_t sends;
+    int64_t errors;
+    int64_t queued;
+    int64_t latency_count;
+    int64_t latency_sum_ns;
+    int64_t latency_buckets[METRICS_LATENCY_BUCKETS];
+    int32_t num_sessions;
+    int32_t listed_sessions;
+    metrics_session sessions[METRICS_MAX_SESSIONS];
+} metrics_segment;
+
+/* function externs */
+extern int metrics_open(char *);
+extern int metrics_start();
+extern void metrics_tick(int);
+extern void metrics_close();
+
+#endif
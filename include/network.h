@@ -26,6 +26,11 @@ SOFTWARE.
 #ifndef __PINT_NETWORK_H
 #define __PINT_NETWORK_H
 
+/* pending connections queued by the kernel for a TCP server socket */
+#define LISTEN_BACKLOG 128
+
+struct sockaddr_in;
+
 enum SOCKET_TYPES
 {
 	SOCKTYPE_TCP = 0,
@@ -35,11 +40,28 @@ enum SOCKET_TYPES
 
 /* data externs */
 extern char *socket_type_names[];
+extern int socket_sndbuf;
+extern int socket_rcvbuf;
+extern int socket_nodelay;
+extern int socket_quickack;
+extern int socket_notsent_lowat;
+extern int socket_keepalive;
+extern int socket_keepidle;
+extern int socket_keepintvl;
+extern int socket_keepcnt;
 
 /* function externs */
 extern int set_nonblocking(int);
+extern int set_socket_buffers(int);
+extern int set_tcp_options(int);
+extern void renew_quickack(int);
+extern int resolve_remote_host(char *, int, struct sockaddr_in *);
+extern int start_connect(struct sockaddr_in *);
 extern int connect_to_remote_host(char *, int);
 extern int create_server_socket(int);
 extern int accept_incoming_connection(int);
+extern int accept_pending_connection(int);
+extern int accept_udp_peer(int, unsigned char *, int);
+extern void get_peer_name(int, char *, int);
 
 #endif
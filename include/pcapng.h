@@ -0,0 +1,85 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef __PINT_PCAPNG_H
+#define __PINT_PCAPNG_H
+
+/* pcapng block types, and the byte order magic of a section */
+#define PCAPNG_SECTION_HEADER 0x0A0D0D0A
+#define PCAPNG_INTERFACE_DESCRIPTION 0x00000001
+#define PCAPNG_ENHANCED_PACKET 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+
+/* the interface option telling that timestamps are in nanoseconds */
+#define PCAPNG_OPTION_TSRESOL 9
+#define PCAPNG_TSRESOL_NANOSECONDS 9
+
+#define PCAPNG_LINKTYPE_ETHERNET 1
+
+/* output is written in blocks of this size */
+#define PCAPNG_BUFFER_SIZE (1024 * 1024)
+
+/* most payload in a synthesized packet: a bigger chunk of a TCP stream
+   is cut into segments, like TSO would */
+#define PCAPNG_SEGMENT_SIZE 65000
+
+/* sizes of the synthesized headers */
+#define PCAPNG_ETHERNET_SIZE 14
+#define PCAPNG_IP_SIZE 20
+#define PCAPNG_TCP_SIZE 20
+#define PCAPNG_UDP_SIZE 8
+
+/* TCP flags */
+#define PCAPNG_TCP_FIN 0x01
+#define PCAPNG_TCP_SYN 0x02
+#define PCAPNG_TCP_PSH 0x08
+#define PCAPNG_TCP_ACK 0x10
+
+/*
+ * A session as a flow of packets. Sequence numbers are the next ones
+ * each end sends.
+ */
+typedef struct pcapng_flow_struct
+{
+    uint32_t local_addr;
+    uint32_t peer_addr;
+    uint16_t local_port;
+    uint16_t peer_port;
+    uint32_t local_seq;
+    uint32_t peer_seq;
+    uint16_t ip_id;
+    int udp;
+    int open;
+} pcapng_flow;
+
+/* function externs */
+extern int pcapng_open(char *, uint64_t, uint64_t);
+extern void pcapng_write(capture_record *, const unsigned char *);
+extern void pcapng_close();
+extern int pcapng_convert(char *, char *);
+
+/* data externs */
+extern int pcapng_writing;
+
+#endif
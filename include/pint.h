@@ -26,27 +26,53 @@ SOFTWARE.
 #ifndef __PINT_H
 #define __PINT_H
 
+struct timeval;
+
 #define STDIN_INPUT_BUFFER_SIZE 4096
 #define READ_BUFFER_SIZE 4096
 #define ESCAPE_CHARS_BUFFER_SIZE 16
 
-#define SOCK_IN_BUFFER_SIZE 10000
-#define SOCK_OUT_BUFFER_SIZE 10000
+/* most \f{path} escapes on a line, and the longest path */
+#define STDIN_MAX_FILES 8
+#define STDIN_FILE_PATH_SIZE 256
+
 
 enum INPUT_ESCAPE_MODES
 {
 	ESCAPE_MODE_INACTIVE = 0,
 	ESCAPE_MODE_STARTED,
 	ESCAPE_MODE_HEX_STARTED,
-	ESCAPE_MODE_HEX_1READ
+	ESCAPE_MODE_HEX_1READ,
+	ESCAPE_MODE_FILE_STARTED,
+	ESCAPE_MODE_FILE_PATH
 };
 
+/* a \f{path} escape: the file goes after the first at bytes of the
+   translated line */
+typedef struct file_escape_struct
+{
+	int at;
+	char path[STDIN_FILE_PATH_SIZE];
+} file_escape;
+
 enum ENTER_BEHAVIOUR_MODES
 {
 	ENTER_SENDS_CRLF = 0,
 	ENTER_SENDS_NOTHING
 };
 
+enum DIRECTIONS
+{
+	DIRECTION_IN = 0,
+	DIRECTION_OUT
+};
+
+enum SCROLL_TARGETS
+{
+	SCROLL_SOCK_IN = 0,
+	SCROLL_SOCK_OUT
+};
+
 enum STDIN_INPUT_INTERPRETATION_MODES
 {
 	STDIN_INTERP_PLAIN_TEXT = 0,
@@ -61,6 +87,9 @@ extern int socket_type;
 
 /* function prototypes */
 extern void finish(int sig);
-extern void resize(int sig);
+extern void format_size(long long, char *);
+extern long long usec_since(struct timeval *);
+extern void format_rate(long long, long long, char *);
+extern int translate_escapes(unsigned char *, int, unsigned char *, file_escape *, int *);
 
 #endif
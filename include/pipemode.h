@@ -0,0 +1,65 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_PIPEMODE_H
+#define __PINT_PIPEMODE_H
+
+/* requested size of the kernel pipes used for splicing */
+#define PIPE_MODE_PIPE_SIZE (1024 * 1024)
+
+/* largest payload sent in a single UDP datagram */
+#define PIPE_MODE_DATAGRAM_SIZE 65507
+
+/* ways of moving data from one descriptor to another */
+enum PIPE_TRANSFERS {PIPE_TRANSFER_SPLICE=0, PIPE_TRANSFER_COPY};
+
+/* one direction of the relay: in_fd -> (kernel pipe | buffer) -> out_fd.
+   datagrams is set when in_fd is a datagram socket, where reading 0
+   bytes means an empty datagram instead of the end of input */
+typedef struct pipe_stream_struct
+{
+    int in_fd;
+    int out_fd;
+    int transfer;
+    int pipe_fds[2];
+    unsigned char *buf;
+    int buf_off;
+    int capacity;
+    int pending;
+    int in_open;
+    int datagrams;
+    int accept_peer;
+    stats_direction *read_stats;
+    stats_direction *write_stats;
+} pipe_stream;
+
+/* function externs */
+extern int detect_pipe_mode();
+extern int handle_pipe_connection(int, int);
+
+/* data externs */
+extern int pipe_mode;
+
+#endif
@@ -0,0 +1,57 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef __PINT_REPLAY_H
+#define __PINT_REPLAY_H
+
+/* after the last message, how long the response may pause before the
+   replay ends: a short while once the whole recorded response has
+   arrived, longer while some of it is missing. In microseconds. */
+#define REPLAY_LINGER 250000
+#define REPLAY_TIMEOUT 5000000
+
+/* bytes shown around a divergence, and the divergences shown */
+#define REPLAY_DIFF_CONTEXT 16
+#define REPLAY_MAX_REPORTS 10
+
+/*
+ * A chunk of a recorded session, pointing into the mapped capture.
+ * at_ns is its time since the session started.
+ */
+typedef struct replay_chunk_struct
+{
+    const unsigned char *data;
+    int len;
+    unsigned long long at_ns;
+} replay_chunk;
+
+/* function externs */
+extern int replay_open(char *, int);
+extern int replay_start(int, double);
+extern int replay_finish();
+
+/* data externs */
+extern int replay_mode;
+
+#endif
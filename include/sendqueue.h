@@ -0,0 +1,111 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef __PINT_SENDQUEUE_H
+#define __PINT_SENDQUEUE_H
+
+#include <sys/time.h>
+
+/* most buffers handed to a single writev() or sendmmsg() */
+#define SEND_QUEUE_MAX_IOV 64
+
+/* most bytes a queue holds; more is refused */
+#define SEND_QUEUE_LIMIT (64 * 1024 * 1024)
+
+/* most bytes of a queued file handed to a single sendfile() */
+#define SEND_FILE_CHUNK (16 * 1024 * 1024)
+
+#define SEND_FILE_NAME_SIZE 256
+
+/* above this many queued bytes, batch mode stops reading stdin until
+   the queue has drained */
+#define SEND_QUEUE_HIGH_WATER (1024 * 1024)
+
+/*
+ * A file queued for sending. It goes from the page cache to the
+ * socket with sendfile(); the mapping is only read for the checksum.
+ */
+typedef struct send_file_struct
+{
+    int fd;
+    long long size;
+    long long sent;
+    unsigned char *map;
+    unsigned int crc;
+    struct timeval started;
+    char name[SEND_FILE_NAME_SIZE];
+} send_file;
+
+/*
+ * A buffer waiting to be sent; off bytes of it are already gone. A
+ * buffer with a file has no data of its own.
+ */
+typedef struct send_buffer_struct
+{
+    struct send_buffer_struct *next;
+    int len;
+    int off;
+    unsigned char *data;
+    send_file *file;
+} send_buffer;
+
+/*
+ * Called with the bytes a drain wrote, in order. For a file, from_file
+ * is set and buf points into its mapping, or is NULL without one.
+ */
+typedef void (*send_written)(unsigned char *buf, int n, int from_file, void *data);
+
+/*
+ * Called when the last byte of a queued file has been written.
+ */
+typedef void (*send_file_sent)(send_file *file, void *data);
+
+/*
+ * Outbound bytes of a connection. A stream queue is drained with
+ * writev(); a datagram queue sends each buffer as a datagram of its
+ * own, a batch of them per sendmmsg(). A corked stream queue keeps
+ * TCP_CORK set while it holds data, so that only full segments leave
+ * until it has drained.
+ */
+typedef struct send_queue_struct
+{
+    send_buffer *head;
+    send_buffer *tail;
+    int buffers;
+    long long bytes;
+    long long peak_bytes;
+    int datagrams;
+    int cork;
+    int corked;
+} send_queue;
+
+/* function externs */
+extern void send_queue_init(send_queue *, int, int);
+extern int send_queue_push(send_queue *, unsigned char *, int);
+extern int send_queue_push_file(send_queue *, char *);
+extern void send_queue_rollback(send_queue *, send_buffer *);
+extern long long send_queue_drain(send_queue *, int, send_written, send_file_sent, void *);
+extern void send_queue_clear(send_queue *);
+
+#endif
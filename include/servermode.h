@@ -0,0 +1,94 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef __PINT_SERVERMODE_H
+#define __PINT_SERVERMODE_H
+
+/* size of the buffer connections are read into; echo keeps at most
+   this much of unsent data per connection */
+#define SERVER_BUFFER_SIZE (256 * 1024)
+
+/* interval of the throughput reports, in microseconds */
+#define SERVER_REPORT_INTERVAL 1000000
+
+/* connections are reported one by one up to this many */
+#define SERVER_REPORT_CONNECTIONS 8
+
+/* most bytes a sink discards per read */
+#define SINK_DISCARD_SIZE (4 * 1024 * 1024)
+
+/* most datagrams read from a UDP socket per readiness event */
+#define SERVER_DATAGRAMS_PER_EVENT 64
+
+/* the RFC 864 character generator pattern: lines of 72 printable
+   characters, each starting one character further */
+#define CHARGEN_LINE_LENGTH 72
+#define CHARGEN_LINES 95
+#define CHARGEN_DATAGRAM_MAX 512
+#define CHARGEN_PATTERN_SIZE (CHARGEN_LINES * (CHARGEN_LINE_LENGTH + 2))
+
+#define SERVER_CONN_NAME_SIZE 64
+
+enum SERVER_MODES
+{
+    SERVER_MODE_NONE = 0,
+    SERVER_MODE_ECHO,
+    SERVER_MODE_DISCARD,
+    SERVER_MODE_CHARGEN,
+    SERVER_MODE_SINK
+};
+
+/*
+ * A client of a server mode. For UDP there is a single one, standing
+ * for the server socket.
+ */
+typedef struct server_conn_struct
+{
+    int id;
+    int sockfd;
+    char name[SERVER_CONN_NAME_SIZE];
+    unsigned char *pending;
+    int pending_off;
+    int pending_len;
+    int in_open;
+    long chargen_off;
+    long long bytes_in;
+    long long bytes_out;
+    long long reported_in;
+    long long reported_out;
+    struct timeval started;
+} server_conn;
+
+/* function externs */
+extern int parse_server_mode(char *);
+extern char *server_mode_name(int);
+extern int server_mode_start(int, int);
+extern void server_mode_stop();
+
+/* data externs */
+extern int server_mode;
+extern server_conn **server_conns;
+extern int num_server_conns;
+
+#endif
@@ -0,0 +1,68 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_SESSION_H
+#define __PINT_SESSION_H
+
+#define SESSION_NAME_SIZE 64
+
+/*
+ * A connection and everything shown or typed for it: the histories
+ * and views of both directions, the line being typed, the bytes
+ * waiting to be sent and the byte counters.
+ */
+typedef struct session_struct
+{
+    int id;
+    int sockfd;
+    int open;
+    int udp_peer_known;
+    char name[SESSION_NAME_SIZE];
+    history *in_history;
+    history *out_history;
+    viewport in_view;
+    viewport out_view;
+    unsigned char stdin_input_buffer[STDIN_INPUT_BUFFER_SIZE];
+    int stdin_bytes_read;
+    long long bytes_in;
+    long long bytes_out;
+    send_queue queue;
+    int shutdown_pending;
+} session;
+
+/* function externs */
+extern session *session_create(int, long long, int);
+extern void session_close(session *);
+extern void session_destroy(session *);
+extern int session_register(session *);
+extern session *session_following(session *);
+extern void destroy_sessions();
+
+/* data externs */
+extern session **sessions;
+extern int num_sessions;
+extern session *active_session;
+
+#endif
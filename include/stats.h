@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_STATS_H
+#define __PINT_STATS_H
+
+/* interval of the samples the rates are computed from, and how many
+   are kept: enough for the longest window */
+#define STATS_INTERVAL 1000000
+#define STATS_SAMPLES 61
+
+/*
+ * Traffic in one direction: the running totals, counted on the hot
+ * path, and the totals sampled once per STATS_INTERVAL, the rates of
+ * the last 1, 10 and 60 seconds being differences of two samples.
+ */
+typedef struct stats_sample_struct
+{
+    uint64_t ns;
+    long long bytes;
+    long long calls;
+} stats_sample;
+
+typedef struct stats_direction_struct
+{
+    long long bytes;
+    long long calls;
+    stats_sample samples[STATS_SAMPLES];
+    uint64_t active_ns;
+} stats_direction;
+
+/* function externs */
+extern void stats_count(stats_direction *, int);
+extern int stats_start();
+
+/* data externs */
+extern stats_direction stats_in;
+extern stats_direction stats_out;
+extern long long stats_errors;
+
+#endif
@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_THROUGHPUT_H
+#define __PINT_THROUGHPUT_H
+
+/* size of the buffer sent over and over, and of the one received into */
+#define THROUGHPUT_BUFFER_SIZE (256 * 1024)
+
+/* sends or receives done per wakeup, so that the timers get their turn */
+#define THROUGHPUT_BURST 16
+
+/* interval of the goodput reports, in microseconds */
+#define THROUGHPUT_REPORT_INTERVAL 1000000
+
+/* how long the sender sends if -duration is not given, in seconds */
+#define THROUGHPUT_DEFAULT_DURATION 10
+
+/* how long the sender waits for the receiver to close the connection
+   once everything is sent, in microseconds */
+#define THROUGHPUT_DRAIN_USEC 10000000
+
+enum THROUGHPUT_STATES
+{
+    THROUGHPUT_SENDING = 0,
+    THROUGHPUT_DRAINING,
+    THROUGHPUT_RECEIVING,
+    THROUGHPUT_DONE
+};
+
+/* function externs */
+extern void throughput_open(int, int, double);
+extern int throughput_start();
+extern void throughput_stop();
+extern int throughput_print_report();
+
+/* data externs */
+extern int throughput_mode;
+extern int throughput_sockfd;
+
+#endif
@@ -0,0 +1,81 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef __PINT_VIEWER_H
+#define __PINT_VIEWER_H
+
+/* a session gets an index entry at its first record past this many
+   bytes of the log from its previous entry, so that finding any of its
+   bytes walks at most about this much of the log */
+#define VIEW_INDEX_SPAN (64 * 1024)
+
+/* sessions shown have a history of this size, which stays empty */
+#define VIEW_HISTORY_SIZE (64 * 1024)
+
+/* an index entry that has not been told its last linefeed yet */
+#define VIEW_NEWLINE_UNKNOWN -2
+
+/* a record of a session, how far its streams had got before it, and
+   their last linefeeds before it, found when first needed */
+typedef struct view_index_entry_struct
+{
+    long long file_off;
+    long long in_off;
+    long long out_off;
+    long long in_nl;
+    long long out_nl;
+    unsigned long long ts_ns;
+} view_index_entry;
+
+struct view_session_struct;
+
+/* one direction of a recorded session, as a viewport source */
+typedef struct view_stream_struct
+{
+    struct view_session_struct *vs;
+    int type;
+    long long bytes;
+} view_stream;
+
+typedef struct view_session_struct
+{
+    int id;
+    char name[64];
+    unsigned long long opened_ns;
+    view_index_entry *index;
+    int num_index;
+    int index_size;
+    view_stream in;
+    view_stream out;
+} view_session;
+
+/* function externs */
+extern int view_open(char *);
+extern void view_close();
+extern void view_command(viewport *, viewport *, char *, int);
+
+/* data externs */
+extern int view_mode;
+
+#endif
@@ -0,0 +1,80 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __PINT_VIEWPORT_H
+#define __PINT_VIEWPORT_H
+
+#define VIEWPORT_MAX_COLS 1024
+
+/* width of the label a datagram is shown with: its arrival time, to
+   the millisecond, and its length */
+#define VIEWPORT_LABEL_WIDTH 19
+
+/*
+ * Byte stream shown by a viewport. Offsets are absolute stream
+ * positions; prev_newline() returns the offset of the last linefeed
+ * before the given offset or -1 if there is none. A stream of
+ * datagrams also has find_record(), as history_find_record(); others
+ * leave it NULL.
+ */
+typedef struct view_source_struct
+{
+    void *ctx;
+    long long (*start)(void *);
+    long long (*end)(void *);
+    int (*read)(void *, long long, unsigned char *, int);
+    long long (*prev_newline)(void *, long long);
+    history_record *(*find_record)(void *, long long);
+} view_source;
+
+/*
+ * A window onto a byte stream. Only the visible lines are ever
+ * formatted: line starts are computed on demand for the current
+ * format and window width. Fixed-width formats break lines every
+ * cols / cell_width bytes counted from offset 0, the text format
+ * after each linefeed and every cols bytes within a line. In a stream
+ * of datagrams each datagram starts a line, its first one labeled,
+ * and the lines of fixed-width formats are counted from its start.
+ */
+typedef struct viewport_struct
+{
+    view_source source;
+    display_format *format;
+    int rows, cols;
+    long long top; /* offset of the first visible line when not following */
+    int follow;    /* TRUE if the newest bytes are kept on screen */
+} viewport;
+
+/* function externs */
+extern void viewport_init(viewport *, view_source *, display_format *);
+extern void viewport_set_history(viewport *, history *, display_format *, int);
+extern long long viewport_line_start(viewport *, long long);
+extern long long viewport_next_line(viewport *, long long);
+extern long long viewport_prev_line(viewport *, long long);
+extern void viewport_scroll(viewport *, int);
+extern void viewport_jump(viewport *, long long);
+extern void viewport_render(viewport *, WINDOW *);
+
+#endif
@@ -0,0 +1,244 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <asm/errno.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/formatters.h"
+#include "../include/batch.h"
+
+/* TRUE when running headless */
+int batch_mode = FALSE;
+
+/* output descriptor and buffer */
+int batch_fd = -1;
+char batch_buffer[BATCH_BUFFER_SIZE];
+int batch_used = 0;
+
+/* direction tags */
+char *batch_prefixes[] = {"<< ", ">> "};
+
+/*
+ * Opens the batch output: the given file, or stdout if path is NULL.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int batch_open(char *path)
+{
+    if (path == NULL)
+    {
+        batch_fd = STDOUT_FILENO;
+    }
+    else
+    {
+        batch_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (batch_fd == -1)
+        {
+            printf("Couldn't open %s (%s)\n", path, strerror(errno));
+            return -1;
+        }
+    }
+
+    batch_used = 0;
+    batch_mode = TRUE;
+
+    return 0;
+}
+
+/*
+ * Flushes and closes the batch output.
+ */
+void batch_close()
+{
+    if (batch_fd == -1)
+    {
+        return;
+    }
+
+    batch_flush();
+
+    if (batch_fd != STDOUT_FILENO)
+    {
+        close(batch_fd);
+    }
+    batch_fd = -1;
+}
+
+/*
+ * Writes out everything buffered. Waits for the descriptor if it is
+ * non-blocking and full.
+ */
+void batch_flush()
+{
+    struct pollfd pfd;
+    ssize_t n;
+    int done;
+
+    for (done = 0; done < batch_used; done += n)
+    {
+        n = write(batch_fd, batch_buffer + done, batch_used - done);
+        if (n < 0)
+        {
+            if (errno == EAGAIN)
+            {
+                pfd.fd = batch_fd;
+                pfd.events = POLLOUT;
+                poll(&pfd, 1, -1);
+                n = 0;
+                continue;
+            }
+
+            if (errno == EINTR)
+            {
+                n = 0;
+                continue;
+            }
+
+            fprintf(stderr, "Error writing batch output (%s)\n", strerror(errno));
+            finish(-1);
+        }
+    }
+
+    batch_used = 0;
+}
+
+/*
+ * Returns TRUE if there is buffered output.
+ */
+int batch_pending()
+{
+    return batch_used > 0;
+}
+
+/*
+ * Makes room for at least len more bytes in the buffer.
+ */
+static void reserve(int len)
+{
+    if (batch_used + len > BATCH_BUFFER_SIZE)
+    {
+        batch_flush();
+    }
+}
+
+/*
+ * Appends a string to the buffer.
+ */
+static void put(const char *s, int len)
+{
+    memcpy(batch_buffer + batch_used, s, len);
+    batch_used += len;
+}
+
+/*
+ * Writes bytes as text lines; every line gets the direction tag.
+ */
+static void write_text(char *prefix, display_format *format,
+                       const unsigned char *buf, int len)
+{
+    static char cells[FORMAT_BUFFER_SIZE(BATCH_BYTES_PER_LINE * 256)];
+    char *p, *end, *nl;
+    int n, cells_len, at_line_start;
+
+    at_line_start = TRUE;
+
+    for (; len > 0; buf += n, len -= n)
+    {
+        n = (len < BATCH_BYTES_PER_LINE * 256) ? len : BATCH_BYTES_PER_LINE * 256;
+        cells_len = format->formatter(buf, n, cells);
+
+        for (p = cells, end = cells + cells_len; p < end; p = nl)
+        {
+            nl = memchr(p, '\n', end - p);
+            nl = (nl != NULL) ? nl + 1 : end;
+
+            reserve(3 + (nl - p) + 1);
+            if (at_line_start)
+            {
+                put(prefix, 3);
+            }
+            put(p, nl - p);
+            at_line_start = (nl[-1] == '\n');
+        }
+    }
+
+    if (!at_line_start)
+    {
+        reserve(1);
+        put("\n", 1);
+    }
+}
+
+/*
+ * Writes a chunk of bytes sent or received (direction is DIRECTION_IN
+ * or DIRECTION_OUT) in the format of the corresponding window. Each
+ * chunk starts on a new line.
+ */
+void batch_write(int direction, const unsigned char *buf, int len)
+{
+    display_format *format;
+    char *prefix;
+    int n, cells_len;
+
+    format = (direction == DIRECTION_IN) ? sock_in_format : sock_out_format;
+    prefix = batch_prefixes[direction];
+
+    if (format->formatter == text_formatter)
+    {
+        write_text(prefix, format, buf, len);
+        return;
+    }
+
+    /* fixed-width formats: BATCH_BYTES_PER_LINE bytes per line */
+    for (; len > 0; buf += n, len -= n)
+    {
+        n = (len < BATCH_BYTES_PER_LINE) ? len : BATCH_BYTES_PER_LINE;
+
+        reserve(3 + FORMAT_BUFFER_SIZE(BATCH_BYTES_PER_LINE));
+        put(prefix, 3);
+        cells_len = format->formatter(buf, n, batch_buffer + batch_used);
+
+        /* drop the separator after the last cell */
+        batch_used += cells_len - 1;
+        put("\n", 1);
+    }
+}
+
+/*
+ * Writes a line of text as is, without a direction tag.
+ */
+void batch_write_line(const char *line)
+{
+    int len = strlen(line);
+
+    reserve(len);
+    put(line, len);
+}
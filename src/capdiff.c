@@ -0,0 +1,806 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/formatters.h"
+#include "../include/capture.h"
+#include "../include/capdiff.h"
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+/* what the gear hash adds for each byte value */
+uint64_t diff_gear[256];
+
+/* the differing regions of the streams being compared */
+diff_region *diff_regions = NULL;
+int num_diff_regions = 0;
+int diff_regions_size = 0;
+
+/* the furthest reaching paths of the alignment, by edits and diagonal */
+int *diff_trace = NULL;
+int diff_trace_size = 0;
+
+/*
+ * Fills the gear table with splitmix64 values from a fixed seed, so
+ * that chunk boundaries are the same from run to run.
+ */
+void capdiff_init_gear()
+{
+    uint64_t seed, z;
+    int i;
+
+    seed = 0x70696e7464696666ULL;
+    for (i = 0; i < 256; i++)
+    {
+        seed += 0x9e3779b97f4a7c15ULL;
+        z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        diff_gear[i] = z ^ (z >> 31);
+    }
+}
+
+/*
+ * Returns the recorded session with the given id, creating it if
+ * needed, or NULL if out of memory.
+ */
+diff_session *capdiff_get_session(diff_capture *c, int id)
+{
+    diff_session **tmp;
+    int size;
+
+    if (id >= c->sessions_size)
+    {
+        size = (c->sessions_size > 0) ? c->sessions_size : 16;
+        while (size <= id)
+        {
+            size *= 2;
+        }
+
+        tmp = (diff_session **)realloc(c->sessions, size * sizeof(diff_session *));
+        if (tmp == NULL)
+        {
+            return NULL;
+        }
+        memset(tmp + c->sessions_size, 0, (size - c->sessions_size) * sizeof(diff_session *));
+
+        c->sessions = tmp;
+        c->sessions_size = size;
+    }
+
+    if (c->sessions[id] == NULL)
+    {
+        c->sessions[id] = (diff_session *)calloc(1, sizeof(diff_session));
+        if (c->sessions[id] != NULL)
+        {
+            c->sessions[id]->id = id;
+        }
+    }
+
+    return c->sessions[id];
+}
+
+/*
+ * Appends a record payload to a stream.
+ *
+ * Returns 0 on success, -1 if out of memory
+ */
+int capdiff_add_segment(diff_stream *st, const unsigned char *data, int len)
+{
+    diff_segment *tmp;
+    int size;
+
+    if (st->num_segs == st->segs_size)
+    {
+        size = (st->segs_size > 0) ? st->segs_size * 2 : 256;
+        tmp = (diff_segment *)realloc(st->segs, size * sizeof(diff_segment));
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+
+        st->segs = tmp;
+        st->segs_size = size;
+    }
+
+    st->segs[st->num_segs].data = data;
+    st->segs[st->num_segs].len = len;
+    st->segs[st->num_segs].off = st->bytes;
+    st->num_segs++;
+    st->bytes += len;
+
+    return 0;
+}
+
+/*
+ * Maps a capture and collects the payloads of each session and
+ * direction. Nothing is copied: the streams point into the mapping.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int capdiff_load(diff_capture *c, char *path)
+{
+    capture_header *header;
+    capture_record *rec;
+    diff_session *s;
+    size_t off;
+    int ret;
+
+    memset(c, 0, sizeof(diff_capture));
+    c->path = path;
+    if ((c->map = capture_map_log(path, &c->size)) == NULL)
+    {
+        return -1;
+    }
+    header = (capture_header *)c->map;
+    madvise(c->map, c->size, MADV_SEQUENTIAL);
+
+    off = header->header_size;
+    while ((rec = capture_next(c->map, c->size, &off)) != NULL)
+    {
+        if (((rec->type != CAPTURE_IN) && (rec->type != CAPTURE_OUT)) || (rec->length == 0))
+        {
+            continue;
+        }
+
+        if ((s = capdiff_get_session(c, rec->session)) == NULL)
+        {
+            printf("out of memory for %s\n", path);
+            return -1;
+        }
+
+        ret = capdiff_add_segment((rec->type == CAPTURE_IN) ? &s->in : &s->out,
+                                  (unsigned char *)(rec + 1), rec->length);
+        if (ret == -1)
+        {
+            printf("out of memory for %s\n", path);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Frees what capdiff_load() allocated and unmaps the capture.
+ */
+void capdiff_unload(diff_capture *c)
+{
+    int i;
+
+    for (i = 0; i < c->sessions_size; i++)
+    {
+        if (c->sessions[i] != NULL)
+        {
+            free(c->sessions[i]->in.segs);
+            free(c->sessions[i]->in.chunks);
+            free(c->sessions[i]->out.segs);
+            free(c->sessions[i]->out.chunks);
+            free(c->sessions[i]);
+        }
+    }
+    free(c->sessions);
+
+    if (c->map != NULL)
+    {
+        munmap(c->map, c->size);
+    }
+    memset(c, 0, sizeof(diff_capture));
+}
+
+/*
+ * Appends a chunk starting at off to a stream.
+ *
+ * Returns 0 on success, -1 if out of memory
+ */
+int capdiff_add_chunk(diff_stream *st, long long off, uint64_t hash, int *size)
+{
+    diff_chunk *tmp;
+
+    if (st->num_chunks == *size)
+    {
+        *size = (*size > 0) ? *size * 2 : 256;
+        tmp = (diff_chunk *)realloc(st->chunks, *size * sizeof(diff_chunk));
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+        st->chunks = tmp;
+    }
+
+    st->chunks[st->num_chunks].off = off;
+    st->chunks[st->num_chunks].hash = hash;
+    st->num_chunks++;
+
+    return 0;
+}
+
+/*
+ * Splits a stream into content-defined chunks. A boundary depends only
+ * on the bytes just before it, so an insertion moves the boundaries
+ * near it and leaves the rest where they were. Each chunk gets a
+ * 64-bit FNV-1a hash of its bytes for the alignment to compare.
+ *
+ * Returns 0 on success, -1 if out of memory
+ */
+int capdiff_chunk(diff_stream *st)
+{
+    const unsigned char *p, *end;
+    uint64_t gear, hash;
+    long long start;
+    int i, len, size;
+
+    st->num_chunks = 0;
+    size = 0;
+    start = 0;
+    len = 0;
+    gear = 0;
+    hash = FNV_OFFSET_BASIS;
+
+    for (i = 0; i < st->num_segs; i++)
+    {
+        p = st->segs[i].data;
+        end = p + st->segs[i].len;
+        for (; p < end; p++)
+        {
+            gear = (gear << 1) + diff_gear[*p];
+            hash = (hash ^ *p) * FNV_PRIME;
+            len++;
+
+            if (((len >= DIFF_CHUNK_MIN) && ((gear >> (64 - DIFF_CHUNK_BITS)) == 0)) ||
+                (len >= DIFF_CHUNK_MAX))
+            {
+                if (capdiff_add_chunk(st, start, hash, &size) == -1)
+                {
+                    return -1;
+                }
+                start += len;
+                len = 0;
+                gear = 0;
+                hash = FNV_OFFSET_BASIS;
+            }
+        }
+    }
+
+    if ((len > 0) && (capdiff_add_chunk(st, start, hash, &size) == -1))
+    {
+        return -1;
+    }
+
+    /* the sentinel, so that every chunk ends where the next starts */
+    if (capdiff_add_chunk(st, st->bytes, 0, &size) == -1)
+    {
+        return -1;
+    }
+    st->num_chunks--;
+
+    return 0;
+}
+
+/*
+ * Returns TRUE if chunk i of stream a and chunk j of stream b hold
+ * the same bytes, as far as their lengths and hashes tell.
+ */
+int capdiff_chunks_equal(diff_stream *a, int i, diff_stream *b, int j)
+{
+    return (a->chunks[i].hash == b->chunks[j].hash) &&
+           (a->chunks[i + 1].off - a->chunks[i].off == b->chunks[j + 1].off - b->chunks[j].off);
+}
+
+/*
+ * Copies len bytes of a stream from offset off on.
+ */
+void capdiff_copy(diff_stream *st, long long off, unsigned char *buf, int len)
+{
+    int lo, hi, mid, n;
+    long long skip;
+
+    lo = 0;
+    hi = st->num_segs - 1;
+    while (lo < hi)
+    {
+        mid = (lo + hi + 1) / 2;
+        if (st->segs[mid].off <= off)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    for (; (len > 0) && (lo < st->num_segs); lo++)
+    {
+        skip = off - st->segs[lo].off;
+        n = st->segs[lo].len - skip;
+        if (n > len)
+        {
+            n = len;
+        }
+        memcpy(buf, st->segs[lo].data + skip, n);
+        buf += n;
+        off += n;
+        len -= n;
+    }
+}
+
+/*
+ * Returns the number of equal bytes at the start (or at the end, if
+ * backwards is TRUE) of two ranges of streams.
+ */
+long long capdiff_common(diff_stream *a, long long a_off, long long a_end,
+                         diff_stream *b, long long b_off, long long b_end, int backwards)
+{
+    unsigned char a_buf[256], b_buf[256];
+    long long common;
+    int i, n;
+
+    common = 0;
+    while ((a_off + common < a_end) && (b_off + common < b_end))
+    {
+        n = sizeof(a_buf);
+        if (a_end - a_off - common < n)
+        {
+            n = a_end - a_off - common;
+        }
+        if (b_end - b_off - common < n)
+        {
+            n = b_end - b_off - common;
+        }
+
+        if (backwards)
+        {
+            capdiff_copy(a, a_end - common - n, a_buf, n);
+            capdiff_copy(b, b_end - common - n, b_buf, n);
+            for (i = n - 1; (i >= 0) && (a_buf[i] == b_buf[i]); i--)
+                ;
+            common += n - 1 - i;
+            if (i >= 0)
+            {
+                break;
+            }
+        }
+        else
+        {
+            capdiff_copy(a, a_off + common, a_buf, n);
+            capdiff_copy(b, b_off + common, b_buf, n);
+            for (i = 0; (i < n) && (a_buf[i] == b_buf[i]); i++)
+                ;
+            common += i;
+            if (i < n)
+            {
+                break;
+            }
+        }
+    }
+
+    return common;
+}
+
+/*
+ * Records a differing region given in chunks, narrowed down to the
+ * bytes that differ.
+ *
+ * Returns 0 on success, -1 if out of memory
+ */
+int capdiff_add_region(diff_stream *a, int a_lo, int a_hi, diff_stream *b, int b_lo, int b_hi)
+{
+    diff_region *tmp, r;
+    long long n;
+    int size;
+
+    r.a_off = a->chunks[a_lo].off;
+    r.a_end = a->chunks[a_hi].off;
+    r.b_off = b->chunks[b_lo].off;
+    r.b_end = b->chunks[b_hi].off;
+
+    n = capdiff_common(a, r.a_off, r.a_end, b, r.b_off, r.b_end, FALSE);
+    r.a_off += n;
+    r.b_off += n;
+    n = capdiff_common(a, r.a_off, r.a_end, b, r.b_off, r.b_end, TRUE);
+    r.a_end -= n;
+    r.b_end -= n;
+
+    /* the same bytes cut into different chunks */
+    if ((r.a_off == r.a_end) && (r.b_off == r.b_end))
+    {
+        return 0;
+    }
+
+    if (num_diff_regions == diff_regions_size)
+    {
+        size = (diff_regions_size > 0) ? diff_regions_size * 2 : 64;
+        tmp = (diff_region *)realloc(diff_regions, size * sizeof(diff_region));
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+        diff_regions = tmp;
+        diff_regions_size = size;
+    }
+    diff_regions[num_diff_regions++] = r;
+
+    return 0;
+}
+
+/*
+ * Returns the furthest x the alignment reaches on diagonal k with d
+ * edits, given the furthest reaching paths with d - 1 edits, or -1 if
+ * no path gets there within the n by m grid. *inserted tells if the
+ * last edit was taking a chunk of b rather than dropping one of a.
+ */
+int capdiff_step(int *prev, int d, int k, int n, int m, int *inserted)
+{
+    int x;
+
+    x = -1;
+    *inserted = FALSE;
+
+    if ((k < d) && (prev[k + 1] >= 0) && (prev[k + 1] - k <= m))
+    {
+        x = prev[k + 1];
+        *inserted = TRUE;
+    }
+
+    if ((k > -d) && (prev[k - 1] >= 0) && (prev[k - 1] + 1 <= n) && (prev[k - 1] + 1 > x))
+    {
+        x = prev[k - 1] + 1;
+        *inserted = FALSE;
+    }
+
+    return x;
+}
+
+/*
+ * Aligns the chunks of two streams with Myers' O(ND) algorithm, after
+ * taking off the chunks they start and end with in common, and
+ * collects the differing regions in diff_regions[].
+ *
+ * Returns 0 on success, 1 if the streams needed more than
+ * DIFF_MAX_EDITS edits (the rest is one region then), -1 if out of
+ * memory
+ */
+int capdiff_align(diff_stream *a, diff_stream *b)
+{
+    diff_region r;
+    int *v, *prev, *tmp;
+    int lo, n, m, d, k, x, y, found, size, inserted;
+    int mid_x, mid_y, open, a_hi, b_hi;
+
+    num_diff_regions = 0;
+    n = a->num_chunks;
+    m = b->num_chunks;
+
+    lo = 0;
+    while ((lo < n) && (lo < m) && capdiff_chunks_equal(a, lo, b, lo))
+    {
+        lo++;
+    }
+    while ((n > lo) && (m > lo) && capdiff_chunks_equal(a, n - 1, b, m - 1))
+    {
+        n--;
+        m--;
+    }
+    if ((lo == n) && (lo == m))
+    {
+        return 0;
+    }
+
+    /* the furthest x reached on diagonal k = x - y with d edits is
+       kept at diff_trace[d * d + d + k] */
+    found = -1;
+    for (d = 0; (d <= DIFF_MAX_EDITS) && (found < 0); d++)
+    {
+        if ((d + 1) * (d + 1) > diff_trace_size)
+        {
+            size = (diff_trace_size > 0) ? diff_trace_size * 4 : 1024;
+            tmp = (int *)realloc(diff_trace, size * sizeof(int));
+            if (tmp == NULL)
+            {
+                return -1;
+            }
+            diff_trace = tmp;
+            diff_trace_size = size;
+        }
+
+        v = diff_trace + d * d + d;
+        prev = diff_trace + (d - 1) * (d - 1) + (d - 1);
+        for (k = -d; k <= d; k += 2)
+        {
+            x = (d == 0) ? lo : capdiff_step(prev, d, k, n, m, &inserted);
+            v[k] = x;
+            if (x < 0)
+            {
+                continue;
+            }
+
+            y = x - k;
+            while ((x < n) && (y < m) && capdiff_chunks_equal(a, x, b, y))
+            {
+                x++;
+                y++;
+            }
+            v[k] = x;
+
+            if ((x == n) && (y == m))
+            {
+                found = d;
+                break;
+            }
+        }
+    }
+
+    if (found < 0)
+    {
+        return (capdiff_add_region(a, lo, n, b, lo, m) == -1) ? -1 : 1;
+    }
+
+    /* walk the path back; edits with no equal chunks between them
+       make up one region */
+    x = n;
+    y = m;
+    open = FALSE;
+    a_hi = n;
+    b_hi = m;
+    for (d = found; d > 0; d--)
+    {
+        prev = diff_trace + (d - 1) * (d - 1) + (d - 1);
+        k = x - y;
+        mid_x = capdiff_step(prev, d, k, n, m, &inserted);
+        mid_y = mid_x - k;
+
+        if ((x > mid_x) && open)
+        {
+            if (capdiff_add_region(a, x, a_hi, b, y, b_hi) == -1)
+            {
+                return -1;
+            }
+            open = FALSE;
+        }
+        if (!open)
+        {
+            a_hi = mid_x;
+            b_hi = mid_y;
+            open = TRUE;
+        }
+
+        x = inserted ? mid_x : mid_x - 1;
+        y = inserted ? mid_y - 1 : mid_y;
+    }
+
+    if (open && (capdiff_add_region(a, x, a_hi, b, y, b_hi) == -1))
+    {
+        return -1;
+    }
+
+    /* the walk found the regions last to first */
+    for (k = 0; k < num_diff_regions / 2; k++)
+    {
+        r = diff_regions[k];
+        diff_regions[k] = diff_regions[num_diff_regions - 1 - k];
+        diff_regions[num_diff_regions - 1 - k] = r;
+    }
+
+    return 0;
+}
+
+/*
+ * Prints the bytes of one side of a region, DIFF_LINE_BYTES per line
+ * and at most DIFF_MAX_LINES lines.
+ */
+void capdiff_print_side(char sign, diff_stream *st, long long off, long long end,
+                        display_format *format)
+{
+    unsigned char buf[DIFF_LINE_BYTES];
+    char cells[FORMAT_BUFFER_SIZE(DIFF_LINE_BYTES)];
+    int lines, n, len;
+
+    for (lines = 0; (off < end) && (lines < DIFF_MAX_LINES); lines++, off += n)
+    {
+        n = (end - off < DIFF_LINE_BYTES) ? end - off : DIFF_LINE_BYTES;
+        capdiff_copy(st, off, buf, n);
+
+        len = format->formatter(buf, n, cells);
+        if (len > 0)
+        {
+            /* drop the separator after the last cell */
+            cells[len - 1] = '\0';
+        }
+        printf("%c%10lld  %s\n", sign, off, cells);
+    }
+
+    if (off < end)
+    {
+        printf("%c ... %lld more bytes\n", sign, end - off);
+    }
+}
+
+/*
+ * Compares one direction of a session in two captures and prints the
+ * regions that differ.
+ *
+ * Returns 0 if the streams are equal, 1 if they differ, -1 if out of
+ * memory
+ */
+int capdiff_streams(diff_capture *ca, diff_capture *cb, int id, char *direction,
+                    diff_stream *a, diff_stream *b, display_format *format)
+{
+    char a_size[16], b_size[16];
+    long long a_only, b_only;
+    int i, ret;
+
+    /* the text format breaks lines where the data does */
+    if (format->formatter == text_formatter)
+    {
+        format = &display_formats[FORMATTER_WIDE];
+    }
+
+    if ((capdiff_chunk(a) == -1) || (capdiff_chunk(b) == -1) ||
+        ((ret = capdiff_align(a, b)) == -1))
+    {
+        printf("out of memory comparing session %d\n", id);
+        return -1;
+    }
+
+    format_size(a->bytes, a_size);
+    format_size(b->bytes, b_size);
+    if (num_diff_regions == 0)
+    {
+        printf("session %d, %s: %s, same in both\n", id, direction, a_size);
+        return 0;
+    }
+
+    a_only = 0;
+    b_only = 0;
+    for (i = 0; i < num_diff_regions; i++)
+    {
+        a_only += diff_regions[i].a_end - diff_regions[i].a_off;
+        b_only += diff_regions[i].b_end - diff_regions[i].b_off;
+    }
+
+    printf("session %d, %s: %s in %s, %s in %s, %d differing region%s, "
+           "%lld bytes only in the first, %lld only in the second\n",
+           id, direction, a_size, ca->path, b_size, cb->path, num_diff_regions,
+           (num_diff_regions == 1) ? "" : "s", a_only, b_only);
+    if (ret == 1)
+    {
+        printf("(too different to align past offset %lld: the rest is one region)\n",
+               diff_regions[num_diff_regions - 1].a_off);
+    }
+
+    for (i = 0; (i < num_diff_regions) && (i < DIFF_MAX_REGIONS); i++)
+    {
+        printf("@@ -%lld,%lld +%lld,%lld @@\n",
+               diff_regions[i].a_off, diff_regions[i].a_end - diff_regions[i].a_off,
+               diff_regions[i].b_off, diff_regions[i].b_end - diff_regions[i].b_off);
+        capdiff_print_side('-', a, diff_regions[i].a_off, diff_regions[i].a_end, format);
+        capdiff_print_side('+', b, diff_regions[i].b_off, diff_regions[i].b_end, format);
+    }
+    if (num_diff_regions > DIFF_MAX_REGIONS)
+    {
+        printf("... %d more regions\n", num_diff_regions - DIFF_MAX_REGIONS);
+    }
+
+    return 1;
+}
+
+/*
+ * Compares the sessions of two loaded captures, or only the given one
+ * if session is not 0. Sessions are matched by their recorded ids; a
+ * session only one capture has is compared with nothing.
+ *
+ * Returns 0 if everything compared is the same, 1 if something
+ * differs, -1 on error
+ */
+int capdiff_sessions(diff_capture *a, diff_capture *b, int session)
+{
+    static diff_session none;
+    diff_session *sa, *sb;
+    int i, last, ret, result;
+
+    if ((session > 0) &&
+        ((session >= a->sessions_size) || (a->sessions[session] == NULL) ||
+         (session >= b->sessions_size) || (b->sessions[session] == NULL)))
+    {
+        printf("session %d didn't send or receive anything in both captures\n", session);
+        return -1;
+    }
+
+    last = (a->sessions_size > b->sessions_size) ? a->sessions_size : b->sessions_size;
+    result = 0;
+    for (i = 0; i < last; i++)
+    {
+        sa = (i < a->sessions_size) ? a->sessions[i] : NULL;
+        sb = (i < b->sessions_size) ? b->sessions[i] : NULL;
+        if (((session > 0) && (i != session)) || ((sa == NULL) && (sb == NULL)))
+        {
+            continue;
+        }
+
+        ret = capdiff_streams(a, b, i, "bytes received",
+                              (sa != NULL) ? &sa->in : &none.in,
+                              (sb != NULL) ? &sb->in : &none.in, sock_in_format);
+        if (ret == -1)
+        {
+            return -1;
+        }
+        result |= ret;
+
+        ret = capdiff_streams(a, b, i, "bytes sent",
+                              (sa != NULL) ? &sa->out : &none.out,
+                              (sb != NULL) ? &sb->out : &none.out, sock_out_format);
+        if (ret == -1)
+        {
+            return -1;
+        }
+        result |= ret;
+    }
+
+    return result;
+}
+
+/*
+ * Compares two captures, printing where their streams differ.
+ *
+ * Returns 0 if everything compared is the same, 1 if something
+ * differs, -1 on error
+ */
+int capdiff_run(char *a_path, char *b_path, int session)
+{
+    diff_capture a, b;
+    int result;
+
+    capdiff_init_gear();
+    memset(&a, 0, sizeof(diff_capture));
+    memset(&b, 0, sizeof(diff_capture));
+
+    result = -1;
+    if ((capdiff_load(&a, a_path) == 0) && (capdiff_load(&b, b_path) == 0))
+    {
+        result = capdiff_sessions(&a, &b, session);
+    }
+
+    capdiff_unload(&a);
+    capdiff_unload(&b);
+
+    free(diff_regions);
+    diff_regions = NULL;
+    num_diff_regions = 0;
+    diff_regions_size = 0;
+    free(diff_trace);
+    diff_trace = NULL;
+    diff_trace_size = 0;
+
+    return result;
+}
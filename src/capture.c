@@ -0,0 +1,502 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/capture.h"
+#include "../include/pcapng.h"
+
+/* TRUE while a capture log is being written */
+int capturing = FALSE;
+
+int capture_fd = -1;
+
+/* the mapped window of the file, where the next byte goes, and how
+   far the file has been extended */
+unsigned char *capture_map = MAP_FAILED;
+off_t capture_map_off = 0;
+off_t capture_pos = 0;
+off_t capture_file_size = 0;
+
+/* the window after the current one once idle work has prepared it,
+   and a passed window left for idle work to unmap; moving on to a
+   prepared window only switches pointers */
+unsigned char *capture_next_map = MAP_FAILED;
+off_t capture_next_off = 0;
+unsigned char *capture_old_map = MAP_FAILED;
+
+/*
+ * Returns the time of the given clock in nanoseconds.
+ */
+uint64_t capture_clock_ns(int clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Maps the window of the file starting at the given offset, extending
+ * the file first if needed. The window is populated up front, so that
+ * writing to it takes no page faults.
+ *
+ * Returns the mapping, or MAP_FAILED on error (errno tells the reason)
+ */
+unsigned char *capture_map_at(off_t off)
+{
+    off_t size;
+
+    if (off + CAPTURE_WINDOW_SIZE > capture_file_size)
+    {
+        size = capture_file_size + CAPTURE_EXTEND_SIZE;
+        while (size < off + CAPTURE_WINDOW_SIZE)
+        {
+            size += CAPTURE_EXTEND_SIZE;
+        }
+
+        /* reserve the blocks, so that running out of space shows
+           here and not as SIGBUS when the mapping is written */
+        if ((posix_fallocate(capture_fd, capture_file_size,
+                             size - capture_file_size) != 0) &&
+            (ftruncate(capture_fd, size) == -1))
+        {
+            return MAP_FAILED;
+        }
+        capture_file_size = size;
+    }
+
+    return mmap(NULL, CAPTURE_WINDOW_SIZE, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, capture_fd, off);
+}
+
+/*
+ * Leaves the current window for idle work to unmap.
+ */
+void capture_retire_window()
+{
+    if (capture_map == MAP_FAILED)
+    {
+        return;
+    }
+
+    if (capture_old_map != MAP_FAILED)
+    {
+        munmap(capture_old_map, CAPTURE_WINDOW_SIZE);
+    }
+    capture_old_map = capture_map;
+    capture_map = MAP_FAILED;
+}
+
+/*
+ * Moves to the window of the file holding the given offset: the one
+ * prepared ahead if it is that, otherwise a freshly mapped one.
+ *
+ * Returns 0 on success, -1 on error (errno tells the reason)
+ */
+int capture_map_window(off_t pos)
+{
+    off_t off;
+
+    capture_retire_window();
+
+    off = pos - (pos % CAPTURE_WINDOW_SIZE);
+
+    if ((capture_next_map != MAP_FAILED) && (capture_next_off == off))
+    {
+        capture_map = capture_next_map;
+        capture_map_off = off;
+        capture_next_map = MAP_FAILED;
+        return 0;
+    }
+
+    /* idle work did not get to it: prepare it here */
+    if (capture_next_map != MAP_FAILED)
+    {
+        munmap(capture_next_map, CAPTURE_WINDOW_SIZE);
+        capture_next_map = MAP_FAILED;
+    }
+
+    if ((capture_map = capture_map_at(off)) == MAP_FAILED)
+    {
+        return -1;
+    }
+    capture_map_off = off;
+
+    return 0;
+}
+
+/*
+ * Stops recording after an error, keeping what was written.
+ */
+void capture_fail()
+{
+    char msg[512];
+
+    sprintf(msg, "Recording stopped (%s)\n", strerror(errno));
+    capture_close();
+    write_info_wnd(msg);
+}
+
+/*
+ * Copies bytes to the end of the log, moving the window as it fills.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int capture_put(const void *buf, size_t len)
+{
+    const unsigned char *p = (const unsigned char *)buf;
+    size_t room;
+
+    while (len > 0)
+    {
+        if ((capture_pos < capture_map_off) ||
+            (capture_pos >= capture_map_off + CAPTURE_WINDOW_SIZE) ||
+            (capture_map == MAP_FAILED))
+        {
+            if (capture_map_window(capture_pos) == -1)
+            {
+                return -1;
+            }
+        }
+
+        room = capture_map_off + CAPTURE_WINDOW_SIZE - capture_pos;
+        if (room > len)
+        {
+            room = len;
+        }
+
+        memcpy(capture_map + (capture_pos - capture_map_off), p, room);
+        capture_pos += room;
+        p += room;
+        len -= room;
+    }
+
+    return 0;
+}
+
+/*
+ * Returns TRUE while idle work has a window to prepare or to unmap.
+ */
+int capture_prepare_pending()
+{
+    if (!capturing)
+    {
+        return FALSE;
+    }
+
+    return (capture_old_map != MAP_FAILED) ||
+        ((capture_next_map == MAP_FAILED) && (capture_map != MAP_FAILED) &&
+         (capture_pos - capture_map_off >= CAPTURE_PREPARE_MARK));
+}
+
+/*
+ * Does a step of the idle work of the log: unmaps a passed window, or
+ * extends the file and maps the next window before the writes reach
+ * it.
+ */
+void capture_prepare_step()
+{
+    if (!capture_prepare_pending())
+    {
+        return;
+    }
+
+    if (capture_old_map != MAP_FAILED)
+    {
+        munmap(capture_old_map, CAPTURE_WINDOW_SIZE);
+        capture_old_map = MAP_FAILED;
+        return;
+    }
+
+    capture_next_off = capture_map_off + CAPTURE_WINDOW_SIZE;
+    if ((capture_next_map = capture_map_at(capture_next_off)) == MAP_FAILED)
+    {
+        capture_fail();
+    }
+}
+
+/*
+ * Creates a capture log and writes its header.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int capture_open(char *path)
+{
+    capture_header header;
+
+    capture_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (capture_fd == -1)
+    {
+        printf("Couldn't open %s (%s)\n", path, strerror(errno));
+        return -1;
+    }
+
+    capture_map = MAP_FAILED;
+    capture_map_off = 0;
+    capture_pos = 0;
+    capture_file_size = 0;
+    capture_next_map = MAP_FAILED;
+    capture_old_map = MAP_FAILED;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CAPTURE_VERSION;
+    header.header_size = sizeof(header);
+    header.start_realtime_ns = capture_clock_ns(CLOCK_REALTIME);
+    header.start_monotonic_ns = capture_clock_ns(CLOCK_MONOTONIC);
+
+    if (capture_put(&header, sizeof(header)) == -1)
+    {
+        printf("Couldn't write %s (%s)\n", path, strerror(errno));
+        close(capture_fd);
+        capture_fd = -1;
+        return -1;
+    }
+
+    capturing = TRUE;
+
+    return 0;
+}
+
+/*
+ * Appends a record and its payload to the log, and hands it to a live
+ * pcapng export.
+ */
+void capture_emit(capture_record *rec, const unsigned char *buf)
+{
+    off_t pad;
+
+    if (pcapng_writing)
+    {
+        pcapng_write(rec, buf);
+    }
+
+    if (!capturing)
+    {
+        return;
+    }
+
+    if ((capture_put(rec, sizeof(capture_record)) == -1) ||
+        (capture_put(buf, rec->length) == -1))
+    {
+        capture_fail();
+        return;
+    }
+
+    /* the padding is already zero in the freshly extended file */
+    pad = (CAPTURE_ALIGN - (capture_pos % CAPTURE_ALIGN)) % CAPTURE_ALIGN;
+    capture_pos += pad;
+}
+
+/*
+ * Records len payload bytes of the given type.
+ */
+void capture_write(int type, int session, const unsigned char *buf, int len)
+{
+    capture_record rec;
+
+    if (!capturing && !pcapng_writing)
+    {
+        return;
+    }
+
+    rec.length = len;
+    rec.type = type;
+    rec.flags = 0;
+    rec.session = session;
+    rec.timestamp_ns = capture_clock_ns(CLOCK_MONOTONIC);
+
+    capture_emit(&rec, buf);
+}
+
+/*
+ * Records that a session was opened on a socket, with its endpoints
+ * and the flags telling how.
+ */
+void capture_session(int session, int sockfd, int flags, char *name)
+{
+    unsigned char buf[sizeof(capture_endpoints) + 256];
+    capture_endpoints *ends = (capture_endpoints *)buf;
+    capture_record rec;
+    struct sockaddr_in addr;
+    socklen_t addr_len;
+    int len;
+
+    if (!capturing && !pcapng_writing)
+    {
+        return;
+    }
+
+    memset(ends, 0, sizeof(capture_endpoints));
+
+    addr_len = sizeof(addr);
+    if ((getsockname(sockfd, (struct sockaddr *)&addr, &addr_len) == 0) &&
+        (addr.sin_family == AF_INET))
+    {
+        ends->local_addr = addr.sin_addr.s_addr;
+        ends->local_port = addr.sin_port;
+    }
+
+    addr_len = sizeof(addr);
+    if ((getpeername(sockfd, (struct sockaddr *)&addr, &addr_len) == 0) &&
+        (addr.sin_family == AF_INET))
+    {
+        ends->peer_addr = addr.sin_addr.s_addr;
+        ends->peer_port = addr.sin_port;
+    }
+
+    len = strlen(name);
+    if (len > 255)
+    {
+        len = 255;
+    }
+    memcpy(buf + sizeof(capture_endpoints), name, len);
+
+    rec.length = sizeof(capture_endpoints) + len;
+    rec.type = CAPTURE_OPEN;
+    rec.flags = flags;
+    rec.session = session;
+    rec.timestamp_ns = capture_clock_ns(CLOCK_MONOTONIC);
+
+    capture_emit(&rec, buf);
+}
+
+/*
+ * Finishes the log: the unused pre-extended space is cut off.
+ */
+void capture_close()
+{
+    if (capture_fd == -1)
+    {
+        return;
+    }
+
+    capture_retire_window();
+    if (capture_old_map != MAP_FAILED)
+    {
+        munmap(capture_old_map, CAPTURE_WINDOW_SIZE);
+        capture_old_map = MAP_FAILED;
+    }
+    if (capture_next_map != MAP_FAILED)
+    {
+        munmap(capture_next_map, CAPTURE_WINDOW_SIZE);
+        capture_next_map = MAP_FAILED;
+    }
+
+    ftruncate(capture_fd, capture_pos);
+    close(capture_fd);
+    capture_fd = -1;
+    capturing = FALSE;
+}
+
+/*
+ * Maps a capture log for reading and checks its header. The mapping
+ * is size bytes long.
+ *
+ * Returns the mapping, or NULL on error
+ */
+unsigned char *capture_map_log(char *path, size_t *size)
+{
+    capture_header *header;
+    unsigned char *map;
+    struct stat st;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if ((fd == -1) || (fstat(fd, &st) == -1))
+    {
+        printf("Couldn't open %s (%s)\n", path, strerror(errno));
+        return NULL;
+    }
+
+    map = MAP_FAILED;
+    if (st.st_size >= (off_t)sizeof(capture_header))
+    {
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    header = (capture_header *)map;
+    if ((map == MAP_FAILED) ||
+        (memcmp(header->magic, CAPTURE_MAGIC, sizeof(header->magic)) != 0) ||
+        (header->version != CAPTURE_VERSION))
+    {
+        if (map != MAP_FAILED)
+        {
+            munmap(map, st.st_size);
+        }
+        printf("%s is not a pint capture\n", path);
+        return NULL;
+    }
+
+    *size = st.st_size;
+
+    return map;
+}
+
+/*
+ * Reads the record at *off of a mapped capture log, and moves *off
+ * past it.
+ *
+ * Returns the record, or NULL at the end of the log
+ */
+capture_record *capture_next(unsigned char *map, size_t size, size_t *off)
+{
+    capture_record *rec;
+    size_t end;
+
+    if (*off + sizeof(capture_record) > size)
+    {
+        return NULL;
+    }
+
+    rec = (capture_record *)(map + *off);
+    end = *off + sizeof(capture_record) + rec->length;
+    if ((rec->type == CAPTURE_END) || (end > size))
+    {
+        return NULL;
+    }
+
+    *off = (end + CAPTURE_ALIGN - 1) & ~(size_t)(CAPTURE_ALIGN - 1);
+
+    return rec;
+}
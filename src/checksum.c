@@ -0,0 +1,104 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdint.h>
+
+#include "../include/checksum.h"
+
+/* CRC-32 (IEEE 802.3, as in zlib and pcapng), reflected polynomial */
+#define CRC32_POLY 0xedb88320
+
+/* crc_tables[0] is the classic byte table; crc_tables[k] advances a
+   byte that is followed by k more, so eight bytes are folded in per
+   step */
+uint32_t crc_tables[8][256];
+int crc_tables_ready = 0;
+
+/*
+ * Builds the lookup tables.
+ */
+void init_crc_tables()
+{
+    uint32_t c;
+    int i, j;
+
+    for (i = 0; i < 256; i++)
+    {
+        c = i;
+        for (j = 0; j < 8; j++)
+        {
+            c = (c & 1) ? (c >> 1) ^ CRC32_POLY : c >> 1;
+        }
+        crc_tables[0][i] = c;
+    }
+
+    for (i = 0; i < 256; i++)
+    {
+        for (j = 1; j < 8; j++)
+        {
+            crc_tables[j][i] = (crc_tables[j - 1][i] >> 8) ^
+                crc_tables[0][crc_tables[j - 1][i] & 0xff];
+        }
+    }
+
+    crc_tables_ready = 1;
+}
+
+/*
+ * Continues a CRC-32 over len more bytes; start with crc 0.
+ *
+ * Returns the CRC-32 of all the bytes so far
+ */
+unsigned int crc32_update(unsigned int crc, const unsigned char *buf, long long len)
+{
+    uint32_t c, lo, hi;
+
+    if (!crc_tables_ready)
+    {
+        init_crc_tables();
+    }
+
+    c = ~crc;
+
+    /* eight bytes at a time, little endian */
+    while (len >= 8)
+    {
+        lo = c ^ (buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24));
+        hi = buf[4] | (buf[5] << 8) | (buf[6] << 16) | ((uint32_t)buf[7] << 24);
+        c = crc_tables[7][lo & 0xff] ^ crc_tables[6][(lo >> 8) & 0xff] ^
+            crc_tables[5][(lo >> 16) & 0xff] ^ crc_tables[4][lo >> 24] ^
+            crc_tables[3][hi & 0xff] ^ crc_tables[2][(hi >> 8) & 0xff] ^
+            crc_tables[1][(hi >> 16) & 0xff] ^ crc_tables[0][hi >> 24];
+        buf += 8;
+        len -= 8;
+    }
+
+    while (len-- > 0)
+    {
+        c = crc_tables[0][(c ^ *buf++) & 0xff] ^ (c >> 8);
+    }
+
+    return ~c;
+}
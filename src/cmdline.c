@@ -32,6 +32,9 @@ SOFTWARE.
 #include "../include/curses.h"
 #include "../include/formatters.h"
 #include "../include/network.h"
+#include "../include/history.h"
+#include "../include/eventloop.h"
+#include "../include/servermode.h"
 
 command_line_params cmdline_params;
 
@@ -64,6 +67,97 @@ void show_usage()
     printf("\t\t\tformatting\n");
     printf("\t-sih\t\tBytes received -window uses 2-char hex formatting\n");
     printf("\t-udp\t\tuse UDP (TCP is default)\n");
+    printf("\t-fps N\t\tredraw the screen at most N times per second\n");
+    printf("\t\t\t(default %d, 0 = no limit)\n", DEFAULT_FRAME_RATE);
+    printf("\t-history SIZE\tkeep at most SIZE bytes of history in memory per\n");
+    printf("\t\t\tdirection; older history is compressed. K, M and G\n");
+    printf("\t\t\tsuffixes are accepted\n");
+    printf("\t\t\t(default %lldM)\n", DEFAULT_HISTORY_SIZE / (1024 * 1024));
+    printf("\t-batch\t\theadless mode: no windows, bytes sent and received are\n");
+    printf("\t\t\twritten to stdout tagged with >> and << in the\n");
+    printf("\t\t\tformats chosen for the windows. Stdin is sent a line\n");
+    printf("\t\t\tat a time; at its end pint waits for the remote host\n");
+    printf("\t\t\tto close the connection\n");
+    printf("\t-out FILE\twrite batch mode output to FILE instead of stdout\n");
+    printf("\t\t\t(implies -batch)\n");
+    printf("\t-io BACKEND\twait for I/O with epoll (default), select or\n");
+    printf("\t\t\turing. uring completes socket reads in the kernel and\n");
+    printf("\t\t\tfalls back to epoll if io_uring is not available\n");
+    printf("\t-cork\t\tsend TCP data in full segments: the socket is corked\n");
+    printf("\t\t\twhile bytes are waiting in the send queue, and the\n");
+    printf("\t\t\tlast partial segment leaves once the queue is empty\n");
+    printf("\t-mode MODE\tlisten mode only: serve every client as echo,\n");
+    printf("\t\t\tdiscard, chargen (RFC 862, 863, 864) or sink, a\n");
+    printf("\t\t\tdiscard that drops the bytes in the kernel. Nothing\n");
+    printf("\t\t\tis displayed; the throughput is reported every second\n");
+    printf("\t\t\tand when a client leaves. Without a terminal on\n");
+    printf("\t\t\tstdout the reports go to stderr\n");
+    printf("\t-record FILE\tlog every chunk read from and written to the\n");
+    printf("\t\t\tsockets into FILE, with its session, direction and a\n");
+    printf("\t\t\tnanosecond timestamp (a compact binary format, see\n");
+    printf("\t\t\tinclude/capture.h). Not available in pipe or server\n");
+    printf("\t\t\tmode\n");
+    printf("\t-pcapng FILE\texport the sessions to FILE in pcapng format, with\n");
+    printf("\t\t\tmade up Ethernet, IPv4 and TCP or UDP headers, for\n");
+    printf("\t\t\tWireshark and tshark. Not available in pipe or\n");
+    printf("\t\t\tserver mode\n");
+    printf("\t-convert FILE\twith -pcapng, convert a capture recorded with\n");
+    printf("\t\t\t-record instead; no host or port is needed\n");
+    printf("\t-replay FILE\tsend what a session recorded in FILE sent to the\n");
+    printf("\t\t\tremote host, and compare the response with the\n");
+    printf("\t\t\trecorded one: divergences are reported with their\n");
+    printf("\t\t\toffsets, and the exit status is 1 unless the response\n");
+    printf("\t\t\tmatched (implies -batch)\n");
+    printf("\t-speed X\twith -replay, send at X times the recorded pace, or\n");
+    printf("\t\t\twith max, as fast as possible (default 1)\n");
+    printf("\t-session N\twith -replay, the recorded session to replay\n");
+    printf("\t\t\t(default: the first one that sent anything); with\n");
+    printf("\t\t\t-diff, the only session to compare\n");
+    printf("\t-view FILE\tbrowse the sessions recorded in FILE with -record\n");
+    printf("\t\t\tin the usual windows, jumping to a time or offset\n");
+    printf("\t\t\tby typing t SECONDS or o OFFSET; no host or port is\n");
+    printf("\t\t\tneeded\n");
+    printf("\t-diff A B\tcompare the sessions recorded in captures A and B,\n");
+    printf("\t\t\tmatched by number (or only the one given with\n");
+    printf("\t\t\t-session), showing only the bytes that differ; the\n");
+    printf("\t\t\texit status is 1 if anything does. No host or port\n");
+    printf("\t\t\tis needed\n");
+
+    printf("\t-load N\t\tload the remote host over N connections, each\n");
+    printf("\t\t\tsending the -request, waiting for the response and\n");
+    printf("\t\t\tsending it again. Requests per second and latency\n");
+    printf("\t\t\tpercentiles are reported every second and at the end.\n");
+    printf("\t\t\tWithout a terminal on stdout the reports go to stderr\n");
+    printf("\t-request STR\twith -load, the request, in the escaped input syntax\n");
+    printf("\t-rlen SIZE\twith -load, responses are SIZE bytes long\n");
+    printf("\t-rdelim STR\twith -load, responses end with STR, in the escaped\n");
+    printf("\t\t\tinput syntax (default: a linefeed; over UDP, each\n");
+    printf("\t\t\tdatagram is a response)\n");
+    printf("\t-requests N\twith -load, stop after N requests\n");
+    printf("\t-duration SECS\twith -load, stop after SECS seconds; with\n");
+    printf("\t\t\t-throughput, send for SECS seconds (default 10)\n");
+    printf("\t-throughput\tmeasure the goodput of a single TCP stream: connected,\n");
+    printf("\t\t\tsend as fast as possible, using MSG_ZEROCOPY where\n");
+    printf("\t\t\tthe kernel has it; listening (-l), receive from one\n");
+    printf("\t\t\tconnection until it closes. The goodput is reported\n");
+    printf("\t\t\tevery second and at the end\n");
+    printf("\t-sndbuf SIZE\tset the socket send buffer (SO_SNDBUF) to SIZE\n");
+    printf("\t-rcvbuf SIZE\tset the socket receive buffer (SO_RCVBUF) to SIZE\n");
+    printf("\t-nodelay\tsend small writes right away (TCP_NODELAY)\n");
+    printf("\t-quickack\tacknowledge received data right away (TCP_QUICKACK),\n");
+    printf("\t\t\trenewed after every read of a session\n");
+    printf("\t-notsent SIZE\tkeep at most SIZE unsent bytes in the socket\n");
+    printf("\t\t\t(TCP_NOTSENT_LOWAT)\n");
+    printf("\t-keepalive IDLE[,INTVL[,CNT]]\n");
+    printf("\t\t\tsend keepalive probes after IDLE seconds of silence,\n");
+    printf("\t\t\tevery INTVL seconds, giving up after CNT of them\n");
+    printf("\t\t\t(system defaults for those left out)\n");
+    printf("\t-metrics NAME\tpublish the byte, error, queue and latency counters\n");
+    printf("\t\t\tand the sessions in /dev/shm/NAME (or NAME, if it\n");
+    printf("\t\t\thas a directory) every second, for pint-stat to read\n");
+    printf("\nWhen neither stdin nor stdout is a terminal and -batch is not given,\n");
+    printf("pint works like netcat: bytes are passed unmodified between stdio and\n");
+    printf("the socket, and the escape sequences and Enter modes do not apply.\n");
 
     printf("\nRuntime keybindings:\n");
     printf("\t- The formatting mode of the Bytes received -window may be toggled\n");
@@ -72,6 +166,11 @@ void show_usage()
     printf("\tby pressing F2 key.\n");
     printf("\t- Enter key behaviour mode may be toggled by pressing F3 key.\n");
     printf("\t- Stdin input interpretation mode may toggled by pressing F4 key.\n");
+    printf("\t- PgUp and PgDn scroll back and forth through the whole history\n");
+    printf("\tof the Bytes received -window; F5 switches them to the Bytes\n");
+    printf("\tsent -window and back.\n");
+    printf("\t- In TCP listen mode every client gets a session of its own, with\n");
+    printf("\tits own history; F6 switches between the sessions.\n");
 
     printf("\nUsing the escaped stdin input interpretation mode\n");
     printf("\nEscaped stdin input interpretation mode is a powerful tool especially");
@@ -79,88 +178,472 @@ void show_usage()
     printf("\nescape sequences may be applied:\n\n");
     printf("\t\\xHH\t\tsends arbitrary byte with value of HH, in hex.\n");
     printf("\t\t\tFor example, \\xff would send the byte 0xff (-1)\n\n");
+    printf("\t\\f{path}\tsends the file at path (TCP only). The file goes\n");
+    printf("\t\t\tstraight from the page cache to the socket, and the\n");
+    printf("\t\t\tBytes sent -window shows its size, throughput and\n");
+    printf("\t\t\tCRC-32 instead of its bytes\n\n");
 }
 
 /*
- * Handles a switch from command line
+ * Parses a numeric switch argument. Exits with an error message if
+ * the argument is missing or not a number.
  */
-void handle_switch(char *s)
+int parse_switch_number(char *s, char *arg)
 {
+    char *endptr;
+    int value;
+
+    if (arg == NULL)
+    {
+        printf("Missing argument for -%s\n", s);
+        finish(0);
+    }
+
+    value = strtol(arg, &endptr, 10);
+    if ((*endptr != '\0') || (value < 0))
+    {
+        printf("Bad value for -%s: %s\n", s, arg);
+        finish(0);
+    }
+
+    return value;
+}
+
+/*
+ * Parses a byte size switch argument with an optional K, M or G
+ * suffix. Exits with an error message if the argument is bad.
+ */
+long long parse_switch_size(char *s, char *arg)
+{
+    char *endptr;
+    long long value;
+
+    if (arg == NULL)
+    {
+        printf("Missing argument for -%s\n", s);
+        finish(0);
+    }
+
+    value = strtoll(arg, &endptr, 10);
+    switch (*endptr)
+    {
+    case 'k':
+    case 'K':
+        value *= 1024;
+        endptr++;
+        break;
+    case 'm':
+    case 'M':
+        value *= 1024 * 1024;
+        endptr++;
+        break;
+    case 'g':
+    case 'G':
+        value *= 1024 * 1024 * 1024;
+        endptr++;
+        break;
+    }
+
+    if ((*endptr != '\0') || (value <= 0))
+    {
+        printf("Bad value for -%s: %s\n", s, arg);
+        finish(0);
+    }
+
+    return value;
+}
+
+/*
+ * Parses the IDLE[,INTVL[,CNT]] argument of -keepalive into params;
+ * what is left out stays 0. Exits with an error message if the
+ * argument is bad.
+ */
+void parse_keepalive(char *s, char *arg, int *params)
+{
+    char *p, *endptr;
+    int i;
+
+    if (arg == NULL)
+    {
+        printf("Missing argument for -%s\n", s);
+        finish(0);
+    }
+
+    p = arg;
+    for (i = 0; i < 3; i++)
+    {
+        params[i] = strtol(p, &endptr, 10);
+        if ((endptr == p) || (params[i] <= 0) ||
+            ((*endptr != '\0') && ((*endptr != ',') || (i == 2))))
+        {
+            printf("Bad value for -%s: %s\n", s, arg);
+            finish(0);
+        }
+
+        if (*endptr == '\0')
+        {
+            break;
+        }
+        p = endptr + 1;
+    }
+}
+
+/*
+ * Handles a switch from command line. arg and arg2 are the next two
+ * command line arguments, or NULL if there are none.
+ *
+ * Returns the number of arguments consumed besides the switch itself.
+ */
+int handle_switch(char *s, char *arg, char *arg2)
+{
+    char *endptr;
+
     if (strcmp(s, "l") == 0)
     {
         cmdline_params.switches |= SWITCH_LISTEN_MASK;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "sp") == 0)
     {
         cmdline_params.stdin_interp_mode = STDIN_INTERP_PLAIN_TEXT;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "se") == 0)
     {
         cmdline_params.stdin_interp_mode = STDIN_INTERP_ESCAPED;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "en") == 0)
     {
         cmdline_params.enter_behaviour_mode = ENTER_SENDS_NOTHING;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "ec") == 0)
     {
         cmdline_params.enter_behaviour_mode = ENTER_SENDS_CRLF;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "sow") == 0)
     {
         cmdline_params.sock_out_format = FORMATTER_WIDE;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "sop") == 0)
     {
         cmdline_params.sock_out_format = FORMATTER_TEXT;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "soh") == 0)
     {
         cmdline_params.sock_out_format = FORMATTER_HEX;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "siw") == 0)
     {
         cmdline_params.sock_in_format = FORMATTER_WIDE;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "sip") == 0)
     {
         cmdline_params.sock_in_format = FORMATTER_TEXT;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "sih") == 0)
     {
         cmdline_params.sock_in_format = FORMATTER_HEX;
-        return;
+        return 0;
     }
 
     if (strcmp(s, "udp") == 0)
     {
         cmdline_params.socket_type = SOCKTYPE_UDP;
-        return;
+        return 0;
+    }
+
+    if (strcmp(s, "fps") == 0)
+    {
+        cmdline_params.frame_rate = parse_switch_number(s, arg);
+        return 1;
+    }
+
+    if (strcmp(s, "batch") == 0)
+    {
+        cmdline_params.switches |= SWITCH_BATCH_MASK;
+        return 0;
+    }
+
+    if (strcmp(s, "out") == 0)
+    {
+        if (arg == NULL)
+        {
+            printf("Missing argument for -%s\n", s);
+            finish(0);
+        }
+        cmdline_params.switches |= SWITCH_BATCH_MASK;
+        cmdline_params.output_file = arg;
+        return 1;
+    }
+
+    if (strcmp(s, "history") == 0)
+    {
+        cmdline_params.history_size = parse_switch_size(s, arg);
+        return 1;
+    }
+
+    if (strcmp(s, "io") == 0)
+    {
+        if ((arg != NULL) && (strcmp(arg, "epoll") == 0))
+        {
+            cmdline_params.io_backend = IO_BACKEND_EPOLL;
+        }
+        else if ((arg != NULL) && (strcmp(arg, "select") == 0))
+        {
+            cmdline_params.io_backend = IO_BACKEND_SELECT;
+        }
+        else if ((arg != NULL) && (strcmp(arg, "uring") == 0))
+        {
+            cmdline_params.io_backend = IO_BACKEND_URING;
+        }
+        else
+        {
+            printf("Bad value for -%s: %s\n", s, (arg != NULL) ? arg : "");
+            finish(0);
+        }
+        return 1;
+    }
+
+    if (strcmp(s, "cork") == 0)
+    {
+        cmdline_params.switches |= SWITCH_CORK_MASK;
+        return 0;
+    }
+
+    if (strcmp(s, "mode") == 0)
+    {
+        if ((arg == NULL) || ((cmdline_params.server_mode = parse_server_mode(arg)) == -1))
+        {
+            printf("Bad value for -%s: %s\n", s, (arg != NULL) ? arg : "");
+            finish(0);
+        }
+        return 1;
+    }
+
+    if (strcmp(s, "record") == 0)
+    {
+        if (arg == NULL)
+        {
+            printf("Missing argument for -%s\n", s);
+            finish(0);
+        }
+        cmdline_params.record_file = arg;
+        return 1;
+    }
+
+    if (strcmp(s, "pcapng") == 0)
+    {
+        if (arg == NULL)
+        {
+            printf("Missing argument for -%s\n", s);
+            finish(0);
+        }
+        cmdline_params.pcapng_file = arg;
+        return 1;
+    }
+
+    if (strcmp(s, "convert") == 0)
+    {
+        if (arg == NULL)
+        {
+            printf("Missing argument for -%s\n", s);
+            finish(0);
+        }
+        cmdline_params.convert_file = arg;
+        return 1;
+    }
+
+    if (strcmp(s, "replay") == 0)
+    {
+        if (arg == NULL)
+        {
+            printf("Missing argument for -%s\n", s);
+            finish(0);
+        }
+        cmdline_params.switches |= SWITCH_BATCH_MASK;
+        cmdline_params.replay_file = arg;
+        return 1;
+    }
+
+    if (strcmp(s, "speed") == 0)
+    {
+        if ((arg != NULL) && (strcmp(arg, "max") == 0))
+        {
+            cmdline_params.replay_speed = 0;
+            return 1;
+        }
+
+        if ((arg == NULL) ||
+            ((cmdline_params.replay_speed = strtod(arg, &endptr)) <= 0) ||
+            (*endptr != '\0'))
+        {
+            printf("Bad value for -%s: %s\n", s, (arg != NULL) ? arg : "");
+            finish(0);
+        }
+        return 1;
+    }
+
+    if (strcmp(s, "session") == 0)
+    {
+        cmdline_params.replay_session = parse_switch_number(s, arg);
+        return 1;
+    }
+
+    if (strcmp(s, "view") == 0)
+    {
+        if (arg == NULL)
+        {
+            printf("Missing argument for -%s\n", s);
+            finish(0);
+        }
+        cmdline_params.view_file = arg;
+        return 1;
+    }
+
+    if (strcmp(s, "diff") == 0)
+    {
+        if (arg2 == NULL)
+        {
+            printf("Missing arguments for -%s\n", s);
+            finish(0);
+        }
+        cmdline_params.diff_files[0] = arg;
+        cmdline_params.diff_files[1] = arg2;
+        return 2;
+    }
+
+    if (strcmp(s, "load") == 0)
+    {
+        if ((cmdline_params.load_connections = parse_switch_number(s, arg)) == 0)
+        {
+            printf("Bad value for -%s: %s\n", s, arg);
+            finish(0);
+        }
+        return 1;
+    }
+
+    if (strcmp(s, "request") == 0)
+    {
+        if (arg == NULL)
+        {
+            printf("Missing argument for -%s\n", s);
+            finish(0);
+        }
+        cmdline_params.load_request = arg;
+        return 1;
+    }
+
+    if (strcmp(s, "rdelim") == 0)
+    {
+        if (arg == NULL)
+        {
+            printf("Missing argument for -%s\n", s);
+            finish(0);
+        }
+        cmdline_params.load_delimiter = arg;
+        return 1;
+    }
+
+    if (strcmp(s, "rlen") == 0)
+    {
+        cmdline_params.load_length = parse_switch_size(s, arg);
+        return 1;
+    }
+
+    if (strcmp(s, "requests") == 0)
+    {
+        cmdline_params.load_requests = parse_switch_number(s, arg);
+        return 1;
+    }
+
+    if (strcmp(s, "duration") == 0)
+    {
+        if ((arg == NULL) ||
+            ((cmdline_params.duration = strtod(arg, &endptr)) <= 0) ||
+            (*endptr != '\0'))
+        {
+            printf("Bad value for -%s: %s\n", s, (arg != NULL) ? arg : "");
+            finish(0);
+        }
+        return 1;
+    }
+
+    if (strcmp(s, "throughput") == 0)
+    {
+        cmdline_params.throughput = TRUE;
+        return 0;
+    }
+
+    if (strcmp(s, "sndbuf") == 0)
+    {
+        cmdline_params.sndbuf = parse_switch_size(s, arg);
+        return 1;
+    }
+
+    if (strcmp(s, "rcvbuf") == 0)
+    {
+        cmdline_params.rcvbuf = parse_switch_size(s, arg);
+        return 1;
+    }
+
+    if (strcmp(s, "nodelay") == 0)
+    {
+        cmdline_params.nodelay = TRUE;
+        return 0;
+    }
+
+    if (strcmp(s, "quickack") == 0)
+    {
+        cmdline_params.quickack = TRUE;
+        return 0;
+    }
+
+    if (strcmp(s, "notsent") == 0)
+    {
+        cmdline_params.notsent_lowat = parse_switch_size(s, arg);
+        return 1;
+    }
+
+    if (strcmp(s, "keepalive") == 0)
+    {
+        cmdline_params.keepalive = TRUE;
+        parse_keepalive(s, arg, cmdline_params.keepalive_params);
+        return 1;
+    }
+
+    if (strcmp(s, "metrics") == 0)
+    {
+        if (arg == NULL)
+        {
+            printf("Missing argument for -%s\n", s);
+            finish(0);
+        }
+        cmdline_params.metrics_name = arg;
+        return 1;
     }
 
     /* no such switch found: show usage */
     show_usage();
     finish(0);
+    return 0;
 }
 
 /*
@@ -175,6 +658,9 @@ void parse_commandline_args(int argc, char **argv)
     char *cur_arg;
 
     memset(&cmdline_params, 0, sizeof(cmdline_params));
+    cmdline_params.frame_rate = DEFAULT_FRAME_RATE;
+    cmdline_params.history_size = DEFAULT_HISTORY_SIZE;
+    cmdline_params.replay_speed = 1.0;
 
     for (i = 1; i < argc; i++)
     {
@@ -188,7 +674,8 @@ void parse_commandline_args(int argc, char **argv)
                 printf("Bad switch: %s\n", cur_arg);
                 finish(0);
             }
-            handle_switch(&cur_arg[1]);
+            i += handle_switch(&cur_arg[1], (i + 1 < argc) ? argv[i + 1] : NULL,
+                               (i + 2 < argc) ? argv[i + 2] : NULL);
             continue;
         }
 
@@ -236,10 +723,110 @@ void parse_commandline_args(int argc, char **argv)
     }
 
     /* validate arguments */
+    if ((cmdline_params.convert_file != NULL) &&
+        (cmdline_params.pcapng_file == NULL))
+    {
+        printf("-convert needs -pcapng\n");
+        finish(0);
+    }
+
     if ((cmdline_params.remote_host[0] == 0) &&
-        (cmdline_params.listen_port == 0))
+        (cmdline_params.listen_port == 0) &&
+        (cmdline_params.convert_file == NULL) &&
+        (cmdline_params.view_file == NULL) &&
+        (cmdline_params.diff_files[0] == NULL))
     {
         show_usage();
         finish(0);
     }
+
+    if ((cmdline_params.server_mode != SERVER_MODE_NONE) &&
+        !(cmdline_params.switches & SWITCH_LISTEN_MASK))
+    {
+        printf("-mode needs listen mode (-l)\n");
+        finish(0);
+    }
+
+    if ((cmdline_params.server_mode != SERVER_MODE_NONE) &&
+        ((cmdline_params.record_file != NULL) || (cmdline_params.pcapng_file != NULL)))
+    {
+        printf("-record and -pcapng can't be used with -mode\n");
+        finish(0);
+    }
+
+    if ((cmdline_params.replay_file != NULL) &&
+        ((cmdline_params.switches & SWITCH_LISTEN_MASK) ||
+         (cmdline_params.record_file != NULL) || (cmdline_params.pcapng_file != NULL)))
+    {
+        printf("-replay needs a remote host, and can't be used with -record or -pcapng\n");
+        finish(0);
+    }
+
+    if ((cmdline_params.load_connections == 0) &&
+        ((cmdline_params.load_request != NULL) || (cmdline_params.load_delimiter != NULL) ||
+         (cmdline_params.load_length != 0) || (cmdline_params.load_requests != 0)))
+    {
+        printf("-request, -rlen, -rdelim and -requests need -load\n");
+        finish(0);
+    }
+
+    if ((cmdline_params.duration != 0) && (cmdline_params.load_connections == 0) &&
+        !cmdline_params.throughput)
+    {
+        printf("-duration needs -load or -throughput\n");
+        finish(0);
+    }
+
+    if ((cmdline_params.load_connections > 0) &&
+        ((cmdline_params.load_request == NULL) ||
+         ((cmdline_params.load_length != 0) && (cmdline_params.load_delimiter != NULL))))
+    {
+        printf("-load needs -request, and takes -rlen or -rdelim but not both\n");
+        finish(0);
+    }
+
+    if ((cmdline_params.load_connections > 0) &&
+        ((cmdline_params.switches & SWITCH_LISTEN_MASK) || (cmdline_params.replay_file != NULL) ||
+         (cmdline_params.record_file != NULL) || (cmdline_params.pcapng_file != NULL)))
+    {
+        printf("-load needs a remote host, and can't be used with -replay, -record or -pcapng\n");
+        finish(0);
+    }
+
+    if (cmdline_params.throughput &&
+        ((cmdline_params.socket_type != SOCKTYPE_TCP) ||
+         (cmdline_params.server_mode != SERVER_MODE_NONE) ||
+         (cmdline_params.load_connections > 0) || (cmdline_params.replay_file != NULL) ||
+         (cmdline_params.record_file != NULL) || (cmdline_params.pcapng_file != NULL)))
+    {
+        printf("-throughput needs TCP, and can't be used with -mode, -load, -replay,\n"
+               "-record or -pcapng\n");
+        finish(0);
+    }
+
+    if ((cmdline_params.view_file != NULL) &&
+        ((cmdline_params.switches & (SWITCH_LISTEN_MASK | SWITCH_BATCH_MASK)) ||
+         (cmdline_params.record_file != NULL) || (cmdline_params.pcapng_file != NULL) ||
+         (cmdline_params.load_connections > 0) || cmdline_params.throughput))
+    {
+        printf("-view can't be used with -l, -batch, -replay, -record, -pcapng, -load\n"
+               "or -throughput\n");
+        finish(0);
+    }
+
+    if ((cmdline_params.socket_type != SOCKTYPE_TCP) &&
+        (cmdline_params.nodelay || cmdline_params.quickack ||
+         (cmdline_params.notsent_lowat != 0) || cmdline_params.keepalive))
+    {
+        printf("-nodelay, -quickack, -notsent and -keepalive need TCP\n");
+        finish(0);
+    }
+
+    if ((cmdline_params.metrics_name != NULL) &&
+        ((cmdline_params.view_file != NULL) || (cmdline_params.diff_files[0] != NULL) ||
+         (cmdline_params.convert_file != NULL)))
+    {
+        printf("-metrics can't be used with -view, -diff or -convert\n");
+        finish(0);
+    }
 }
@@ -23,11 +23,16 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <string.h>
 #include <ncurses.h>
 #include <sys/ioctl.h>
+#include <sys/time.h>
 
 #include "../include/curses.h"
 #include "../include/pint.h"
+#include "../include/formatters.h"
+#include "../include/history.h"
+#include "../include/viewport.h"
 
 /* misc variables */
 bool curses_initialized = FALSE;
@@ -40,15 +45,31 @@ WINDOW *info_wnd_frame = NULL;
 WINDOW *sock_in_wnd = NULL;
 WINDOW *sock_out_wnd = NULL;
 WINDOW *info_wnd = NULL;
+WINDOW *stats_wnd = NULL;
 
 /* window dimensions */
 int sock_in_wnd_cols, sock_in_wnd_rows;
 int sock_out_wnd_cols, sock_out_wnd_rows;
 int info_wnd_cols, info_wnd_rows;
+int stats_wnd_rows = 0;
 
-/* linewrap data for sock_in/sock_out windows */
-int sock_out_linelen;
-int sock_in_linelen;
+/* title of the info window */
+char info_title[128] = "Info";
+
+/* the byte streams shown in sock_in/sock_out windows; NULL until
+   there is a connection to show */
+viewport *sock_in_view = NULL;
+viewport *sock_out_view = NULL;
+
+/* connection shown, added to the title of the sock_in window */
+char session_title[128] = "";
+
+/* frame coalescing: windows are only marked dirty when written to and
+   flushed to the terminal at most once per frame interval */
+int dirty_windows = 0;
+long frame_interval_usec = 1000000 / DEFAULT_FRAME_RATE;
+long last_frame_sec = 0;
+long last_frame_usec = 0;
 
 /*
  * Retrieves the size of the current terminal window.
@@ -71,78 +92,233 @@ void get_term_size(int *rows, int *cols)
 }
 
 /*
- * Writes a string to info window.
+ * Sets the maximum number of frames per second drawn to the terminal.
+ * A value of 0 or less disables the cap.
  */
-void write_info_wnd(char *s)
+void set_frame_rate(int fps)
 {
-    wprintw(info_wnd, s);
+    if (fps > 0)
+    {
+        frame_interval_usec = 1000000 / fps;
+    }
+    else
+    {
+        frame_interval_usec = 0;
+    }
+}
 
-    wrefresh(info_wnd_frame);
-    wrefresh(info_wnd);
+/*
+ * Marks windows (a mask of DIRTY_* bits) to be flushed on the next frame.
+ */
+void mark_dirty(int mask)
+{
+    dirty_windows |= mask;
 }
 
 /*
- * Clears and resets the sock_out window.
+ * Returns the number of microseconds until the next frame may be drawn,
+ * or -1 if there is nothing to draw.
  */
-void clear_sock_out_wnd()
+long render_delay_usec()
 {
-    wclear(sock_out_wnd);
-    wrefresh(sock_out_wnd);
-    sock_out_linelen = 0;
+    struct timeval tv;
+    long elapsed;
+
+    if (!dirty_windows)
+    {
+        return -1;
+    }
+
+    gettimeofday(&tv, NULL);
+    elapsed = (tv.tv_sec - last_frame_sec) * 1000000 +
+              (tv.tv_usec - last_frame_usec);
+
+    if ((elapsed < 0) || (elapsed >= frame_interval_usec))
+    {
+        return 0;
+    }
+
+    return frame_interval_usec - elapsed;
 }
 
 /*
- * Clears and resets the sock_in window.
+ * Draws the border of a socket window with its title, format and
+ * scrollback state.
  */
-void clear_sock_in_wnd()
+void draw_frame_title(WINDOW *frame, char *title, viewport *vp)
 {
-    wclear(sock_in_wnd);
-    wrefresh(sock_in_wnd);
-    sock_in_linelen = 0;
+    char s[128];
+
+    if ((vp == NULL) || (vp->format == NULL))
+    {
+        sprintf(s, " %s ", title);
+    }
+    else if (vp->follow)
+    {
+        sprintf(s, " %s (%s) ", title, vp->format->name);
+    }
+    else
+    {
+        sprintf(s, " %s (%s) - scrolled back to offset %lld, PgDn to return ",
+                title, vp->format->name, vp->top);
+    }
+
+    box(frame, 0, 0);
+    mvwaddnstr(frame, 0, 1, s, getmaxx(frame) - 2);
 }
 
 /*
- * Writes a string to socket input window with linewrapping.
+ * Copies all dirty windows into the virtual screen and updates the
+ * terminal with a single doupdate().
  */
-void write_sock_in_wnd(char *s)
+void flush_curses()
 {
-    int token_len;
+    struct timeval tv;
+    char title[192];
+
+    if (!curses_initialized || !dirty_windows)
+    {
+        return;
+    }
+
+    if (dirty_windows & DIRTY_FRAMES)
+    {
+        if (session_title[0] != '\0')
+        {
+            sprintf(title, "Bytes received - %s", session_title);
+        }
+        else
+        {
+            strcpy(title, "Bytes received");
+        }
+
+        draw_frame_title(sock_in_wnd_frame, title, sock_in_view);
+        draw_frame_title(sock_out_wnd_frame, "Bytes sent", sock_out_view);
+
+        box(info_wnd_frame, 0, 0);
+        mvwprintw(info_wnd_frame, 0, 1, " %.*s ", getmaxx(info_wnd_frame) - 4,
+                  info_title);
+
+        wnoutrefresh(sock_in_wnd_frame);
+        wnoutrefresh(sock_out_wnd_frame);
+        wnoutrefresh(info_wnd_frame);
+
+        /* the frames were copied over the windows inside them */
+        touchwin(info_wnd);
+        dirty_windows |= DIRTY_SOCK_IN | DIRTY_SOCK_OUT | DIRTY_INFO;
+    }
+
+    if (dirty_windows & DIRTY_SOCK_IN)
+    {
+        if (sock_in_view != NULL)
+        {
+            viewport_render(sock_in_view, sock_in_wnd);
+        }
+        else
+        {
+            werase(sock_in_wnd);
+        }
+        wnoutrefresh(sock_in_wnd);
+    }
+
+    if (dirty_windows & DIRTY_SOCK_OUT)
+    {
+        if (sock_out_view != NULL)
+        {
+            viewport_render(sock_out_view, sock_out_wnd);
+        }
+        else
+        {
+            werase(sock_out_wnd);
+        }
+        wnoutrefresh(sock_out_wnd);
+    }
 
-    token_len = strlen(s);
-    if ((sock_in_wnd_cols - sock_in_linelen) < token_len)
+    if ((dirty_windows & DIRTY_STATS) && (stats_wnd_rows > 0))
     {
-        wprintw(sock_in_wnd, "\n");
-        sock_in_linelen = 0;
+        wnoutrefresh(stats_wnd);
     }
 
-    sock_in_linelen += token_len;
+    /* info window last so that the cursor stays on the input line */
+    if (dirty_windows & DIRTY_INFO)
+    {
+        wnoutrefresh(info_wnd);
+    }
+
+    doupdate();
 
-    wprintw(sock_in_wnd, s);
+    dirty_windows = 0;
+    gettimeofday(&tv, NULL);
+    last_frame_sec = tv.tv_sec;
+    last_frame_usec = tv.tv_usec;
+}
 
-    wrefresh(sock_in_wnd_frame);
-    wrefresh(sock_in_wnd);
+/*
+ * Draws a frame if there are dirty windows and the frame interval
+ * has passed since the previous one.
+ */
+void render_frame()
+{
+    if (render_delay_usec() == 0)
+    {
+        flush_curses();
+    }
 }
 
 /*
- * Writes a string to socket output window with linewrapping.
+ * Shows the given views in the sock_in and sock_out windows, with
+ * title telling which connection they belong to.
  */
-void write_sock_out_wnd(char *s)
+void show_views(viewport *in, viewport *out, char *title)
 {
-    int token_len;
+    sock_in_view = in;
+    sock_out_view = out;
+    snprintf(session_title, sizeof(session_title), "%s", title);
+    mark_dirty(DIRTY_ALL);
+}
 
-    token_len = strlen(s);
-    if ((sock_out_wnd_cols - sock_out_linelen) < token_len)
+/*
+ * Sets the title of the info window.
+ */
+void set_info_title(char *s)
+{
+    if (strcmp(info_title, s) != 0)
     {
-        wprintw(sock_out_wnd, "\n");
-        sock_out_linelen = 0;
+        snprintf(info_title, sizeof(info_title), "%s", s);
+        mark_dirty(DIRTY_FRAMES);
     }
+}
 
-    sock_out_linelen += token_len;
+/*
+ * Writes a string to info window.
+ */
+void write_info_wnd(char *s)
+{
+    /* without curses (batch mode) messages go to stderr */
+    if (!curses_initialized)
+    {
+        fputs(s, stderr);
+        return;
+    }
 
-    wprintw(sock_out_wnd, s);
+    waddstr(info_wnd, s);
+    mark_dirty(DIRTY_INFO);
+}
 
-    wrefresh(sock_out_wnd_frame);
-    wrefresh(sock_out_wnd);
+/*
+ * Writes a line of the stats pane. Without curses there is no pane,
+ * and rows the terminal has no room for are not shown.
+ */
+void write_stats_wnd(int row, char *s)
+{
+    if (!curses_initialized || (row >= stats_wnd_rows))
+    {
+        return;
+    }
+
+    mvwaddnstr(stats_wnd, row, 1, s, getmaxx(stats_wnd) - 2);
+    wclrtoeol(stats_wnd);
+    mark_dirty(DIRTY_STATS);
 }
 
 /*
@@ -154,14 +330,28 @@ void resize_curses()
 
     get_term_size(&rows, &cols);
 
+    /* let curses know the new size; otherwise windows cannot be moved
+       or grown past the original screen */
+    resizeterm(rows, cols);
+
     clear();
     refresh();
 
     /* calculate new dimensions */
     sock_in_wnd_cols = sock_out_wnd_cols = info_wnd_cols = cols - 2;
-    h = 0.4 * rows;
+    h = 0.4 * (rows - STATS_WND_ROWS);
     sock_in_wnd_rows = sock_out_wnd_rows = h - 2;
     info_h = rows - 2 * h;
+    stats_wnd_rows = info_h - INFO_WND_MIN_ROWS;
+    if (stats_wnd_rows > STATS_WND_ROWS)
+    {
+        stats_wnd_rows = STATS_WND_ROWS;
+    }
+    else if (stats_wnd_rows < 0)
+    {
+        stats_wnd_rows = 0;
+    }
+    info_h -= stats_wnd_rows;
     info_wnd_rows = info_h - 2;
 
     /* move & resize windows */
@@ -244,24 +434,30 @@ void resize_curses()
 
     wsetscrreg(info_wnd, 0, info_wnd_rows);
 
-    /* decorate window frames */
-    box(sock_in_wnd_frame, 0, 0);
-    mvwaddstr(sock_in_wnd_frame, 0, 2, "Bytes received");
-
-    box(sock_out_wnd_frame, 0, 0);
-    mvwaddstr(sock_out_wnd_frame, 0, 2, "Bytes sent");
-
-    box(info_wnd_frame, 0, 0);
-    mvwaddstr(info_wnd_frame, 0, 2, "Info");
+    /* a terminal too short for the pane goes without it */
+    if (stats_wnd_rows > 0)
+    {
+        if (wresize(stats_wnd, stats_wnd_rows, cols) == ERR)
+        {
+            deinit_curses();
+            printf("wresize() failed for stats_wnd\n");
+            finish(-1);
+        }
 
-    wrefresh(sock_in_wnd_frame);
-    wrefresh(sock_in_wnd);
+        if (mvwin(stats_wnd, rows - stats_wnd_rows, 0) == ERR)
+        {
+            deinit_curses();
+            printf("mvwin() failed for stats_wnd\n");
+            finish(-1);
+        }
 
-    wrefresh(sock_out_wnd_frame);
-    wrefresh(sock_out_wnd);
+        /* the screen was cleared under the pane */
+        touchwin(stats_wnd);
+    }
 
-    wrefresh(info_wnd_frame);
-    wrefresh(info_wnd);
+    /* window frames and titles are drawn with the frame update */
+    mark_dirty(DIRTY_ALL);
+    flush_curses();
 }
 
 /*
@@ -281,18 +477,15 @@ void init_curses()
         /* create all windows */
         sock_in_wnd_frame = newwin(4, 4, 0, 0);
         sock_in_wnd = newwin(3, 3, 1, 1);
-        scrollok(sock_in_wnd, TRUE);
 
         sock_out_wnd_frame = newwin(4, 4, 4, 0);
         sock_out_wnd = newwin(3, 3, 5, 1);
-        scrollok(sock_out_wnd, TRUE);
 
         info_wnd_frame = newwin(4, 4, 8, 0);
         info_wnd = newwin(3, 3, 9, 1);
         scrollok(info_wnd, TRUE);
 
-        sock_out_linelen = 0;
-        sock_in_linelen = 0;
+        stats_wnd = newwin(STATS_WND_ROWS, 4, 12, 0);
 
         resize_curses();
     }
@@ -305,6 +498,12 @@ void deinit_curses()
 {
     if (curses_initialized)
     {
+        if (stats_wnd != NULL)
+        {
+            delwin(stats_wnd);
+            stats_wnd = NULL;
+        }
+
         if (info_wnd != NULL)
         {
             delwin(info_wnd);
@@ -0,0 +1,678 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <asm/errno.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/eventloop.h"
+
+/* backend in use */
+event_backend *backend = NULL;
+
+/* handlers indexed by descriptor */
+event_handler *event_handlers = NULL;
+int num_event_handlers = 0;
+
+/* number of registered descriptors the backend cannot watch, eg.
+   regular files with epoll; these are always considered ready */
+int num_unpolled = 0;
+
+/* buffer readers are fed from when the backend only reports readiness */
+unsigned char event_read_buffer[EVENT_READ_BUFFER_SIZE];
+
+/* buffers of a batch of datagrams, allocated with the first datagram
+   reader */
+unsigned char *event_datagram_buffers = NULL;
+
+/* signals routed to the loop, and their callbacks */
+int signal_fd = -1;
+sigset_t signal_mask;
+event_callback signal_callbacks[_NSIG];
+void *signal_data[_NSIG];
+
+/* hooks run before each wait and when there is nothing else to do */
+void (*prepare_hook)() = NULL;
+int (*idle_pending_hook)() = NULL;
+void (*idle_step_hook)() = NULL;
+
+int loop_running = FALSE;
+
+/*
+ * Initializes the loop with the given I/O backend. If io_uring is not
+ * available, epoll is used instead.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int event_loop_init(int io_backend)
+{
+    char msg[512];
+
+    sigemptyset(&signal_mask);
+    memset(signal_callbacks, 0, sizeof(signal_callbacks));
+
+    switch (io_backend)
+    {
+    case IO_BACKEND_SELECT:
+        backend = &select_backend;
+        break;
+    case IO_BACKEND_URING:
+        backend = &uring_backend;
+        break;
+    default:
+        backend = &epoll_backend;
+        break;
+    }
+
+    if (backend->init() == 0)
+    {
+        return 0;
+    }
+
+    if (backend != &uring_backend)
+    {
+        return -1;
+    }
+
+    sprintf(msg, "io_uring not available (%s), using epoll\n", strerror(errno));
+    write_info_wnd(msg);
+
+    backend = &epoll_backend;
+    return backend->init();
+}
+
+/*
+ * Closes the loop's descriptors and unblocks the routed signals.
+ */
+void event_loop_deinit()
+{
+    int fd;
+
+    if (backend == NULL)
+    {
+        return;
+    }
+
+    for (fd = 0; fd < num_event_handlers; fd++)
+    {
+        if ((event_handlers[fd].callback != NULL) &&
+            (event_handlers[fd].source != EVENT_SOURCE_FD))
+        {
+            close(fd);
+        }
+    }
+
+    backend->deinit();
+    backend = NULL;
+
+    free(event_handlers);
+    event_handlers = NULL;
+    num_event_handlers = 0;
+    free(event_datagram_buffers);
+    event_datagram_buffers = NULL;
+    num_unpolled = 0;
+    signal_fd = -1;
+
+    sigprocmask(SIG_UNBLOCK, &signal_mask, NULL);
+    sigemptyset(&signal_mask);
+}
+
+/*
+ * Returns the name of the backend in use.
+ */
+char *event_backend_name()
+{
+    return (backend != NULL) ? backend->name : "none";
+}
+
+/*
+ * Makes room in the handler table for the given descriptor.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int reserve_handler(int fd)
+{
+    event_handler *tmp;
+    int size;
+
+    if (fd < num_event_handlers)
+    {
+        return 0;
+    }
+
+    size = (num_event_handlers > 0) ? num_event_handlers : 16;
+    while (size <= fd)
+    {
+        size *= 2;
+    }
+
+    tmp = (event_handler *)realloc(event_handlers, size * sizeof(event_handler));
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+
+    memset(tmp + num_event_handlers, 0,
+           (size - num_event_handlers) * sizeof(event_handler));
+    event_handlers = tmp;
+    num_event_handlers = size;
+
+    return 0;
+}
+
+/*
+ * Registers a descriptor of the given source kind.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int add_handler(int fd, int source, int events, event_callback callback,
+                event_reader reader, void *data)
+{
+    event_handler *h;
+
+    if (reserve_handler(fd) == -1)
+    {
+        write_info_wnd("out of memory for event handlers\n");
+        return -1;
+    }
+
+    h = &event_handlers[fd];
+    h->source = source;
+    h->events = events;
+    h->polled = TRUE;
+    h->datagrams = FALSE;
+    h->callback = callback;
+    h->reader = reader;
+    h->writer = NULL;
+    h->data = data;
+
+    if (backend->add(fd) == -1)
+    {
+        memset(h, 0, sizeof(event_handler));
+        return -1;
+    }
+
+    if (!h->polled)
+    {
+        num_unpolled++;
+    }
+
+    return 0;
+}
+
+/*
+ * Reads a descriptor registered with event_add_reader() when the
+ * backend reports it readable, and feeds the data to its reader.
+ */
+void read_for_reader(int fd, int events, void *data)
+{
+    int n;
+
+    n = read(fd, event_read_buffer, EVENT_READ_BUFFER_SIZE);
+    if ((n == -1) && ((errno == EAGAIN) || (errno == EINTR)))
+    {
+        return;
+    }
+
+    event_handlers[fd].reader(fd, event_read_buffer, n, data);
+}
+
+/*
+ * Reads a batch of datagrams with a single recvmmsg() when the backend
+ * reports a descriptor registered with event_add_datagram_reader()
+ * readable, and feeds them to its reader one at a time.
+ */
+void read_datagrams_for_reader(int fd, int events, void *data)
+{
+    struct mmsghdr msgs[EVENT_DATAGRAM_BATCH];
+    struct iovec iov[EVENT_DATAGRAM_BATCH];
+    int n, i;
+
+    memset(msgs, 0, sizeof(msgs));
+    for (i = 0; i < EVENT_DATAGRAM_BATCH; i++)
+    {
+        iov[i].iov_base = event_datagram_buffers + i * EVENT_DATAGRAM_SIZE;
+        iov[i].iov_len = EVENT_DATAGRAM_SIZE;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    n = recvmmsg(fd, msgs, EVENT_DATAGRAM_BATCH, MSG_DONTWAIT, NULL);
+    if ((n == -1) && ((errno == EAGAIN) || (errno == EINTR)))
+    {
+        return;
+    }
+
+    if (n == -1)
+    {
+        event_handlers[fd].reader(fd, event_datagram_buffers, -1, data);
+        return;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        /* readers take 0 bytes for the end of file */
+        if (msgs[i].msg_len == 0)
+        {
+            continue;
+        }
+
+        event_handlers[fd].reader(fd, iov[i].iov_base, msgs[i].msg_len, data);
+
+        /* the reader may have removed the descriptor */
+        if (event_handlers[fd].reader == NULL)
+        {
+            return;
+        }
+    }
+}
+
+/*
+ * Starts watching a descriptor. The callback is invoked whenever the
+ * descriptor is ready for any of the given events.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int event_add(int fd, int events, event_callback callback, void *data)
+{
+    return add_handler(fd, EVENT_SOURCE_FD, events, callback, NULL, data);
+}
+
+/*
+ * Starts reading a descriptor. The loop reads the data, so that
+ * backends able to complete reads themselves can do so, and hands it
+ * to the reader. The reader should remove the descriptor at end of
+ * file or on error.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int event_add_reader(int fd, event_reader reader, void *data)
+{
+    return add_handler(fd, EVENT_SOURCE_READER, EVENT_READ, read_for_reader,
+                       reader, data);
+}
+
+/*
+ * Starts reading datagrams from a socket, like event_add_reader() but
+ * with every datagram handed to the reader separately. The readiness
+ * backends read them in batches of EVENT_DATAGRAM_BATCH per system
+ * call; io_uring completes them one by one anyway.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int event_add_datagram_reader(int fd, event_reader reader, void *data)
+{
+    if ((event_datagram_buffers == NULL) &&
+        ((event_datagram_buffers = malloc(EVENT_DATAGRAM_BATCH * EVENT_DATAGRAM_SIZE)) == NULL))
+    {
+        write_info_wnd("out of memory for datagram buffers\n");
+        return -1;
+    }
+
+    if (add_handler(fd, EVENT_SOURCE_READER, EVENT_READ, read_datagrams_for_reader,
+                    reader, data) == -1)
+    {
+        return -1;
+    }
+    event_handlers[fd].datagrams = TRUE;
+
+    return 0;
+}
+
+/*
+ * Changes the events watched for a registered descriptor.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int event_modify(int fd, int events)
+{
+    if ((fd >= num_event_handlers) || (event_handlers[fd].callback == NULL))
+    {
+        return -1;
+    }
+
+    if (event_handlers[fd].events == events)
+    {
+        return 0;
+    }
+
+    if (!event_handlers[fd].polled)
+    {
+        /* only unpolled descriptors watched for something keep the
+           loop from blocking */
+        num_unpolled += (events != 0) - (event_handlers[fd].events != 0);
+        event_handlers[fd].events = events;
+        return 0;
+    }
+    event_handlers[fd].events = events;
+
+    return backend->modify(fd);
+}
+
+/*
+ * Sets the callback told when a descriptor registered with
+ * event_add_reader() can be written to, or with NULL, stops watching
+ * for that. Reading goes on as before.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int event_set_writer(int fd, event_callback writer)
+{
+    int events;
+
+    if ((fd >= num_event_handlers) || (event_handlers[fd].callback == NULL))
+    {
+        return -1;
+    }
+
+    event_handlers[fd].writer = writer;
+    events = event_handlers[fd].events & ~EVENT_WRITE;
+    if (writer != NULL)
+    {
+        events |= EVENT_WRITE;
+    }
+
+    return event_modify(fd, events);
+}
+
+/*
+ * Stops watching a descriptor. The descriptor is not closed.
+ */
+void event_remove(int fd)
+{
+    if ((fd >= num_event_handlers) || (event_handlers[fd].callback == NULL))
+    {
+        return;
+    }
+
+    if (event_handlers[fd].polled)
+    {
+        backend->remove(fd);
+    }
+    else if (event_handlers[fd].events != 0)
+    {
+        num_unpolled--;
+    }
+
+    memset(&event_handlers[fd], 0, sizeof(event_handler));
+}
+
+/*
+ * Reads the queued signals and calls their callbacks.
+ */
+void dispatch_signals(int fd, int events, void *data)
+{
+    struct signalfd_siginfo info;
+    int sig;
+
+    while (read(fd, &info, sizeof(info)) == sizeof(info))
+    {
+        sig = info.ssi_signo;
+        if ((sig < _NSIG) && (signal_callbacks[sig] != NULL))
+        {
+            signal_callbacks[sig](sig, 0, signal_data[sig]);
+        }
+    }
+}
+
+/*
+ * Routes a signal to the loop: the signal is blocked and delivered
+ * through a signalfd, so its callback runs in normal context.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int event_add_signal(int sig, event_callback callback, void *data)
+{
+    char msg[512];
+
+    signal_callbacks[sig] = callback;
+    signal_data[sig] = data;
+
+    sigaddset(&signal_mask, sig);
+    sigprocmask(SIG_BLOCK, &signal_mask, NULL);
+
+    if (signal_fd != -1)
+    {
+        /* update the set of signals of the existing descriptor */
+        if (signalfd(signal_fd, &signal_mask, 0) == -1)
+        {
+            sprintf(msg, "signalfd() failed (%s)\n", strerror(errno));
+            write_info_wnd(msg);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    signal_fd = signalfd(-1, &signal_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd == -1)
+    {
+        sprintf(msg, "signalfd() failed (%s)\n", strerror(errno));
+        write_info_wnd(msg);
+        return -1;
+    }
+
+    if (add_handler(signal_fd, EVENT_SOURCE_SIGNAL, EVENT_READ,
+                    dispatch_signals, NULL, NULL) == -1)
+    {
+        close(signal_fd);
+        signal_fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Creates a timer. The timer is disarmed until set with event_set_timer().
+ *
+ * Returns the timer descriptor, or -1 on error
+ */
+int event_add_timer(event_callback callback, void *data)
+{
+    int fd;
+    char msg[512];
+
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd == -1)
+    {
+        sprintf(msg, "timerfd_create() failed (%s)\n", strerror(errno));
+        write_info_wnd(msg);
+        return -1;
+    }
+
+    if (add_handler(fd, EVENT_SOURCE_TIMER, EVENT_READ, callback, NULL, data) == -1)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/*
+ * Arms a timer to expire once after usec microseconds; 0 disarms it.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int event_set_timer(int fd, long usec)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = usec / 1000000;
+    its.it_value.tv_nsec = (usec % 1000000) * 1000;
+
+    return timerfd_settime(fd, 0, &its, NULL);
+}
+
+/*
+ * Sets a function to be called before each wait for events.
+ */
+void event_set_prepare(void (*prepare)())
+{
+    prepare_hook = prepare;
+}
+
+/*
+ * Sets background work: while pending() returns TRUE, the loop only
+ * polls for events and calls step() whenever none are ready.
+ */
+void event_set_idle(int (*pending)(), void (*step)())
+{
+    idle_pending_hook = pending;
+    idle_step_hook = step;
+}
+
+/*
+ * Calls the callback of a descriptor the backend found ready for the
+ * given events.
+ */
+void event_dispatch(int fd, int events)
+{
+    event_handler *h;
+    uint64_t expirations;
+
+    /* the handler may have been removed by an earlier callback */
+    if ((fd >= num_event_handlers) || (event_handlers[fd].callback == NULL))
+    {
+        return;
+    }
+    h = &event_handlers[fd];
+
+    if (h->source == EVENT_SOURCE_TIMER)
+    {
+        /* consume the expiration count */
+        if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        {
+            return;
+        }
+    }
+
+    events &= h->events;
+    if ((events & EVENT_WRITE) && (h->writer != NULL))
+    {
+        h->writer(fd, EVENT_WRITE, h->data);
+        events &= ~EVENT_WRITE;
+
+        /* the writer may have removed the descriptor */
+        if (event_handlers[fd].callback == NULL)
+        {
+            return;
+        }
+        h = &event_handlers[fd];
+    }
+
+    if (events)
+    {
+        h->callback(fd, events, h->data);
+    }
+}
+
+/*
+ * Hands data the backend read from a descriptor to its reader.
+ */
+void event_deliver(int fd, unsigned char *buf, int n)
+{
+    if ((fd >= num_event_handlers) || (event_handlers[fd].reader == NULL))
+    {
+        return;
+    }
+
+    /* an empty datagram is not the end of file */
+    if ((n == 0) && event_handlers[fd].datagrams)
+    {
+        return;
+    }
+
+    event_handlers[fd].reader(fd, buf, n, event_handlers[fd].data);
+}
+
+/*
+ * Runs the loop until event_loop_stop() is called.
+ */
+void event_loop_run()
+{
+    int fd, n, timeout, idle;
+    char msg[512];
+
+    loop_running = TRUE;
+    while (loop_running)
+    {
+        if (prepare_hook != NULL)
+        {
+            prepare_hook();
+        }
+
+        idle = ((idle_pending_hook != NULL) && idle_pending_hook());
+        timeout = (idle || (num_unpolled > 0)) ? 0 : -1;
+
+        n = backend->wait(timeout);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            sprintf(msg, "waiting for events failed (%s)\n", strerror(errno));
+            write_info_wnd(msg);
+            break;
+        }
+
+        if ((n == 0) && idle)
+        {
+            idle_step_hook();
+        }
+
+        for (fd = 0; (fd < num_event_handlers) && (num_unpolled > 0) && loop_running; fd++)
+        {
+            if ((event_handlers[fd].callback != NULL) && !event_handlers[fd].polled)
+            {
+                event_dispatch(fd, EVENT_READ | EVENT_WRITE);
+            }
+        }
+    }
+}
+
+/*
+ * Makes event_loop_run() return after the current callback.
+ */
+void event_loop_stop()
+{
+    loop_running = FALSE;
+}
@@ -0,0 +1,184 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <asm/errno.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/eventloop.h"
+
+/* epoll instance */
+int epoll_fd = -1;
+
+/*
+ * Creates the epoll instance.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int epoll_init()
+{
+    char msg[512];
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1)
+    {
+        sprintf(msg, "epoll_create1() failed (%s)\n", strerror(errno));
+        write_info_wnd(msg);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Closes the epoll instance.
+ */
+void epoll_deinit()
+{
+    if (epoll_fd != -1)
+    {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+}
+
+/*
+ * Fills in the epoll event for a registered descriptor.
+ */
+void epoll_event_for(int fd, struct epoll_event *ev)
+{
+    memset(ev, 0, sizeof(struct epoll_event));
+    ev->data.fd = fd;
+
+    if (event_handlers[fd].events & EVENT_READ)
+    {
+        ev->events |= EPOLLIN;
+    }
+    if (event_handlers[fd].events & EVENT_WRITE)
+    {
+        ev->events |= EPOLLOUT;
+    }
+}
+
+/*
+ * Adds a descriptor to the epoll set. Regular files cannot be watched
+ * by epoll; they never block, so they are marked unpolled instead.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int epoll_add(int fd)
+{
+    struct epoll_event ev;
+    char msg[512];
+
+    epoll_event_for(fd, &ev);
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
+    {
+        if (errno == EPERM)
+        {
+            event_handlers[fd].polled = FALSE;
+            return 0;
+        }
+
+        sprintf(msg, "epoll_ctl() failed for descriptor %d (%s)\n",
+                fd, strerror(errno));
+        write_info_wnd(msg);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Updates the watched events of a descriptor.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int epoll_modify(int fd)
+{
+    struct epoll_event ev;
+
+    epoll_event_for(fd, &ev);
+
+    return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+/*
+ * Removes a descriptor from the epoll set.
+ */
+void epoll_remove(int fd)
+{
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+/*
+ * Waits for events and dispatches them.
+ *
+ * Returns the number of events, or -1 on error
+ */
+int epoll_wait_events(int timeout)
+{
+    struct epoll_event events[EVENT_MAX_EVENTS];
+    int i, n, ready;
+
+    n = epoll_wait(epoll_fd, events, EVENT_MAX_EVENTS, timeout);
+
+    for (i = 0; i < n; i++)
+    {
+        /* errors and hangups are reported to whichever side is
+           watched, so that the callback sees them from read() or
+           write() */
+        ready = 0;
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+        {
+            ready |= EVENT_READ;
+        }
+        if (events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+        {
+            ready |= EVENT_WRITE;
+        }
+
+        event_dispatch(events[i].data.fd, ready);
+    }
+
+    return n;
+}
+
+event_backend epoll_backend =
+{
+    "epoll",
+    epoll_init,
+    epoll_deinit,
+    epoll_add,
+    epoll_modify,
+    epoll_remove,
+    epoll_wait_events
+};
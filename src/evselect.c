@@ -0,0 +1,150 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <asm/errno.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/eventloop.h"
+
+/*
+ * The select() backend keeps no state of its own; the descriptor sets
+ * are built from the handler table on each wait.
+ *
+ * Returns 0
+ */
+int select_init()
+{
+    return 0;
+}
+
+void select_deinit()
+{
+}
+
+/*
+ * Checks that the descriptor fits in an fd_set.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int select_add(int fd)
+{
+    char msg[512];
+
+    if (fd >= FD_SETSIZE)
+    {
+        sprintf(msg, "descriptor %d is too large for select()\n", fd);
+        write_info_wnd(msg);
+        return -1;
+    }
+
+    return 0;
+}
+
+int select_modify(int fd)
+{
+    return 0;
+}
+
+void select_remove(int fd)
+{
+}
+
+/*
+ * Waits for events and dispatches them.
+ *
+ * Returns the number of ready descriptors, or -1 on error
+ */
+int select_wait_events(int timeout)
+{
+    fd_set read_set, write_set;
+    struct timeval tv;
+    int fd, maxfd, n, ready;
+
+    FD_ZERO(&read_set);
+    FD_ZERO(&write_set);
+    maxfd = -1;
+
+    for (fd = 0; fd < num_event_handlers; fd++)
+    {
+        if (event_handlers[fd].callback == NULL)
+        {
+            continue;
+        }
+
+        if (event_handlers[fd].events & EVENT_READ)
+        {
+            FD_SET(fd, &read_set);
+            maxfd = fd;
+        }
+        if (event_handlers[fd].events & EVENT_WRITE)
+        {
+            FD_SET(fd, &write_set);
+            maxfd = fd;
+        }
+    }
+
+    tv.tv_sec = 0;
+    tv.tv_usec = 0;
+
+    n = select(maxfd + 1, &read_set, &write_set, NULL,
+               (timeout == 0) ? &tv : NULL);
+
+    for (fd = 0; (n > 0) && (fd <= maxfd); fd++)
+    {
+        ready = 0;
+        if (FD_ISSET(fd, &read_set))
+        {
+            ready |= EVENT_READ;
+        }
+        if (FD_ISSET(fd, &write_set))
+        {
+            ready |= EVENT_WRITE;
+        }
+
+        if (ready)
+        {
+            event_dispatch(fd, ready);
+        }
+    }
+
+    return n;
+}
+
+event_backend select_backend =
+{
+    "select",
+    select_init,
+    select_deinit,
+    select_add,
+    select_modify,
+    select_remove,
+    select_wait_events
+};
@@ -0,0 +1,684 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <asm/errno.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/eventloop.h"
+
+/* ring descriptor and mappings */
+int uring_fd = -1;
+void *uring_ring = MAP_FAILED;
+size_t uring_ring_size;
+struct io_uring_sqe *uring_sqes = MAP_FAILED;
+size_t uring_sqes_size;
+
+/* submission queue */
+unsigned int *sq_head, *sq_tail, *sq_mask, *sq_array;
+unsigned int sq_entries;
+unsigned int sq_local_tail;
+
+/* completion queue */
+unsigned int *cq_head, *cq_tail, *cq_mask;
+struct io_uring_cqe *uring_cqes;
+
+/* provided buffer ring, and the memory of its buffers */
+struct io_uring_buf_ring *buf_ring = MAP_FAILED;
+unsigned short buf_ring_tail;
+unsigned char *buf_pool = NULL;
+
+/* per descriptor state */
+uring_fd_state *uring_fds = NULL;
+int num_uring_fds = 0;
+
+int sys_io_uring_setup(unsigned int entries, struct io_uring_params *p)
+{
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+int sys_io_uring_enter(int fd, unsigned int to_submit,
+                       unsigned int min_complete, unsigned int flags)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+int sys_io_uring_register(int fd, unsigned int opcode, void *arg, unsigned int nr_args)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/*
+ * Queues a buffer back into the provided buffer ring. The kernel sees
+ * it once the ring tail is published.
+ */
+void uring_recycle_buffer(int bid)
+{
+    struct io_uring_buf *buf;
+
+    buf = &buf_ring->bufs[buf_ring_tail & (URING_BUFFERS - 1)];
+    buf->addr = (unsigned long)(buf_pool + bid * URING_BUFFER_SIZE);
+    buf->len = URING_BUFFER_SIZE;
+    buf->bid = bid;
+    buf_ring_tail++;
+}
+
+/*
+ * Makes the recycled buffers available to the kernel.
+ */
+void uring_publish_buffers()
+{
+    __atomic_store_n(&buf_ring->tail, buf_ring_tail, __ATOMIC_RELEASE);
+}
+
+/*
+ * Releases the ring and its buffers.
+ */
+void uring_deinit()
+{
+    if (uring_fd != -1)
+    {
+        close(uring_fd);
+        uring_fd = -1;
+    }
+
+    if (uring_ring != MAP_FAILED)
+    {
+        munmap(uring_ring, uring_ring_size);
+        uring_ring = MAP_FAILED;
+    }
+
+    if (uring_sqes != MAP_FAILED)
+    {
+        munmap(uring_sqes, uring_sqes_size);
+        uring_sqes = MAP_FAILED;
+    }
+
+    if (buf_ring != MAP_FAILED)
+    {
+        munmap(buf_ring, URING_BUFFERS * sizeof(struct io_uring_buf));
+        buf_ring = MAP_FAILED;
+    }
+
+    free(buf_pool);
+    buf_pool = NULL;
+
+    free(uring_fds);
+    uring_fds = NULL;
+    num_uring_fds = 0;
+}
+
+/*
+ * Sets up the ring and registers the provided buffer ring. Needs
+ * Linux 5.19 or later for buffer rings and multishot receives.
+ *
+ * Returns 0 on success, -1 on error (errno tells the reason)
+ */
+int uring_init()
+{
+    struct io_uring_params p;
+    struct io_uring_buf_reg reg;
+    size_t sq_size, cq_size;
+    unsigned char *ring;
+    int i, err;
+
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+    uring_fd = sys_io_uring_setup(URING_ENTRIES, &p);
+    if ((uring_fd == -1) && (errno == EINVAL))
+    {
+        /* older kernel without the flags */
+        memset(&p, 0, sizeof(p));
+        uring_fd = sys_io_uring_setup(URING_ENTRIES, &p);
+    }
+
+    if (uring_fd == -1)
+    {
+        return -1;
+    }
+
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        uring_deinit();
+        errno = ENOSYS;
+        return -1;
+    }
+
+    sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    uring_ring_size = (sq_size > cq_size) ? sq_size : cq_size;
+    uring_sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    uring_ring = mmap(NULL, uring_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, uring_fd, IORING_OFF_SQ_RING);
+    uring_sqes = mmap(NULL, uring_sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, uring_fd, IORING_OFF_SQES);
+    buf_ring = mmap(NULL, URING_BUFFERS * sizeof(struct io_uring_buf),
+                    PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    buf_pool = (unsigned char *)malloc(URING_BUFFERS * URING_BUFFER_SIZE);
+
+    if ((uring_ring == MAP_FAILED) || (uring_sqes == MAP_FAILED) ||
+        (buf_ring == MAP_FAILED) || (buf_pool == NULL))
+    {
+        err = (buf_pool == NULL) ? ENOMEM : errno;
+        uring_deinit();
+        errno = err;
+        return -1;
+    }
+
+    ring = (unsigned char *)uring_ring;
+    sq_head = (unsigned int *)(ring + p.sq_off.head);
+    sq_tail = (unsigned int *)(ring + p.sq_off.tail);
+    sq_mask = (unsigned int *)(ring + p.sq_off.ring_mask);
+    sq_array = (unsigned int *)(ring + p.sq_off.array);
+    sq_entries = p.sq_entries;
+    cq_head = (unsigned int *)(ring + p.cq_off.head);
+    cq_tail = (unsigned int *)(ring + p.cq_off.tail);
+    cq_mask = (unsigned int *)(ring + p.cq_off.ring_mask);
+    uring_cqes = (struct io_uring_cqe *)(ring + p.cq_off.cqes);
+
+    /* submission entries are used in ring order */
+    for (i = 0; i < sq_entries; i++)
+    {
+        sq_array[i] = i;
+    }
+    sq_local_tail = *sq_tail;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long)buf_ring;
+    reg.ring_entries = URING_BUFFERS;
+    reg.bgid = URING_BUFFER_GROUP;
+    if (sys_io_uring_register(uring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) == -1)
+    {
+        err = errno;
+        uring_deinit();
+        errno = err;
+        return -1;
+    }
+
+    buf_ring_tail = 0;
+    for (i = 0; i < URING_BUFFERS; i++)
+    {
+        uring_recycle_buffer(i);
+    }
+    uring_publish_buffers();
+
+    return 0;
+}
+
+/*
+ * Passes the queued submissions to the kernel, optionally waiting for
+ * at least one completion.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int uring_submit(int wait)
+{
+    unsigned int to_submit;
+
+    __atomic_store_n(sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+    to_submit = sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+
+    if ((to_submit == 0) && !wait)
+    {
+        return 0;
+    }
+
+    if (sys_io_uring_enter(uring_fd, to_submit, wait ? 1 : 0,
+                           wait ? IORING_ENTER_GETEVENTS : 0) == -1)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Returns a cleared submission entry, flushing the queue first if it
+ * is full, or NULL if none could be had.
+ */
+struct io_uring_sqe *uring_get_sqe()
+{
+    struct io_uring_sqe *sqe;
+
+    if (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+    {
+        if ((uring_submit(FALSE) == -1) ||
+            (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries))
+        {
+            write_info_wnd("io_uring submission queue full\n");
+            return NULL;
+        }
+    }
+
+    sqe = &uring_sqes[sq_local_tail & *sq_mask];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sq_local_tail++;
+
+    return sqe;
+}
+
+/*
+ * Returns the user data identifying an operation on a descriptor.
+ */
+uint64_t uring_user_data(int fd, int op)
+{
+    return ((uint64_t)uring_fds[fd].gen << 32) | ((uint64_t)op << 24) | fd;
+}
+
+/*
+ * Queues the operation watching a descriptor: a receive into the
+ * provided buffers for readers (multishot for sockets), otherwise a
+ * poll for the watched events. Polls are one-shot and re-queued after
+ * each completion: a multishot poll only fires on new wakeups, while
+ * callbacks expect to hear again of a descriptor that stays ready, as
+ * they do from the other backends. The writability of a reader is
+ * polled for separately, by uring_arm_write().
+ */
+void uring_arm(int fd)
+{
+    event_handler *h = &event_handlers[fd];
+    uring_fd_state *st = &uring_fds[fd];
+    struct io_uring_sqe *sqe;
+
+    if ((h->source == EVENT_SOURCE_READER) ? !(h->events & EVENT_READ) : (h->events == 0))
+    {
+        return;
+    }
+
+    if ((sqe = uring_get_sqe()) == NULL)
+    {
+        return;
+    }
+    sqe->fd = fd;
+    st->armed = TRUE;
+
+    if ((h->source == EVENT_SOURCE_READER) && !st->waiting)
+    {
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = URING_BUFFER_GROUP;
+        sqe->user_data = uring_user_data(fd, URING_OP_READ);
+
+        if (!st->is_socket)
+        {
+            sqe->opcode = IORING_OP_READ;
+            sqe->off = (uint64_t)-1;
+            sqe->len = URING_BUFFER_SIZE;
+        }
+        else if (st->multishot)
+        {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+        }
+        else
+        {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->len = URING_BUFFER_SIZE;
+        }
+
+        return;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->user_data = uring_user_data(fd, URING_OP_POLL);
+    if (h->events & EVENT_READ)
+    {
+        sqe->poll32_events |= POLLIN;
+    }
+    if ((h->events & EVENT_WRITE) && (h->source != EVENT_SOURCE_READER))
+    {
+        sqe->poll32_events |= POLLOUT;
+    }
+}
+
+/*
+ * Queues a poll for the writability of a reader.
+ */
+void uring_arm_write(int fd)
+{
+    struct io_uring_sqe *sqe;
+
+    if ((sqe = uring_get_sqe()) == NULL)
+    {
+        return;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = uring_user_data(fd, URING_OP_POLL_WRITE);
+    uring_fds[fd].write_polling = TRUE;
+}
+
+/*
+ * Cancels the operations of a descriptor. Their completions, if any
+ * arrive, carry the old generation and are dropped.
+ */
+void uring_cancel(int fd)
+{
+    struct io_uring_sqe *sqe;
+
+    if ((sqe = uring_get_sqe()) != NULL)
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = fd;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = uring_user_data(fd, URING_OP_CANCEL);
+    }
+
+    uring_fds[fd].gen++;
+    uring_fds[fd].armed = FALSE;
+    uring_fds[fd].write_polling = FALSE;
+}
+
+/*
+ * Starts watching a descriptor.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int uring_add(int fd)
+{
+    uring_fd_state *tmp;
+    struct stat st;
+    int size;
+
+    if (fd >= num_uring_fds)
+    {
+        size = (num_uring_fds > 0) ? num_uring_fds : 16;
+        while (size <= fd)
+        {
+            size *= 2;
+        }
+
+        tmp = (uring_fd_state *)realloc(uring_fds, size * sizeof(uring_fd_state));
+        if (tmp == NULL)
+        {
+            write_info_wnd("out of memory for io_uring state\n");
+            return -1;
+        }
+
+        memset(tmp + num_uring_fds, 0, (size - num_uring_fds) * sizeof(uring_fd_state));
+        uring_fds = tmp;
+        num_uring_fds = size;
+    }
+
+    uring_fds[fd].gen++;
+    uring_fds[fd].is_socket = ((fstat(fd, &st) == 0) && S_ISSOCK(st.st_mode));
+    uring_fds[fd].multishot = TRUE;
+    uring_fds[fd].waiting = FALSE;
+    uring_fds[fd].armed = FALSE;
+    uring_fds[fd].write_polling = FALSE;
+
+    uring_arm(fd);
+
+    return 0;
+}
+
+/*
+ * Re-queues the operation of a descriptor for its new events.
+ *
+ * Returns 0
+ */
+int uring_modify(int fd)
+{
+    uring_fd_state *st = &uring_fds[fd];
+
+    if (event_handlers[fd].source == EVENT_SOURCE_READER)
+    {
+        /* cancelling a receive could drop data it has completed, so
+           it is left running; only what is missing gets queued */
+        if (!st->armed)
+        {
+            uring_arm(fd);
+        }
+        if ((event_handlers[fd].events & EVENT_WRITE) && !st->write_polling)
+        {
+            uring_arm_write(fd);
+        }
+        return 0;
+    }
+
+    uring_cancel(fd);
+    uring_fds[fd].waiting = FALSE;
+    uring_arm(fd);
+
+    return 0;
+}
+
+/*
+ * Stops watching a descriptor.
+ */
+void uring_remove(int fd)
+{
+    uring_cancel(fd);
+}
+
+/*
+ * Handles a single completion.
+ *
+ * Returns 1 if it was passed on as an event, 0 otherwise
+ */
+int uring_complete(uint64_t user_data, int res, unsigned int flags)
+{
+    int fd, op, bid, more, events;
+    unsigned int gen;
+    uring_fd_state *st;
+
+    fd = user_data & 0xffffff;
+    op = (user_data >> 24) & 0xff;
+    gen = user_data >> 32;
+    more = flags & IORING_CQE_F_MORE;
+    bid = (flags & IORING_CQE_F_BUFFER) ? (int)(flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+
+    if ((op == URING_OP_CANCEL) || (fd >= num_uring_fds) || (uring_fds[fd].gen != gen))
+    {
+        /* stale completion of a cancelled operation */
+        if (bid >= 0)
+        {
+            uring_recycle_buffer(bid);
+        }
+        return 0;
+    }
+    st = &uring_fds[fd];
+
+    if (op == URING_OP_POLL_WRITE)
+    {
+        st->write_polling = FALSE;
+        if (res < 0)
+        {
+            return 0;
+        }
+
+        event_dispatch(fd, EVENT_WRITE);
+
+        if ((st->gen == gen) && (event_handlers[fd].events & EVENT_WRITE) &&
+            !st->write_polling)
+        {
+            uring_arm_write(fd);
+        }
+        return 1;
+    }
+
+    if (!more)
+    {
+        st->armed = FALSE;
+    }
+
+    if (op == URING_OP_POLL)
+    {
+        if (res < 0)
+        {
+            return 0;
+        }
+
+        if (st->waiting)
+        {
+            /* the reader has data again */
+            st->waiting = FALSE;
+            uring_arm(fd);
+            return 0;
+        }
+
+        events = 0;
+        if (res & (POLLIN | POLLHUP | POLLERR))
+        {
+            events |= EVENT_READ;
+        }
+        if (res & (POLLOUT | POLLHUP | POLLERR))
+        {
+            events |= EVENT_WRITE;
+        }
+
+        event_dispatch(fd, events);
+
+        if (!more && (st->gen == gen) && !st->armed)
+        {
+            uring_arm(fd);
+        }
+        return 1;
+    }
+
+    switch (res)
+    {
+    case -ENOBUFS:
+        /* every buffer was in use; they are back once this batch of
+           completions has been handled */
+        if (!more)
+        {
+            uring_arm(fd);
+        }
+        return 0;
+    case -EAGAIN:
+        /* non-blocking descriptor without data: poll for it first */
+        st->waiting = TRUE;
+        uring_arm(fd);
+        return 0;
+    case -EINVAL:
+        if (st->multishot)
+        {
+            /* multishot receive not supported */
+            st->multishot = FALSE;
+            uring_arm(fd);
+            return 0;
+        }
+        break;
+    case -ECANCELED:
+        return 0;
+    }
+
+    if (res < 0)
+    {
+        errno = -res;
+        event_deliver(fd, NULL, -1);
+    }
+    else
+    {
+        event_deliver(fd, (bid >= 0) ? buf_pool + bid * URING_BUFFER_SIZE : NULL, res);
+    }
+
+    if (bid >= 0)
+    {
+        uring_recycle_buffer(bid);
+    }
+
+    /* a receive ends on an empty datagram as on the end of file, but
+       the socket still has more to read */
+    if (!more && ((res > 0) || event_handlers[fd].datagrams) && (st->gen == gen) &&
+        !st->armed)
+    {
+        uring_arm(fd);
+    }
+
+    return 1;
+}
+
+/*
+ * Submits the queued operations, waits for completions unless timeout
+ * is 0, and handles every completion available.
+ *
+ * Returns the number of events, or -1 on error
+ */
+int uring_wait_events(int timeout)
+{
+    struct io_uring_cqe *cqe;
+    unsigned int head;
+    unsigned short recycled;
+    uint64_t user_data;
+    int n, res, wait;
+    unsigned int flags;
+
+    head = *cq_head;
+    wait = ((timeout != 0) && (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)));
+
+    if ((uring_submit(wait) == -1) && (errno != EBUSY))
+    {
+        return -1;
+    }
+
+    n = 0;
+    recycled = buf_ring_tail;
+    while (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+    {
+        cqe = &uring_cqes[head & *cq_mask];
+        user_data = cqe->user_data;
+        res = cqe->res;
+        flags = cqe->flags;
+
+        /* free the entry before the callbacks queue more work */
+        head++;
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+        n += uring_complete(user_data, res, flags);
+    }
+
+    if (buf_ring_tail != recycled)
+    {
+        uring_publish_buffers();
+    }
+
+    return n;
+}
+
+event_backend uring_backend =
+{
+    "uring",
+    uring_init,
+    uring_deinit,
+    uring_add,
+    uring_modify,
+    uring_remove,
+    uring_wait_events
+};
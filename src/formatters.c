@@ -26,6 +26,10 @@ SOFTWARE.
 #include <string.h>
 #include <ncurses.h>
 
+#ifdef __x86_64__
+#include <tmmintrin.h>
+#endif
+
 #include "../include/formatters.h"
 #include "../include/cmdline.h"
 
@@ -34,117 +38,208 @@ display_format *sock_out_format, *sock_in_format;
 display_format display_formats[NUM_FORMATTERS];
 int sock_out_format_type, sock_in_format_type;
 
+/* precomputed cells for every byte value. The hex and wide tables are
+   padded to 4 and 8 bytes so that a cell can be written with a single
+   store; the next cell then overwrites the padding. */
+char hex_digits[] = "0123456789abcdef";
+unsigned char printable_table[256];
+unsigned char text_table[256];
+unsigned int hex_table[256];
+unsigned long long wide_table[256];
+
+/* hex kernel chosen at init time depending on the cpu */
+int (*hex_kernel)(const unsigned char *, int, char *);
+
 /*
  * Returns TRUE if the byte represents a printable character and
  * not a control code.
- *
- * ##TODO## replace by some decent implementation
  */
 int isprintable(int c)
 {
-  switch (c)
+  return printable_table[c & 0xff];
+}
+
+/*
+ * Wide formatter: "c(hh) " per byte.
+ *
+ * Returns the number of characters written.
+ */
+int wide_formatter(const unsigned char *buf, int len, char *out)
+{
+  int i;
+
+  for (i = 0; i < len; i++)
   {
-  case 10:  /* CR */
-  case 13:  /* LF */
-  case 127: /* backspace */
-  case 9:   /* TAB */
-    return FALSE;
-  default:
-    return TRUE;
+    memcpy(out + i * 6, &wide_table[buf[i]], 8);
   }
+  out[len * 6] = '\0';
+
+  return len * 6;
 }
 
 /*
- * Wide formatter
+ * Text formatter (telnet -like output). Linefeeds are kept, carriage
+ * returns dropped and other control codes shown as dots.
+ *
+ * Returns the number of characters written.
  */
-void wide_formatter(char *pattern, int c, char *token_buf)
+int text_formatter(const unsigned char *buf, int len, char *out)
 {
-  if (isprintable(c))
+  int i;
+  char *p;
+
+  for (i = 0, p = out; i < len; i++)
   {
-    sprintf(token_buf, pattern, c, 2, c);
+    *p = text_table[buf[i]];
+    p += (*p != '\0');
   }
-  else
+  *p = '\0';
+
+  return p - out;
+}
+
+/*
+ * Scalar hex kernel: "hh " per byte.
+ */
+int hex_formatter_scalar(const unsigned char *buf, int len, char *out)
+{
+  int i;
+
+  for (i = 0; i < len; i++)
   {
-    sprintf(token_buf, pattern, ' ', 2, c);
+    memcpy(out + i * 3, &hex_table[buf[i]], 4);
   }
+  out[len * 3] = '\0';
+
+  return len * 3;
 }
 
+#ifdef __x86_64__
 /*
- * Text formatter (telnet -like output)
+ * SSSE3 hex kernel. Converts 16 bytes at a time into nibble digits with
+ * pshufb and spreads them into three 16-byte vectors of "hh " cells.
  */
-void text_formatter(char *pattern, int c, char *token_buf)
+__attribute__((target("ssse3")))
+int hex_formatter_ssse3(const unsigned char *buf, int len, char *out)
 {
-  sprintf(token_buf, pattern, c);
+  const __m128i digits = _mm_loadu_si128((const __m128i *)hex_digits);
+  const __m128i low_mask = _mm_set1_epi8(0x0f);
+  __m128i hi_shuf[3], lo_shuf[3], spaces[3];
+  __m128i in, hi, lo, v;
+  unsigned char hs[16], ls[16], sp[16];
+  int i, k, p;
+
+  /* output byte p of a 48-byte block comes from input byte p / 3:
+     the high nibble, the low nibble or a space */
+  for (k = 0; k < 3; k++)
+  {
+    for (i = 0; i < 16; i++)
+    {
+      p = k * 16 + i;
+      hs[i] = (p % 3 == 0) ? p / 3 : 0x80;
+      ls[i] = (p % 3 == 1) ? p / 3 : 0x80;
+      sp[i] = (p % 3 == 2) ? ' ' : 0;
+    }
+    hi_shuf[k] = _mm_loadu_si128((const __m128i *)hs);
+    lo_shuf[k] = _mm_loadu_si128((const __m128i *)ls);
+    spaces[k] = _mm_loadu_si128((const __m128i *)sp);
+  }
+
+  for (i = 0; i + 16 <= len; i += 16)
+  {
+    in = _mm_loadu_si128((const __m128i *)(buf + i));
+    hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(in, 4), low_mask));
+    lo = _mm_shuffle_epi8(digits, _mm_and_si128(in, low_mask));
+
+    for (k = 0; k < 3; k++)
+    {
+      v = _mm_or_si128(_mm_shuffle_epi8(hi, hi_shuf[k]),
+                       _mm_shuffle_epi8(lo, lo_shuf[k]));
+      v = _mm_or_si128(v, spaces[k]);
+      _mm_storeu_si128((__m128i *)(out + i * 3 + k * 16), v);
+    }
+  }
+
+  return i * 3 + hex_formatter_scalar(buf + i, len - i, out + i * 3);
 }
+#endif
 
 /*
- * Hex formatter
+ * Hex formatter: "hh " per byte.
+ *
+ * Returns the number of characters written.
  */
-void hex_formatter(char *pattern, int c, char *token_buf)
+int hex_formatter(const unsigned char *buf, int len, char *out)
 {
-  sprintf(token_buf, pattern, 2, c);
+  return hex_kernel(buf, len, out);
 }
 
 /*
- * Toggles the socket output display format type
- *
- * Returns new format type
+ * Fills in the per-byte lookup tables used by the formatters.
  */
-int toggle_sock_out_format()
+void init_format_tables()
 {
-  switch (sock_out_format_type)
+  int c;
+  char cell[8];
+
+  for (c = 0; c < 256; c++)
   {
-  case FORMATTER_WIDE:
-    sock_out_format_type = FORMATTER_TEXT;
-    sock_out_format = &display_formats[sock_out_format_type];
-    break;
-  case FORMATTER_TEXT:
-    sock_out_format_type = FORMATTER_HEX;
-    sock_out_format = &display_formats[sock_out_format_type];
-    break;
-  case FORMATTER_HEX:
-    sock_out_format_type = FORMATTER_WIDE;
-    sock_out_format = &display_formats[sock_out_format_type];
-    break;
-  default:
-    deinit_curses();
-    printf("bad value for sock_out_format_type: %d\n", sock_out_format_type);
-    finish(-1);
-    break;
+    printable_table[c] = ((c >= 32) && (c < 127)) ? TRUE : FALSE;
+
+    if (printable_table[c])
+      text_table[c] = c;
+    else if (c == '\n')
+      text_table[c] = '\n';
+    else if (c == '\r')
+      text_table[c] = '\0';
+    else
+      text_table[c] = '.';
+
+    memset(cell, 0, sizeof(cell));
+    cell[0] = hex_digits[c >> 4];
+    cell[1] = hex_digits[c & 0x0f];
+    cell[2] = ' ';
+    memcpy(&hex_table[c], cell, 4);
+
+    memset(cell, 0, sizeof(cell));
+    cell[0] = printable_table[c] ? c : ' ';
+    cell[1] = '(';
+    cell[2] = hex_digits[c >> 4];
+    cell[3] = hex_digits[c & 0x0f];
+    cell[4] = ')';
+    cell[5] = ' ';
+    memcpy(&wide_table[c], cell, 8);
   }
 
-  return sock_out_format_type;
+  hex_kernel = hex_formatter_scalar;
+#ifdef __x86_64__
+  if (__builtin_cpu_supports("ssse3"))
+  {
+    hex_kernel = hex_formatter_ssse3;
+  }
+#endif
 }
 
 /*
- * Toggles the socket input display format type
+ * Finds the format following the given one in the wide - text - hex
+ * cycle of the F1 and F2 keys.
  *
- * Returns new format type
+ * Returns the next format type
  */
-int toggle_sock_in_format()
+int next_format_type(display_format *format)
 {
-  switch (sock_in_format_type)
+  switch (format - display_formats)
   {
   case FORMATTER_WIDE:
-    sock_in_format_type = FORMATTER_TEXT;
-    sock_in_format = &display_formats[sock_in_format_type];
+    return FORMATTER_TEXT;
     break;
   case FORMATTER_TEXT:
-    sock_in_format_type = FORMATTER_HEX;
-    sock_in_format = &display_formats[sock_in_format_type];
-    break;
-  case FORMATTER_HEX:
-    sock_in_format_type = FORMATTER_WIDE;
-    sock_in_format = &display_formats[sock_in_format_type];
+    return FORMATTER_HEX;
     break;
   default:
-    deinit_curses();
-    printf("bad value for sock_in_format_type: %d\n", sock_in_format_type);
-    finish(-1);
+    return FORMATTER_WIDE;
     break;
   }
-
-  return sock_in_format_type;
 }
 
 /*
@@ -153,17 +248,22 @@ int toggle_sock_in_format()
  */
 void init_formatters()
 {
+  init_format_tables();
+
   /* create wide formatter */
   memset(display_formats, 0, sizeof(display_formats));
-  strcpy(display_formats[FORMATTER_WIDE].pattern, "%c(%0*x) ");
+  strcpy(display_formats[FORMATTER_WIDE].name, "wide");
+  display_formats[FORMATTER_WIDE].cell_width = 6;
   display_formats[FORMATTER_WIDE].formatter = wide_formatter;
 
   /* create text formatter */
-  strcpy(display_formats[FORMATTER_TEXT].pattern, "%c");
+  strcpy(display_formats[FORMATTER_TEXT].name, "text");
+  display_formats[FORMATTER_TEXT].cell_width = 1;
   display_formats[FORMATTER_TEXT].formatter = text_formatter;
 
   /* create hex formatter */
-  strcpy(display_formats[FORMATTER_HEX].pattern, "%0*x ");
+  strcpy(display_formats[FORMATTER_HEX].name, "hex");
+  display_formats[FORMATTER_HEX].cell_width = 3;
   display_formats[FORMATTER_HEX].formatter = hex_formatter;
 
   /* set default formatters from command line data */
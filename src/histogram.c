@@ -0,0 +1,212 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../include/histogram.h"
+
+/*
+ * Empties a histogram.
+ */
+void histogram_reset(histogram *h)
+{
+    memset(h, 0, sizeof(histogram));
+}
+
+/*
+ * Returns the bucket a value is counted in.
+ */
+int histogram_index(uint64_t value)
+{
+    int shift;
+
+    if (value < HISTOGRAM_SUB_COUNT)
+    {
+        return (int)value;
+    }
+
+    /* keep the top HISTOGRAM_SUB_BITS bits of the value */
+    shift = 64 - __builtin_clzll(value) - HISTOGRAM_SUB_BITS;
+
+    return shift * (HISTOGRAM_SUB_COUNT / 2) + (int)(value >> shift);
+}
+
+/*
+ * Returns the smallest value counted in a bucket.
+ */
+uint64_t histogram_bucket_start(int index)
+{
+    int shift;
+
+    if (index < HISTOGRAM_SUB_COUNT)
+    {
+        return index;
+    }
+
+    shift = index / (HISTOGRAM_SUB_COUNT / 2) - 1;
+
+    return (uint64_t)(index - shift * (HISTOGRAM_SUB_COUNT / 2)) << shift;
+}
+
+/*
+ * Counts a value.
+ */
+void histogram_record(histogram *h, uint64_t value)
+{
+    h->counts[histogram_index(value)]++;
+
+    if ((h->total == 0) || (value < h->min))
+    {
+        h->min = value;
+    }
+    if (value > h->max)
+    {
+        h->max = value;
+    }
+    h->total++;
+    h->sum += value;
+}
+
+/*
+ * Adds the counts of histogram from to histogram to.
+ */
+void histogram_add(histogram *to, histogram *from)
+{
+    int i;
+
+    if (from->total == 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        to->counts[i] += from->counts[i];
+    }
+
+    if ((to->total == 0) || (from->min < to->min))
+    {
+        to->min = from->min;
+    }
+    if (from->max > to->max)
+    {
+        to->max = from->max;
+    }
+    to->total += from->total;
+    to->sum += from->sum;
+}
+
+/*
+ * Returns the value at or below which the given percentage of the
+ * values are: the highest value of its bucket, but no more than the
+ * largest value counted. 0 if the histogram is empty.
+ */
+uint64_t histogram_percentile(histogram *h, double percentile)
+{
+    uint64_t wanted, seen, high;
+    int i;
+
+    if (h->total == 0)
+    {
+        return 0;
+    }
+
+    wanted = (uint64_t)(percentile / 100.0 * h->total + 0.5);
+    if (wanted < 1)
+    {
+        wanted = 1;
+    }
+
+    seen = 0;
+    for (i = 0; i < HISTOGRAM_BUCKETS - 1; i++)
+    {
+        seen += h->counts[i];
+        if (seen >= wanted)
+        {
+            break;
+        }
+    }
+
+    high = histogram_bucket_start(i + 1) - 1;
+    if (high > h->max)
+    {
+        high = h->max;
+    }
+    if (high < h->min)
+    {
+        high = h->min;
+    }
+
+    return high;
+}
+
+/*
+ * Returns how many of the values counted are below a limit, to the
+ * precision of the buckets.
+ */
+uint64_t histogram_count_below(histogram *h, uint64_t limit)
+{
+    uint64_t count;
+    int i, end;
+
+    end = histogram_index(limit);
+    count = 0;
+    for (i = 0; (i < end) && (i < HISTOGRAM_BUCKETS); i++)
+    {
+        count += h->counts[i];
+    }
+
+    return count;
+}
+
+/*
+ * Formats a latency given in nanoseconds, such as "870us" or "12.3ms",
+ * into a buffer of at least 16 bytes.
+ */
+void format_latency(uint64_t ns, char *s)
+{
+    if (ns < 1000)
+    {
+        sprintf(s, "%uns", (unsigned int)ns);
+    }
+    else if (ns < 10000)
+    {
+        sprintf(s, "%.2fus", ns / 1e3);
+    }
+    else if (ns < 1000000)
+    {
+        sprintf(s, "%.0fus", ns / 1e3);
+    }
+    else if (ns < 1000000000)
+    {
+        sprintf(s, "%.2fms", ns / 1e6);
+    }
+    else
+    {
+        sprintf(s, "%.2fs", ns / 1e9);
+    }
+}
@@ -0,0 +1,639 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/history.h"
+#include "../include/lz.h"
+
+/* memory taken by a raw chunk */
+#define RAW_CHUNK_COST (HISTORY_CHUNK_SIZE + HISTORY_BITMAP_SIZE)
+
+/*
+ * Exits pint when memory for the history runs out.
+ */
+static void out_of_memory()
+{
+    deinit_curses();
+    printf("out of memory for history\n");
+    finish(-1);
+}
+
+/*
+ * Creates an empty history that keeps at most budget bytes resident.
+ * Chunk memory is allocated only as data arrives.
+ *
+ * Returns the new history or NULL if out of memory.
+ */
+history *history_create(long long budget)
+{
+    history *h;
+    int i;
+
+    h = (history *)calloc(1, sizeof(history));
+    if (h == NULL)
+    {
+        return NULL;
+    }
+
+    h->num_slots = budget / RAW_CHUNK_COST;
+    if (h->num_slots < HISTORY_HOT_CHUNKS)
+    {
+        h->num_slots = HISTORY_HOT_CHUNKS;
+    }
+
+    h->chunks = (history_chunk *)calloc(h->num_slots, sizeof(history_chunk));
+    if (h->chunks == NULL)
+    {
+        free(h);
+        return NULL;
+    }
+
+    for (i = 0; i < HISTORY_CACHE_SIZE; i++)
+    {
+        h->cache[i].chunk_no = -1;
+    }
+
+    h->budget = budget;
+    h->last_newline = -1;
+
+    return h;
+}
+
+/*
+ * Frees the memory of a chunk.
+ */
+static void free_chunk(history_chunk *chunk)
+{
+    free(chunk->data);
+    free(chunk->newlines);
+    free(chunk->packed);
+    memset(chunk, 0, sizeof(history_chunk));
+}
+
+/*
+ * Frees a history and all of its chunks.
+ */
+void history_destroy(history *h)
+{
+    int i;
+
+    if (h == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < h->num_slots; i++)
+    {
+        free_chunk(&h->chunks[i]);
+    }
+
+    for (i = 0; i < HISTORY_CACHE_SIZE; i++)
+    {
+        free(h->cache[i].data);
+        free(h->cache[i].newlines);
+    }
+
+    free(h->records);
+    free(h->chunks);
+    free(h);
+}
+
+/*
+ * Returns the slot of chunk number n.
+ */
+static history_chunk *chunk_slot(history *h, long long n)
+{
+    return &h->chunks[n % h->num_slots];
+}
+
+/*
+ * Returns the number of chunks in use.
+ */
+static long long num_chunks(history *h)
+{
+    if (h->end == h->start)
+    {
+        return 0;
+    }
+
+    return (h->end - 1) / HISTORY_CHUNK_SIZE - h->start / HISTORY_CHUNK_SIZE + 1;
+}
+
+/*
+ * Drops the oldest chunk.
+ */
+static void drop_oldest(history *h)
+{
+    history_chunk *chunk;
+    long long n;
+    int i;
+
+    n = h->start / HISTORY_CHUNK_SIZE;
+    chunk = chunk_slot(h, n);
+
+    if (chunk->packed != NULL)
+    {
+        h->resident -= chunk->packed_len;
+        h->packed_raw -= HISTORY_CHUNK_SIZE;
+        h->packed_bytes -= chunk->packed_len;
+    }
+    else
+    {
+        h->resident -= RAW_CHUNK_COST;
+    }
+    free_chunk(chunk);
+
+    for (i = 0; i < HISTORY_CACHE_SIZE; i++)
+    {
+        if (h->cache[i].chunk_no == n)
+        {
+            h->cache[i].chunk_no = -1;
+        }
+    }
+
+    h->start = (n + 1) * HISTORY_CHUNK_SIZE;
+    if (h->start > h->end)
+    {
+        h->start = h->end;
+    }
+
+    /* forget the datagrams that are gone entirely */
+    while ((h->num_records > 0) &&
+           (h->records[h->records_first].offset + h->records[h->records_first].len <= h->start))
+    {
+        h->records_first = (h->records_first + 1) & (h->records_size - 1);
+        h->num_records--;
+    }
+}
+
+/*
+ * Doubles the number of chunk slots, keeping every chunk at the slot
+ * its number maps to.
+ */
+static void grow_slots(history *h)
+{
+    history_chunk *chunks;
+    long long n, first;
+    int num_slots;
+
+    num_slots = h->num_slots * 2;
+    chunks = (history_chunk *)calloc(num_slots, sizeof(history_chunk));
+    if (chunks == NULL)
+    {
+        out_of_memory();
+    }
+
+    first = h->start / HISTORY_CHUNK_SIZE;
+    for (n = first; n < first + num_chunks(h); n++)
+    {
+        chunks[n % num_slots] = *chunk_slot(h, n);
+    }
+
+    free(h->chunks);
+    h->chunks = chunks;
+    h->num_slots = num_slots;
+}
+
+/*
+ * Allocates the chunk that offset h->end starts, dropping old chunks
+ * to stay within the budget.
+ */
+static history_chunk *new_chunk(history *h)
+{
+    history_chunk *chunk;
+
+    while ((num_chunks(h) > 0) && (h->resident + RAW_CHUNK_COST > h->budget))
+    {
+        drop_oldest(h);
+    }
+
+    if (num_chunks(h) >= h->num_slots)
+    {
+        grow_slots(h);
+    }
+
+    chunk = chunk_slot(h, h->end / HISTORY_CHUNK_SIZE);
+    chunk->data = (unsigned char *)malloc(HISTORY_CHUNK_SIZE);
+    chunk->newlines = (unsigned long long *)calloc(1, HISTORY_BITMAP_SIZE);
+    if ((chunk->data == NULL) || (chunk->newlines == NULL))
+    {
+        out_of_memory();
+    }
+
+    chunk->newline_before = h->last_newline;
+    h->resident += RAW_CHUNK_COST;
+
+    return chunk;
+}
+
+/*
+ * Appends bytes to the end of the history.
+ */
+void history_append(history *h, const unsigned char *buf, int len)
+{
+    history_chunk *chunk;
+    const unsigned char *p, *nl;
+    int pos, n;
+
+    while (len > 0)
+    {
+        pos = h->end % HISTORY_CHUNK_SIZE;
+        if (pos == 0)
+        {
+            chunk = new_chunk(h);
+        }
+        else
+        {
+            chunk = chunk_slot(h, h->end / HISTORY_CHUNK_SIZE);
+        }
+
+        n = HISTORY_CHUNK_SIZE - pos;
+        if (n > len)
+        {
+            n = len;
+        }
+
+        memcpy(chunk->data + pos, buf, n);
+
+        /* index the linefeeds of the appended range */
+        for (p = buf; (nl = memchr(p, '\n', buf + n - p)) != NULL; p = nl + 1)
+        {
+            chunk->newlines[(pos + (nl - buf)) / 64] |=
+                1ULL << ((pos + (nl - buf)) % 64);
+            h->last_newline = h->end + (nl - buf);
+        }
+
+        h->end += n;
+        buf += n;
+        len -= n;
+    }
+}
+
+/*
+ * Returns the ith oldest datagram of a history.
+ */
+static history_record *record_slot(history *h, int i)
+{
+    return &h->records[(h->records_first + i) & (h->records_size - 1)];
+}
+
+/*
+ * Makes room for one more datagram in the index: it doubles while it
+ * stays within an eighth of the budget, after that the oldest datagram
+ * is forgotten. Its bytes are kept, only no longer shown apart.
+ */
+static void reserve_record(history *h)
+{
+    history_record *records;
+    int size, i;
+
+    if (h->num_records < h->records_size)
+    {
+        return;
+    }
+
+    size = (h->records_size > 0) ? h->records_size * 2 : HISTORY_MIN_RECORDS;
+    if ((h->records_size > 0) && (size * (long long)sizeof(history_record) > h->budget / 8))
+    {
+        h->records_first = (h->records_first + 1) & (h->records_size - 1);
+        h->num_records--;
+        return;
+    }
+
+    records = (history_record *)malloc(size * sizeof(history_record));
+    if (records == NULL)
+    {
+        out_of_memory();
+    }
+
+    for (i = 0; i < h->num_records; i++)
+    {
+        records[i] = *record_slot(h, i);
+    }
+
+    free(h->records);
+    h->records = records;
+    h->records_size = size;
+    h->records_first = 0;
+}
+
+/*
+ * Appends a datagram to the end of the history, indexed so that it is
+ * shown as a record of its own. ns is when it arrived or was sent.
+ */
+void history_append_record(history *h, const unsigned char *buf, int len,
+                           unsigned long long ns)
+{
+    history_record *r;
+
+    if (len <= 0)
+    {
+        return;
+    }
+
+    reserve_record(h);
+    r = record_slot(h, h->num_records++);
+    r->offset = h->end;
+    r->len = len;
+    r->ns = ns;
+
+    history_append(h, buf, len);
+}
+
+/*
+ * Finds the datagram holding the byte at offset, or failing that, the
+ * first one after it; bytes older than the index hold no datagrams.
+ *
+ * Returns the datagram, or NULL if there is none at or after offset
+ */
+history_record *history_find_record(history *h, long long offset)
+{
+    history_record *r;
+    int lo, hi, mid, found;
+
+    /* the last datagram starting at or before offset */
+    lo = 0;
+    hi = h->num_records - 1;
+    found = -1;
+    while (lo <= hi)
+    {
+        mid = (lo + hi) / 2;
+        if (record_slot(h, mid)->offset <= offset)
+        {
+            found = mid;
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    if (found != -1)
+    {
+        r = record_slot(h, found);
+        if (offset < r->offset + r->len)
+        {
+            return r;
+        }
+    }
+
+    return (found + 1 < h->num_records) ? record_slot(h, found + 1) : NULL;
+}
+
+/*
+ * Returns the raw bytes of chunk number n, unpacking it into the cache
+ * if it is compressed. The linefeed bitmap is returned in newlines.
+ */
+static unsigned char *chunk_data(history *h, long long n,
+                                 unsigned long long **newlines)
+{
+    history_chunk *chunk;
+    history_cache *entry;
+    const unsigned char *p, *nl;
+    int i, len;
+
+    chunk = chunk_slot(h, n);
+    if (chunk->data != NULL)
+    {
+        *newlines = chunk->newlines;
+        return chunk->data;
+    }
+
+    /* look for the chunk in the cache, or else evict the least
+       recently used entry */
+    entry = &h->cache[0];
+    for (i = 0; i < HISTORY_CACHE_SIZE; i++)
+    {
+        if (h->cache[i].chunk_no == n)
+        {
+            entry = &h->cache[i];
+            break;
+        }
+
+        if (h->cache[i].last_used < entry->last_used)
+        {
+            entry = &h->cache[i];
+        }
+    }
+
+    entry->last_used = ++h->cache_clock;
+
+    if (entry->chunk_no != n)
+    {
+        if (entry->data == NULL)
+        {
+            entry->data = (unsigned char *)malloc(HISTORY_CHUNK_SIZE);
+            entry->newlines = (unsigned long long *)malloc(HISTORY_BITMAP_SIZE);
+            if ((entry->data == NULL) || (entry->newlines == NULL))
+            {
+                out_of_memory();
+            }
+            h->resident += RAW_CHUNK_COST;
+        }
+
+        len = lz_decompress(chunk->packed, chunk->packed_len,
+                            entry->data, HISTORY_CHUNK_SIZE);
+        if (len != HISTORY_CHUNK_SIZE)
+        {
+            deinit_curses();
+            printf("corrupt history chunk %lld\n", n);
+            finish(-1);
+        }
+
+        memset(entry->newlines, 0, HISTORY_BITMAP_SIZE);
+        p = entry->data;
+        while ((nl = memchr(p, '\n', entry->data + len - p)) != NULL)
+        {
+            entry->newlines[(nl - entry->data) / 64] |=
+                1ULL << ((nl - entry->data) % 64);
+            p = nl + 1;
+        }
+
+        entry->chunk_no = n;
+    }
+
+    *newlines = entry->newlines;
+    return entry->data;
+}
+
+/*
+ * Copies up to len bytes starting at offset out of the history.
+ * Nothing is copied if offset has already been dropped from the
+ * history.
+ *
+ * Returns the number of bytes copied.
+ */
+int history_read(history *h, long long offset, unsigned char *buf, int len)
+{
+    unsigned char *data;
+    unsigned long long *newlines;
+    int pos, n, total;
+
+    if ((offset < h->start) || (offset >= h->end))
+    {
+        return 0;
+    }
+
+    if (len > h->end - offset)
+    {
+        len = h->end - offset;
+    }
+
+    for (total = 0; total < len; total += n)
+    {
+        data = chunk_data(h, (offset + total) / HISTORY_CHUNK_SIZE, &newlines);
+        pos = (offset + total) % HISTORY_CHUNK_SIZE;
+
+        n = HISTORY_CHUNK_SIZE - pos;
+        if (n > len - total)
+        {
+            n = len - total;
+        }
+
+        memcpy(buf + total, data + pos, n);
+    }
+
+    return total;
+}
+
+/*
+ * Finds the last linefeed before offset.
+ *
+ * Returns its offset, or -1 if there is none in the history.
+ */
+long long history_prev_newline(history *h, long long offset)
+{
+    unsigned long long *newlines;
+    unsigned long long word;
+    long long base, found;
+    int pos, i;
+
+    if (offset > h->end)
+    {
+        offset = h->end;
+    }
+
+    if (offset <= h->start)
+    {
+        return -1;
+    }
+
+    /* search the bitmap of the chunk holding offset - 1 backwards */
+    chunk_data(h, (offset - 1) / HISTORY_CHUNK_SIZE, &newlines);
+    base = (offset - 1) - (offset - 1) % HISTORY_CHUNK_SIZE;
+    pos = (offset - 1) % HISTORY_CHUNK_SIZE;
+
+    i = pos / 64;
+    word = newlines[i] & (~0ULL >> (63 - pos % 64));
+
+    for (;;)
+    {
+        if (word != 0)
+        {
+            found = base + i * 64 + 63 - __builtin_clzll(word);
+            return (found >= h->start) ? found : -1;
+        }
+
+        if (--i < 0)
+        {
+            break;
+        }
+        word = newlines[i];
+    }
+
+    found = chunk_slot(h, base / HISTORY_CHUNK_SIZE)->newline_before;
+    return (found >= h->start) ? found : -1;
+}
+
+/*
+ * Returns TRUE if there is a cold chunk left to compress.
+ */
+int history_compress_pending(history *h)
+{
+    long long first, hot;
+
+    first = h->start / HISTORY_CHUNK_SIZE;
+    if (h->next_pack < first)
+    {
+        h->next_pack = first;
+    }
+
+    hot = h->end / HISTORY_CHUNK_SIZE - HISTORY_HOT_CHUNKS;
+
+    return h->next_pack < hot;
+}
+
+/*
+ * Compresses the oldest uncompressed cold chunk. Chunks that do not
+ * shrink by at least an eighth are left raw.
+ */
+void history_compress_step(history *h)
+{
+    static unsigned char packed[HISTORY_CHUNK_SIZE];
+    history_chunk *chunk;
+    int len;
+
+    if (!history_compress_pending(h))
+    {
+        return;
+    }
+
+    chunk = chunk_slot(h, h->next_pack++);
+    if (chunk->data == NULL)
+    {
+        return;
+    }
+
+    len = lz_compress(chunk->data, HISTORY_CHUNK_SIZE, packed,
+                      HISTORY_CHUNK_SIZE - HISTORY_CHUNK_SIZE / 8);
+    if (len == 0)
+    {
+        return;
+    }
+
+    chunk->packed = (unsigned char *)malloc(len);
+    if (chunk->packed == NULL)
+    {
+        return;
+    }
+    memcpy(chunk->packed, packed, len);
+    chunk->packed_len = len;
+
+    free(chunk->data);
+    free(chunk->newlines);
+    chunk->data = NULL;
+    chunk->newlines = NULL;
+
+    h->resident += len - RAW_CHUNK_COST;
+    h->packed_raw += HISTORY_CHUNK_SIZE;
+    h->packed_bytes += len;
+}
@@ -0,0 +1,689 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/network.h"
+#include "../include/eventloop.h"
+#include "../include/capture.h"
+#include "../include/histogram.h"
+#include "../include/loadgen.h"
+#include "../include/stats.h"
+
+/* TRUE when generating load */
+int load_mode = FALSE;
+
+/* the connections, and how many of them are open */
+load_conn *load_conns = NULL;
+int num_load_conns = 0;
+int load_conns_open = 0;
+struct sockaddr_in load_addr;
+char load_target[80];
+
+/* the request, and how a response ends: after load_length bytes,
+   after the delimiter, or with the datagram */
+unsigned char *load_request = NULL;
+int load_request_len = 0;
+int load_length = 0;
+unsigned char load_delimiter[LOAD_DELIMITER_SIZE];
+int load_delimiter_len = 0;
+int load_delimiter_fail[LOAD_DELIMITER_SIZE];
+
+/* when the run ends: after so many requests or seconds, if not 0 */
+long long load_max_requests = 0;
+double load_duration = 0;
+
+/* completed requests, and the problems met */
+long long load_requests = 0;
+long long load_reported_requests = 0;
+long long load_failures = 0;
+long long load_reconnects = 0;
+long long load_lost = 0;
+
+/* latencies since the last report, and before it */
+histogram load_interval;
+histogram load_total;
+
+uint64_t load_started_ns = 0;
+uint64_t load_last_report_ns = 0;
+uint64_t load_stopped_ns = 0;
+int load_report_timer = -1;
+int load_duration_timer = -1;
+
+/* every connection is read into this buffer */
+unsigned char load_buf[LOAD_BUFFER_SIZE];
+
+void handle_load_event(int, int, void *);
+void load_send(load_conn *);
+
+/*
+ * Translates a request or delimiter given in the escaped input syntax.
+ *
+ * Returns the number of bytes, or -1 on error
+ */
+int load_translate(char *escaped, unsigned char *dest, char *what)
+{
+    file_escape files[STDIN_MAX_FILES];
+    int len, num_files;
+
+    len = translate_escapes((unsigned char *)escaped, strlen(escaped), dest,
+                            files, &num_files);
+    if (num_files > 0)
+    {
+        printf("The %s can't send files\n", what);
+        return -1;
+    }
+    if (len == 0)
+    {
+        printf("The %s is empty\n", what);
+        return -1;
+    }
+
+    return len;
+}
+
+/*
+ * Sets the response delimiter, and the table of how much of it is
+ * still matched after a mismatch.
+ */
+void load_set_delimiter(unsigned char *delimiter, int len)
+{
+    int i, k;
+
+    memcpy(load_delimiter, delimiter, len);
+    load_delimiter_len = len;
+
+    load_delimiter_fail[0] = 0;
+    for (i = 1, k = 0; i < len; i++)
+    {
+        while ((k > 0) && (delimiter[i] != delimiter[k]))
+        {
+            k = load_delimiter_fail[k - 1];
+        }
+        if (delimiter[i] == delimiter[k])
+        {
+            k++;
+        }
+        load_delimiter_fail[i] = k;
+    }
+}
+
+/*
+ * Ends the run: the event loop returns.
+ */
+void load_finish_run()
+{
+    if (load_stopped_ns == 0)
+    {
+        load_stopped_ns = capture_clock_ns(CLOCK_MONOTONIC);
+    }
+    event_loop_stop();
+}
+
+/*
+ * Closes the socket of a connection.
+ */
+void load_conn_close(load_conn *c)
+{
+    if (c->sockfd == -1)
+    {
+        return;
+    }
+
+    event_remove(c->sockfd);
+    close(c->sockfd);
+    c->sockfd = -1;
+    load_conns_open--;
+}
+
+/*
+ * Gives up on a connection. The run ends when none is left.
+ */
+void load_conn_failed(load_conn *c, char *reason)
+{
+    char msg[512];
+
+    load_conn_close(c);
+
+    load_failures++;
+    stats_errors++;
+    if (load_failures <= LOAD_REPORT_FAILURES)
+    {
+        sprintf(msg, "#%d failed (%.256s)\n", c->id, reason);
+        write_info_wnd(msg);
+    }
+
+    /* once running, the run ends when no connection is left */
+    if ((load_conns_open == 0) && (load_report_timer != -1))
+    {
+        write_info_wnd("No connections left\n");
+        load_finish_run();
+    }
+}
+
+/*
+ * Opens the socket of a connection and starts connecting it; the
+ * first request goes once it is writable.
+ *
+ * Returns 0 on success, -1 if the connection failed
+ */
+int load_conn_open(load_conn *c)
+{
+    c->state = LOAD_CONNECTING;
+    c->writing = TRUE;
+    c->sent = 0;
+    c->received = 0;
+    c->matched = 0;
+
+    if ((c->sockfd = start_connect(&load_addr)) == -1)
+    {
+        load_conn_failed(c, strerror(errno));
+        return -1;
+    }
+    load_conns_open++;
+
+    if (event_add(c->sockfd, EVENT_WRITE, handle_load_event, c) == -1)
+    {
+        load_conn_failed(c, "can't watch the socket");
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Opens a connection again after the server closed or reset it; the
+ * request it was on is dropped.
+ */
+void load_conn_reopen(load_conn *c)
+{
+    load_conn_close(c);
+    load_reconnects++;
+    load_conn_open(c);
+}
+
+/*
+ * Tells if a send or receive error means the server went away from
+ * an established TCP connection.
+ */
+int load_conn_reset(int err)
+{
+    return (socket_type == SOCKTYPE_TCP) && ((err == ECONNRESET) || (err == EPIPE));
+}
+
+/*
+ * Watches a connection for writability too, or not.
+ */
+void load_watch_write(load_conn *c, int writing)
+{
+    if (c->writing != writing)
+    {
+        c->writing = writing;
+        event_modify(c->sockfd, writing ? (EVENT_READ | EVENT_WRITE) : EVENT_READ);
+    }
+}
+
+/*
+ * Sends what is left of the request. The latency is measured from
+ * the first attempt to send it.
+ */
+void load_send(load_conn *c)
+{
+    ssize_t n;
+
+    if (c->sent == 0)
+    {
+        c->sent_ns = capture_clock_ns(CLOCK_MONOTONIC);
+    }
+
+    n = send(c->sockfd, load_request + c->sent, load_request_len - c->sent, MSG_NOSIGNAL);
+    if (n < 0)
+    {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+        {
+            load_watch_write(c, TRUE);
+        }
+        else if (load_conn_reset(errno))
+        {
+            load_conn_reopen(c);
+        }
+        else
+        {
+            load_conn_failed(c, strerror(errno));
+        }
+        return;
+    }
+
+    stats_count(&stats_out, n);
+    c->sent += n;
+    if (c->sent < load_request_len)
+    {
+        load_watch_write(c, TRUE);
+        return;
+    }
+
+    c->sent = 0;
+    c->received = 0;
+    c->matched = 0;
+    c->state = LOAD_WAITING;
+    load_watch_write(c, FALSE);
+}
+
+/*
+ * Tells if received bytes complete the response being waited for.
+ */
+int load_response_complete(load_conn *c, unsigned char *buf, int n)
+{
+    int i;
+
+    if (load_length > 0)
+    {
+        c->received += n;
+        return (c->received >= load_length);
+    }
+
+    /* each datagram is a response */
+    if (load_delimiter_len == 0)
+    {
+        return TRUE;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        while ((c->matched > 0) && (buf[i] != load_delimiter[c->matched]))
+        {
+            c->matched = load_delimiter_fail[c->matched - 1];
+        }
+        if (buf[i] == load_delimiter[c->matched])
+        {
+            c->matched++;
+        }
+        if (c->matched == load_delimiter_len)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * Counts a completed request, and sends the next one.
+ */
+void load_complete(load_conn *c)
+{
+    histogram_record(&load_interval, capture_clock_ns(CLOCK_MONOTONIC) - c->sent_ns);
+    c->requests++;
+    load_requests++;
+
+    if ((load_max_requests > 0) && (load_requests >= load_max_requests))
+    {
+        load_finish_run();
+        return;
+    }
+
+    c->state = LOAD_SENDING;
+    load_send(c);
+}
+
+/*
+ * Reads a response, or what has arrived of it. A connection the server
+ * closes is opened again; the request it was waiting for is dropped.
+ */
+void load_receive(load_conn *c)
+{
+    ssize_t n;
+
+    n = recv(c->sockfd, load_buf, LOAD_BUFFER_SIZE, 0);
+    if (n < 0)
+    {
+        if (load_conn_reset(errno))
+        {
+            load_conn_reopen(c);
+        }
+        else if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+        {
+            load_conn_failed(c, strerror(errno));
+        }
+        return;
+    }
+
+    if ((n == 0) && (socket_type == SOCKTYPE_TCP))
+    {
+        load_conn_reopen(c);
+        return;
+    }
+    stats_count(&stats_in, n);
+
+    /* bytes arriving while the request is still going out count
+       for nothing */
+    if ((c->state == LOAD_WAITING) && load_response_complete(c, load_buf, n))
+    {
+        load_complete(c);
+    }
+}
+
+/*
+ * Event callback of a connection.
+ */
+void handle_load_event(int fd, int events, void *data)
+{
+    load_conn *c = (load_conn *)data;
+    socklen_t len;
+    int err;
+
+    if (c->state == LOAD_CONNECTING)
+    {
+        len = sizeof(err);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1)
+        {
+            err = errno;
+        }
+        if (err != 0)
+        {
+            load_conn_failed(c, strerror(err));
+            return;
+        }
+
+        c->state = LOAD_SENDING;
+        load_watch_write(c, FALSE);
+        load_send(c);
+        return;
+    }
+
+    if ((events & EVENT_WRITE) && (c->state == LOAD_SENDING))
+    {
+        load_send(c);
+
+        /* the socket may have been closed, or replaced by a new one
+           that got the same descriptor */
+        if ((c->sockfd != fd) || (c->state == LOAD_CONNECTING))
+        {
+            return;
+        }
+    }
+
+    if (events & EVENT_READ)
+    {
+        load_receive(c);
+    }
+}
+
+/*
+ * Timer callback: reports the request rate and latencies since the
+ * last report. UDP requests that waited too long for a response are
+ * counted as lost and sent again.
+ */
+void report_load(int fd, int events, void *data)
+{
+    char msg[512], p50[16], p99[16], p999[16];
+    uint64_t now;
+    double rate;
+    int i;
+
+    event_set_timer(load_report_timer, LOAD_REPORT_INTERVAL);
+    now = capture_clock_ns(CLOCK_MONOTONIC);
+
+    if (socket_type == SOCKTYPE_UDP)
+    {
+        for (i = 0; i < num_load_conns; i++)
+        {
+            if ((load_conns[i].sockfd != -1) && (load_conns[i].state == LOAD_WAITING) &&
+                (now - load_conns[i].sent_ns > LOAD_UDP_TIMEOUT))
+            {
+                load_lost++;
+                load_conns[i].state = LOAD_SENDING;
+                load_send(&load_conns[i]);
+            }
+        }
+    }
+
+    rate = (load_requests - load_reported_requests) * 1e9 / (now - load_last_report_ns);
+    format_latency(histogram_percentile(&load_interval, 50), p50);
+    format_latency(histogram_percentile(&load_interval, 99), p99);
+    format_latency(histogram_percentile(&load_interval, 99.9), p999);
+    sprintf(msg, "load: %d open, %.0f requests/s, p50 %s, p99 %s, p99.9 %s "
+            "(total %lld requests, %lld failed)\n",
+            load_conns_open, rate, p50, p99, p999, load_requests, load_failures);
+    write_info_wnd(msg);
+
+    histogram_add(&load_total, &load_interval);
+    histogram_reset(&load_interval);
+    load_reported_requests = load_requests;
+    load_last_report_ns = now;
+}
+
+/*
+ * Timer callback: the time given for the run is up.
+ */
+void load_time_up(int fd, int events, void *data)
+{
+    load_finish_run();
+}
+
+/*
+ * Prepares loading a remote host: looks it up, and translates the
+ * request and the response delimiter.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int load_open(char *host, int port, load_params *params)
+{
+    unsigned char delimiter[LOAD_DELIMITER_SIZE * 4];
+    int len;
+
+    load_mode = TRUE;
+    histogram_reset(&load_interval);
+    histogram_reset(&load_total);
+    snprintf(load_target, sizeof(load_target), "%.64s:%d", host, port);
+
+    if (resolve_remote_host(host, port, &load_addr) == -1)
+    {
+        printf("Unknown host %s\n", host);
+        return -1;
+    }
+
+    load_request = (unsigned char *)malloc(strlen(params->request) + 1);
+    if (load_request == NULL)
+    {
+        printf("out of memory for the request\n");
+        return -1;
+    }
+    if ((load_request_len = load_translate(params->request, load_request, "request")) == -1)
+    {
+        return -1;
+    }
+
+    load_length = params->length;
+    if (params->delimiter != NULL)
+    {
+        if (strlen(params->delimiter) >= sizeof(delimiter))
+        {
+            printf("The response delimiter is too long\n");
+            return -1;
+        }
+        if ((len = load_translate(params->delimiter, delimiter, "response delimiter")) == -1)
+        {
+            return -1;
+        }
+        if (len > LOAD_DELIMITER_SIZE)
+        {
+            printf("The response delimiter is longer than %d bytes\n", LOAD_DELIMITER_SIZE);
+            return -1;
+        }
+        load_set_delimiter(delimiter, len);
+    }
+    else if ((load_length == 0) && (socket_type == SOCKTYPE_TCP))
+    {
+        load_set_delimiter((unsigned char *)"\n", 1);
+    }
+
+    load_conns = (load_conn *)calloc(params->connections, sizeof(load_conn));
+    if (load_conns == NULL)
+    {
+        printf("out of memory for %d connections\n", params->connections);
+        return -1;
+    }
+    num_load_conns = params->connections;
+    load_max_requests = params->max_requests;
+    load_duration = params->duration;
+
+    return 0;
+}
+
+/*
+ * Starts the load: opens the connections, each sending its first
+ * request once connected.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int load_start()
+{
+    char msg[512];
+    int i;
+
+    load_started_ns = capture_clock_ns(CLOCK_MONOTONIC);
+    load_last_report_ns = load_started_ns;
+
+    for (i = 0; i < num_load_conns; i++)
+    {
+        load_conns[i].id = i + 1;
+        load_conns[i].sockfd = -1;
+        load_conn_open(&load_conns[i]);
+    }
+    if (load_conns_open == 0)
+    {
+        return -1;
+    }
+
+    if ((load_report_timer = event_add_timer(report_load, NULL)) == -1)
+    {
+        return -1;
+    }
+    event_set_timer(load_report_timer, LOAD_REPORT_INTERVAL);
+
+    if (load_duration > 0)
+    {
+        if ((load_duration_timer = event_add_timer(load_time_up, NULL)) == -1)
+        {
+            return -1;
+        }
+        event_set_timer(load_duration_timer, (long)(load_duration * 1000000));
+    }
+
+    /* the bytes moved are not displayed */
+    sprintf(msg, "load on %s", load_target);
+    show_views(NULL, NULL, msg);
+
+    sprintf(msg, "Sending %d byte requests to %s over %d %s connections, using %s\n",
+            load_request_len, load_target, num_load_conns, socket_type_names[socket_type],
+            event_backend_name());
+    write_info_wnd(msg);
+
+    return 0;
+}
+
+/*
+ * Closes the connections. The counts are kept for the final report.
+ */
+void load_stop()
+{
+    int i;
+
+    if (!load_mode)
+    {
+        return;
+    }
+
+    if (load_stopped_ns == 0)
+    {
+        load_stopped_ns = capture_clock_ns(CLOCK_MONOTONIC);
+    }
+
+    for (i = 0; i < num_load_conns; i++)
+    {
+        load_conn_close(&load_conns[i]);
+    }
+
+    free(load_conns);
+    load_conns = NULL;
+    num_load_conns = 0;
+    free(load_request);
+    load_request = NULL;
+}
+
+/*
+ * Prints the final report of a run to stdout.
+ *
+ * Returns 0 if the run went fine, 1 if a connection failed or no
+ * request was answered
+ */
+int load_print_report()
+{
+    char min[16], mean[16], p50[16], p90[16], p99[16], p999[16], max[16];
+    double secs;
+
+    if (!load_mode || (load_started_ns == 0))
+    {
+        return 0;
+    }
+
+    histogram_add(&load_total, &load_interval);
+    histogram_reset(&load_interval);
+    secs = (load_stopped_ns - load_started_ns) / 1e9;
+
+    printf("load: %lld requests in %.2fs, %.1f requests/s\n", load_requests, secs,
+           (secs > 0) ? load_requests / secs : 0);
+
+    if (load_total.total > 0)
+    {
+        format_latency(load_total.min, min);
+        format_latency((uint64_t)(load_total.sum / load_total.total), mean);
+        format_latency(histogram_percentile(&load_total, 50), p50);
+        format_latency(histogram_percentile(&load_total, 90), p90);
+        format_latency(histogram_percentile(&load_total, 99), p99);
+        format_latency(histogram_percentile(&load_total, 99.9), p999);
+        format_latency(load_total.max, max);
+        printf("latency: min %s, mean %s, p50 %s, p90 %s, p99 %s, p99.9 %s, max %s\n",
+               min, mean, p50, p90, p99, p999, max);
+    }
+
+    printf("%lld connections failed, %lld reopened after the server closed them, "
+           "%lld datagrams lost\n", load_failures, load_reconnects, load_lost);
+
+    return ((load_failures > 0) || (load_requests == 0)) ? 1 : 0;
+}
@@ -0,0 +1,267 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string.h>
+
+#include "../include/lz.h"
+
+/*
+ * Hashes the 4 bytes at p into a table index.
+ */
+static unsigned int lz_hash(const unsigned char *p)
+{
+    unsigned int v;
+
+    memcpy(&v, p, 4);
+    return (v * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+/*
+ * Writes a length continuation (the part of a length beyond 15).
+ *
+ * Returns the new output position, or NULL if out of space.
+ */
+static unsigned char *put_length(unsigned char *op, unsigned char *oend, int len)
+{
+    for (; len >= 255; len -= 255)
+    {
+        if (op >= oend)
+        {
+            return NULL;
+        }
+        *op++ = 255;
+    }
+
+    if (op >= oend)
+    {
+        return NULL;
+    }
+    *op++ = len;
+
+    return op;
+}
+
+/*
+ * Emits one sequence: literals [lit, lit + lit_len) followed by an
+ * optional match (match_len 0 for the final sequence).
+ *
+ * Returns the new output position, or NULL if out of space.
+ */
+static unsigned char *put_sequence(unsigned char *op, unsigned char *oend,
+                                   const unsigned char *lit, int lit_len,
+                                   int offset, int match_len)
+{
+    unsigned char *token;
+    int ml;
+
+    if (op >= oend)
+    {
+        return NULL;
+    }
+
+    ml = (match_len > 0) ? match_len - LZ_MIN_MATCH : 0;
+    token = op++;
+    *token = ((lit_len < 15) ? lit_len : 15) << 4 | ((ml < 15) ? ml : 15);
+
+    if ((lit_len >= 15) && ((op = put_length(op, oend, lit_len - 15)) == NULL))
+    {
+        return NULL;
+    }
+
+    if (oend - op < lit_len)
+    {
+        return NULL;
+    }
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if (match_len == 0)
+    {
+        return op;
+    }
+
+    if (oend - op < 2)
+    {
+        return NULL;
+    }
+    *op++ = offset & 0xff;
+    *op++ = offset >> 8;
+
+    if ((ml >= 15) && ((op = put_length(op, oend, ml - 15)) == NULL))
+    {
+        return NULL;
+    }
+
+    return op;
+}
+
+/*
+ * Compresses len bytes of in into out.
+ *
+ * Returns the compressed size, or 0 if it would not fit in out_cap
+ * bytes (the data does not compress).
+ */
+int lz_compress(const unsigned char *in, int len, unsigned char *out, int out_cap)
+{
+    int table[1 << LZ_HASH_BITS];
+    const unsigned char *ip, *anchor, *limit, *ref, *iend;
+    unsigned char *op, *oend;
+    unsigned int h;
+    int match_len;
+
+    memset(table, -1, sizeof(table));
+
+    ip = anchor = in;
+    iend = in + len;
+    limit = (len > LZ_MIN_MATCH) ? iend - LZ_MIN_MATCH : in;
+    op = out;
+    oend = out + out_cap;
+
+    while (ip < limit)
+    {
+        h = lz_hash(ip);
+        ref = (table[h] >= 0) ? in + table[h] : NULL;
+        table[h] = ip - in;
+
+        if ((ref == NULL) || (ip - ref > 65535) || memcmp(ref, ip, LZ_MIN_MATCH))
+        {
+            ip++;
+            continue;
+        }
+
+        match_len = LZ_MIN_MATCH;
+        while ((ip + match_len < iend) && (ref[match_len] == ip[match_len]))
+        {
+            match_len++;
+        }
+
+        op = put_sequence(op, oend, anchor, ip - anchor, ip - ref, match_len);
+        if (op == NULL)
+        {
+            return 0;
+        }
+
+        ip += match_len;
+        anchor = ip;
+    }
+
+    op = put_sequence(op, oend, anchor, iend - anchor, 0, 0);
+    if (op == NULL)
+    {
+        return 0;
+    }
+
+    return op - out;
+}
+
+/*
+ * Reads a length continuation.
+ *
+ * Returns the new input position, or NULL if the input is truncated.
+ */
+static const unsigned char *get_length(const unsigned char *ip,
+                                       const unsigned char *iend, int *len)
+{
+    do
+    {
+        if (ip >= iend)
+        {
+            return NULL;
+        }
+        *len += *ip;
+    } while (*ip++ == 255);
+
+    return ip;
+}
+
+/*
+ * Decompresses a block of len bytes into out.
+ *
+ * Returns the decompressed size, or -1 if the block is corrupt or
+ * does not fit in out_cap bytes.
+ */
+int lz_decompress(const unsigned char *in, int len, unsigned char *out, int out_cap)
+{
+    const unsigned char *ip, *iend;
+    unsigned char *op, *oend, *ref;
+    int lit_len, match_len, offset;
+
+    ip = in;
+    iend = in + len;
+    op = out;
+    oend = out + out_cap;
+
+    while (ip < iend)
+    {
+        lit_len = *ip >> 4;
+        match_len = *ip++ & 0x0f;
+
+        if ((lit_len == 15) && ((ip = get_length(ip, iend, &lit_len)) == NULL))
+        {
+            return -1;
+        }
+
+        if ((iend - ip < lit_len) || (oend - op < lit_len))
+        {
+            return -1;
+        }
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        /* the final sequence has no match */
+        if (ip == iend)
+        {
+            break;
+        }
+
+        if (iend - ip < 2)
+        {
+            return -1;
+        }
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if ((match_len == 15) && ((ip = get_length(ip, iend, &match_len)) == NULL))
+        {
+            return -1;
+        }
+        match_len += LZ_MIN_MATCH;
+
+        ref = op - offset;
+        if ((offset == 0) || (ref < out) || (oend - op < match_len))
+        {
+            return -1;
+        }
+
+        /* byte by byte: the match may overlap its own output */
+        while (match_len-- > 0)
+        {
+            *op++ = *ref++;
+        }
+    }
+
+    return op - out;
+}
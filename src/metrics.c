@@ -0,0 +1,308 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/formatters.h"
+#include "../include/history.h"
+#include "../include/viewport.h"
+#include "../include/sendqueue.h"
+#include "../include/session.h"
+#include "../include/eventloop.h"
+#include "../include/capture.h"
+#include "../include/histogram.h"
+#include "../include/servermode.h"
+#include "../include/loadgen.h"
+#include "../include/throughput.h"
+#include "../include/replay.h"
+#include "../include/stats.h"
+#include "../include/pipemode.h"
+#include "../include/cmdline.h"
+#include "../include/probe.h"
+#include "../include/metrics.h"
+
+/* the mapped segment and its path, or NULL when not publishing */
+metrics_segment *metrics = NULL;
+char metrics_path[512];
+
+/* the timer publishing from the event loop, and when the segment was
+   last published, for loops without one */
+int metrics_timer = -1;
+uint64_t metrics_published_ns = 0;
+
+/*
+ * Returns what pint is doing, as shown by the readers.
+ */
+char *metrics_mode_name()
+{
+    if (server_mode != SERVER_MODE_NONE)
+    {
+        return server_mode_name(server_mode);
+    }
+    if (load_mode)
+    {
+        return "load";
+    }
+    if (throughput_mode)
+    {
+        return "throughput";
+    }
+    if (replay_mode)
+    {
+        return "replay";
+    }
+    if (pipe_mode)
+    {
+        return "pipe";
+    }
+
+    return (cmdline_params.switches & SWITCH_LISTEN_MASK) ? "listen" : "connect";
+}
+
+/*
+ * Creates the segment, a file under METRICS_DIR unless the name has a
+ * directory of its own. An existing file is overwritten.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int metrics_open(char *name)
+{
+    int fd;
+    void *map;
+
+    snprintf(metrics_path, sizeof(metrics_path), "%s%s",
+             (strchr(name, '/') == NULL) ? METRICS_DIR : "", name);
+
+    fd = open(metrics_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        printf("Couldn't open %s (%s)\n", metrics_path, strerror(errno));
+        return -1;
+    }
+
+    map = MAP_FAILED;
+    if (ftruncate(fd, sizeof(metrics_segment)) == 0)
+    {
+        map = mmap(NULL, sizeof(metrics_segment), PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+    }
+    if (map == MAP_FAILED)
+    {
+        printf("Couldn't map %s (%s)\n", metrics_path, strerror(errno));
+        close(fd);
+        unlink(metrics_path);
+        return -1;
+    }
+    close(fd);
+
+    /* the file starts zero filled, so the sequence is even; the magic
+       goes in last, telling readers that the header is complete */
+    metrics = (metrics_segment *)map;
+    metrics->version = METRICS_VERSION;
+    metrics->size = sizeof(metrics_segment);
+    metrics->pid = getpid();
+    metrics->started_ns = capture_clock_ns(CLOCK_REALTIME);
+    metrics->updated_ns = metrics->started_ns;
+    snprintf(metrics->mode, METRICS_MODE_SIZE, "%s", metrics_mode_name());
+    __atomic_store_n(&metrics->magic, METRICS_MAGIC, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/*
+ * Adds the latencies of a histogram to the power of two buckets of the
+ * segment.
+ */
+void metrics_add_latencies(histogram *h)
+{
+    uint64_t below, counted;
+    int i;
+
+    counted = 0;
+    for (i = 0; i < METRICS_LATENCY_BUCKETS - 1; i++)
+    {
+        below = histogram_count_below(h, (1ULL << i) * 1000);
+        metrics->latency_buckets[i] += below - counted;
+        counted = below;
+    }
+    metrics->latency_buckets[i] += h->total - counted;
+
+    metrics->latency_count += h->total;
+    metrics->latency_sum_ns += (int64_t)h->sum;
+}
+
+/*
+ * Lists a session in the segment, if there is room.
+ */
+void metrics_add_session(int id, int open, char *name, long long bytes_in,
+                         long long bytes_out, long long queued)
+{
+    metrics_session *ms;
+
+    metrics->num_sessions++;
+    metrics->queued += queued;
+    if (metrics->listed_sessions == METRICS_MAX_SESSIONS)
+    {
+        return;
+    }
+
+    ms = &metrics->sessions[metrics->listed_sessions++];
+    ms->id = id;
+    ms->state = open ? METRICS_SESSION_OPEN : METRICS_SESSION_CLOSED;
+    snprintf(ms->name, METRICS_NAME_SIZE, "%s", name);
+    ms->bytes_in = bytes_in;
+    ms->bytes_out = bytes_out;
+    ms->queued = queued;
+}
+
+/*
+ * Copies the counters into the segment. queued is the number of bytes
+ * waiting to be sent that the sessions do not know about.
+ */
+void metrics_publish(int queued)
+{
+    server_conn *c;
+    int i;
+
+    /* odd: readers retry until the update is complete */
+    __atomic_store_n(&metrics->sequence, metrics->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    metrics->updated_ns = capture_clock_ns(CLOCK_REALTIME);
+    snprintf(metrics->mode, METRICS_MODE_SIZE, "%s", metrics_mode_name());
+    metrics->bytes_in = stats_in.bytes;
+    metrics->bytes_out = stats_out.bytes;
+    metrics->reads = stats_in.calls;
+    metrics->sends = stats_out.calls;
+    metrics->errors = stats_errors;
+    metrics->queued = queued;
+
+    metrics->num_sessions = 0;
+    metrics->listed_sessions = 0;
+    memset(metrics->sessions, 0, sizeof(metrics->sessions));
+    for (i = 0; i < num_sessions; i++)
+    {
+        metrics_add_session(sessions[i]->id, sessions[i]->open, sessions[i]->name,
+                            sessions[i]->bytes_in, sessions[i]->bytes_out,
+                            sessions[i]->queue.bytes);
+    }
+    for (i = 0; i < num_server_conns; i++)
+    {
+        c = server_conns[i];
+        metrics_add_session(c->id, TRUE, c->name, c->bytes_in, c->bytes_out,
+                            c->pending_len);
+    }
+
+    metrics->latency_count = 0;
+    metrics->latency_sum_ns = 0;
+    memset(metrics->latency_buckets, 0, sizeof(metrics->latency_buckets));
+    if (load_mode)
+    {
+        /* the interval is added to the total when it is reported */
+        metrics_add_latencies(&load_total);
+        metrics_add_latencies(&load_interval);
+    }
+    else
+    {
+        metrics_add_latencies(&probe_first_bytes);
+    }
+
+    /* even again: the copy is consistent */
+    __atomic_store_n(&metrics->sequence, metrics->sequence + 1, __ATOMIC_RELEASE);
+
+    metrics_published_ns = capture_clock_ns(CLOCK_MONOTONIC);
+}
+
+/*
+ * Timer callback: publishes the counters.
+ */
+void update_metrics(int fd, int events, void *data)
+{
+    event_set_timer(metrics_timer, METRICS_INTERVAL);
+    metrics_publish(0);
+}
+
+/*
+ * Starts publishing from the event loop, if a segment was opened.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int metrics_start()
+{
+    if (metrics == NULL)
+    {
+        return 0;
+    }
+
+    if ((metrics_timer = event_add_timer(update_metrics, NULL)) == -1)
+    {
+        return -1;
+    }
+    event_set_timer(metrics_timer, METRICS_INTERVAL);
+    metrics_publish(0);
+
+    return 0;
+}
+
+/*
+ * Publishes the counters if METRICS_INTERVAL has passed since the last
+ * time; for loops that run without the event loop. queued is as with
+ * metrics_publish().
+ */
+void metrics_tick(int queued)
+{
+    if ((metrics != NULL) &&
+        (capture_clock_ns(CLOCK_MONOTONIC) - metrics_published_ns >=
+         METRICS_INTERVAL * 1000ULL))
+    {
+        metrics_publish(queued);
+    }
+}
+
+/*
+ * Unmaps the segment and removes its file; a reader finding no file
+ * knows that pint is gone.
+ */
+void metrics_close()
+{
+    if (metrics == NULL)
+    {
+        return;
+    }
+
+    munmap(metrics, sizeof(metrics_segment));
+    metrics = NULL;
+    unlink(metrics_path);
+}
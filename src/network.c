@@ -24,9 +24,12 @@ SOFTWARE.
 */
 
 #include <fcntl.h>
+#include <unistd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
 #include <netdb.h>
 #include <asm/errno.h>
 #include <ncurses.h>
@@ -37,6 +40,99 @@ SOFTWARE.
 
 char *socket_type_names[] = {"TCP", "UDP", "RAW"};
 
+/* socket buffer sizes given with -sndbuf and -rcvbuf, or 0 for the
+   system defaults */
+int socket_sndbuf = 0;
+int socket_rcvbuf = 0;
+
+/* TCP options given with -nodelay, -quickack, -notsent and -keepalive;
+   0 leaves the system default */
+int socket_nodelay = 0;
+int socket_quickack = 0;
+int socket_notsent_lowat = 0;
+int socket_keepalive = 0;
+int socket_keepidle = 0;
+int socket_keepintvl = 0;
+int socket_keepcnt = 0;
+
+/*
+ * Sets the socket buffer sizes given on the command line. A server
+ * socket passes them on to the connections it accepts.
+ *
+ * Returns 0 on success, -1 on error with errno set
+ */
+int set_socket_buffers(int sockfd)
+{
+    if ((socket_sndbuf > 0) &&
+        (setsockopt(sockfd, SOL_SOCKET, SO_SNDBUF, &socket_sndbuf, sizeof(int)) == -1))
+    {
+        return -1;
+    }
+
+    if ((socket_rcvbuf > 0) &&
+        (setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &socket_rcvbuf, sizeof(int)) == -1))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Sets an integer option of a socket, if it was given.
+ *
+ * Returns 0 on success, -1 on error with errno set
+ */
+int set_option(int sockfd, int level, int option, int value)
+{
+    if (value == 0)
+    {
+        return 0;
+    }
+
+    return setsockopt(sockfd, level, option, &value, sizeof(int));
+}
+
+/*
+ * Sets the TCP options given on the command line on a connection.
+ * Sockets of other types are left alone.
+ *
+ * Returns 0 on success, -1 on error with errno set
+ */
+int set_tcp_options(int sockfd)
+{
+    if (socket_type != SOCKTYPE_TCP)
+    {
+        return 0;
+    }
+
+    if ((set_option(sockfd, IPPROTO_TCP, TCP_NODELAY, socket_nodelay) == -1) ||
+        (set_option(sockfd, IPPROTO_TCP, TCP_QUICKACK, socket_quickack) == -1) ||
+        (set_option(sockfd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, socket_notsent_lowat) == -1) ||
+        (set_option(sockfd, SOL_SOCKET, SO_KEEPALIVE, socket_keepalive) == -1) ||
+        (set_option(sockfd, IPPROTO_TCP, TCP_KEEPIDLE, socket_keepidle) == -1) ||
+        (set_option(sockfd, IPPROTO_TCP, TCP_KEEPINTVL, socket_keepintvl) == -1) ||
+        (set_option(sockfd, IPPROTO_TCP, TCP_KEEPCNT, socket_keepcnt) == -1))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Turns quick acknowledgements back on after a read. The kernel
+ * switches them off again by itself, so -quickack holds only as long
+ * as it is renewed.
+ */
+void renew_quickack(int sockfd)
+{
+    if (socket_quickack && (socket_type == SOCKTYPE_TCP))
+    {
+        set_option(sockfd, IPPROTO_TCP, TCP_QUICKACK, socket_quickack);
+    }
+}
+
 /*
  * Sets a descriptor into non-blocking mode
  *
@@ -56,6 +152,61 @@ int set_nonblocking(int fd)
     }
 }
 
+/*
+ * Looks up the IPv4 address of a remote host.
+ *
+ * Returns 0 on success, -1 if the host is not known
+ */
+int resolve_remote_host(char *remote_host, int remote_port, struct sockaddr_in *remote_addr)
+{
+    struct hostent *remote_hostent;
+
+    memset(remote_addr, 0, sizeof(struct sockaddr_in));
+    remote_addr->sin_family = AF_INET;
+    remote_addr->sin_port = htons(remote_port);
+
+    remote_hostent = (struct hostent *)gethostbyname(remote_host);
+    if ((remote_hostent == NULL) || (remote_hostent->h_addrtype != AF_INET))
+    {
+        return -1;
+    }
+    memcpy(&remote_addr->sin_addr, remote_hostent->h_addr, remote_hostent->h_length);
+
+    return 0;
+}
+
+/*
+ * Opens a non-blocking socket of the current type and starts
+ * connecting it to an address. A TCP socket reports the outcome by
+ * becoming writable.
+ *
+ * Returns the socket descriptor, or -1 on error with errno set
+ */
+int start_connect(struct sockaddr_in *remote_addr)
+{
+    int sockfd, saved_errno;
+
+    sockfd = socket(AF_INET, (socket_type == SOCKTYPE_UDP) ? SOCK_DGRAM : SOCK_STREAM, 0);
+    if (sockfd == -1)
+    {
+        return -1;
+    }
+
+    if ((fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) | O_NONBLOCK) == -1) ||
+        (set_socket_buffers(sockfd) == -1) ||
+        (set_tcp_options(sockfd) == -1) ||
+        ((connect(sockfd, (struct sockaddr *)remote_addr, sizeof(struct sockaddr_in)) == -1) &&
+         (errno != EINPROGRESS)))
+    {
+        saved_errno = errno;
+        close(sockfd);
+        errno = saved_errno;
+        return -1;
+    }
+
+    return sockfd;
+}
+
 /*
  * Connects to a remote host.
  *
@@ -66,15 +217,14 @@ int connect_to_remote_host(char *remote_host, int remote_port)
     int sockfd;
     int flags;
     struct sockaddr_in remote_addr;
-    struct hostent *remote_hostent;
     char msg[512];
 
-    memset(&remote_addr, 0, sizeof(remote_addr));
-    remote_addr.sin_family = AF_INET;
-    remote_addr.sin_port = htons(remote_port);
-    remote_hostent = (struct hostent *)gethostbyname(remote_host);
-
-    memcpy(&remote_addr.sin_addr, remote_hostent->h_addr, remote_hostent->h_length);
+    if (resolve_remote_host(remote_host, remote_port, &remote_addr) == -1)
+    {
+        deinit_curses();
+        printf("Unknown host %s\n", remote_host);
+        return -1;
+    }
 
     switch (socket_type)
     {
@@ -98,6 +248,14 @@ int connect_to_remote_host(char *remote_host, int remote_port)
         return -1;
     }
 
+    if ((set_socket_buffers(sockfd) == -1) || (set_tcp_options(sockfd) == -1))
+    {
+        deinit_curses();
+        printf("setsockopt() failed (%s)\n", strerror(errno));
+
+        return -1;
+    }
+
     if (connect(sockfd, (struct sockaddr *)&remote_addr, sizeof(remote_addr)) == -1)
     {
         deinit_curses();
@@ -157,6 +315,13 @@ int create_server_socket(int local_port)
         return -1;
     }
 
+    if (set_socket_buffers(sockfd) == -1)
+    {
+        deinit_curses();
+        printf("setsockopt() failed (%s)\n", strerror(errno));
+        return -1;
+    }
+
     if (bind(sockfd, (struct sockaddr *)&myaddr, sizeof(myaddr)))
     {
         deinit_curses();
@@ -166,7 +331,7 @@ int create_server_socket(int local_port)
 
     if (socket_type == SOCKTYPE_TCP)
     {
-        if (listen(sockfd, 5))
+        if (listen(sockfd, LISTEN_BACKLOG))
         {
             deinit_curses();
             printf("listen() failed (%s)\n", strerror(errno));
@@ -204,8 +369,107 @@ int accept_incoming_connection(int server_sockfd)
         return -1;
     }
 
+    if (set_tcp_options(sockfd) == -1)
+    {
+        deinit_curses();
+        printf("setsockopt() failed (%s)\n", strerror(errno));
+        close(sockfd);
+        return -1;
+    }
+
     sprintf(msg, "Got connection from %s\n", inet_ntoa(remote_addr.sin_addr));
     write_info_wnd(msg);
 
     return sockfd;
 }
+
+/*
+ * Accepts a remote TCP connection waiting on a non-blocking server
+ * socket. Errors other than running out of pending connections are
+ * reported in the info window.
+ *
+ * Returns socket descriptor for the new connection, or -1 if there is
+ * none or on error
+ */
+int accept_pending_connection(int server_sockfd)
+{
+    int sockfd;
+    char msg[512];
+
+    sockfd = accept(server_sockfd, NULL, NULL);
+    if ((sockfd == -1) && (errno != EAGAIN) && (errno != EINTR) &&
+        (errno != ECONNABORTED))
+    {
+        sprintf(msg, "accept() failed (%s)\n", strerror(errno));
+        write_info_wnd(msg);
+    }
+
+    /* the connection is still of use with the defaults */
+    if ((sockfd != -1) && (set_tcp_options(sockfd) == -1))
+    {
+        sprintf(msg, "setsockopt() failed (%s)\n", strerror(errno));
+        write_info_wnd(msg);
+    }
+
+    return sockfd;
+}
+
+/*
+ * Reads the first datagram arriving at a UDP server socket and
+ * connects the socket to its sender, so that plain read() and write()
+ * can be used from then on.
+ *
+ * Returns the number of bytes read into buf, or -1 on error
+ */
+int accept_udp_peer(int sockfd, unsigned char *buf, int len)
+{
+    struct sockaddr_in remote_addr;
+    socklen_t remote_addr_len;
+    char msg[512];
+    int n;
+
+    remote_addr_len = sizeof(remote_addr);
+    n = recvfrom(sockfd, buf, len, 0,
+                 (struct sockaddr *)&remote_addr, &remote_addr_len);
+
+    if (n < 0)
+    {
+        sprintf(msg, "recvfrom() failed (%s)\n", strerror(errno));
+        write_info_wnd(msg);
+        return -1;
+    }
+
+    if (connect(sockfd, (struct sockaddr *)&remote_addr, remote_addr_len))
+    {
+        sprintf(msg, "UDP: Error connecting to %s (%s)\n",
+                inet_ntoa(remote_addr.sin_addr), strerror(errno));
+        write_info_wnd(msg);
+    }
+    else
+    {
+        sprintf(msg, "Using %s:%d for udp remote host:port\n",
+                inet_ntoa(remote_addr.sin_addr), ntohs(remote_addr.sin_port));
+        write_info_wnd(msg);
+    }
+
+    return n;
+}
+
+/*
+ * Writes the address of the remote end of a socket into name as
+ * host:port, or a placeholder if the socket is not connected.
+ */
+void get_peer_name(int sockfd, char *name, int len)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len;
+
+    addr_len = sizeof(addr);
+    if (getpeername(sockfd, (struct sockaddr *)&addr, &addr_len) == -1)
+    {
+        snprintf(name, len, "waiting for peer");
+        return;
+    }
+
+    snprintf(name, len, "%s:%d", inet_ntoa(addr.sin_addr), ntohs(addr.sin_port));
+}
@@ -0,0 +1,583 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/capture.h"
+#include "../include/pcapng.h"
+
+/* TRUE while sessions are exported as they go */
+int pcapng_writing = FALSE;
+
+int pcapng_fd = -1;
+unsigned char pcapng_buffer[PCAPNG_BUFFER_SIZE];
+int pcapng_used = 0;
+long long pcapng_packets = 0;
+
+/* ties the monotonic record timestamps to the wall clock */
+uint64_t pcapng_realtime_base = 0;
+uint64_t pcapng_monotonic_base = 0;
+
+/* flows by session id */
+pcapng_flow *pcapng_flows = NULL;
+int pcapng_flows_size = 0;
+
+/* the made up MAC addresses of the two ends */
+unsigned char pcapng_local_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+unsigned char pcapng_peer_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+
+/*
+ * Writes out the buffered blocks.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int pcapng_flush()
+{
+    ssize_t n;
+    int done;
+
+    for (done = 0; done < pcapng_used; done += n)
+    {
+        n = write(pcapng_fd, pcapng_buffer + done, pcapng_used - done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                n = 0;
+                continue;
+            }
+            return -1;
+        }
+    }
+
+    pcapng_used = 0;
+
+    return 0;
+}
+
+/*
+ * Returns room for a block of len bytes in the buffer, flushing it
+ * first if needed, or NULL on a write error.
+ */
+unsigned char *pcapng_reserve(int len)
+{
+    if ((pcapng_used + len > PCAPNG_BUFFER_SIZE) && (pcapng_flush() == -1))
+    {
+        return NULL;
+    }
+
+    return pcapng_buffer + pcapng_used;
+}
+
+/*
+ * Stores integers in network byte order.
+ */
+void put16(unsigned char *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v;
+}
+
+void put32(unsigned char *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+/*
+ * Adds bytes to an Internet checksum sum (RFC 1071). Only the last
+ * piece summed may have an odd length.
+ */
+uint32_t checksum_add(uint32_t sum, const unsigned char *p, int len)
+{
+    int i;
+
+    for (i = 0; i + 1 < len; i += 2)
+    {
+        sum += (p[i] << 8) | p[i + 1];
+    }
+    if (len & 1)
+    {
+        sum += p[len - 1] << 8;
+    }
+
+    return sum;
+}
+
+/*
+ * Folds a sum into a checksum.
+ */
+uint16_t checksum_fold(uint32_t sum)
+{
+    while (sum >> 16)
+    {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+    return ~sum;
+}
+
+/*
+ * Writes the section header and the description of the one Ethernet
+ * interface all packets are on.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int pcapng_write_header()
+{
+    uint32_t *b;
+
+    /* section header: no options, unknown section length */
+    if ((b = (uint32_t *)pcapng_reserve(28)) == NULL)
+    {
+        return -1;
+    }
+    b[0] = PCAPNG_SECTION_HEADER;
+    b[1] = 28;
+    b[2] = PCAPNG_BYTE_ORDER_MAGIC;
+    b[3] = 1;  /* version 1.0 */
+    b[4] = 0xffffffff;
+    b[5] = 0xffffffff;
+    b[6] = 28;
+    pcapng_used += 28;
+
+    /* interface description with nanosecond timestamps */
+    if ((b = (uint32_t *)pcapng_reserve(32)) == NULL)
+    {
+        return -1;
+    }
+    b[0] = PCAPNG_INTERFACE_DESCRIPTION;
+    b[1] = 32;
+    b[2] = PCAPNG_LINKTYPE_ETHERNET;  /* and reserved 0 */
+    b[3] = 0;  /* no snap length limit */
+    b[4] = PCAPNG_OPTION_TSRESOL | (1 << 16);
+    b[5] = PCAPNG_TSRESOL_NANOSECONDS;
+    b[6] = 0;  /* end of options */
+    b[7] = 32;
+    pcapng_used += 32;
+
+    return 0;
+}
+
+/*
+ * Creates a pcapng file. Capture timestamps are turned into wall
+ * clock time with the given pair of clock readings.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int pcapng_open(char *path, uint64_t realtime_ns, uint64_t monotonic_ns)
+{
+    pcapng_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (pcapng_fd == -1)
+    {
+        printf("Couldn't open %s (%s)\n", path, strerror(errno));
+        return -1;
+    }
+
+    pcapng_used = 0;
+    pcapng_packets = 0;
+    pcapng_realtime_base = realtime_ns;
+    pcapng_monotonic_base = monotonic_ns;
+
+    if (pcapng_write_header() == -1)
+    {
+        printf("Couldn't write %s (%s)\n", path, strerror(errno));
+        close(pcapng_fd);
+        pcapng_fd = -1;
+        return -1;
+    }
+
+    pcapng_writing = TRUE;
+
+    return 0;
+}
+
+/*
+ * Returns the flow of a session, creating it if needed, or NULL if out
+ * of memory.
+ */
+pcapng_flow *pcapng_get_flow(int session)
+{
+    pcapng_flow *tmp;
+    int size;
+
+    if (session >= pcapng_flows_size)
+    {
+        size = (pcapng_flows_size > 0) ? pcapng_flows_size : 16;
+        while (size <= session)
+        {
+            size *= 2;
+        }
+
+        tmp = (pcapng_flow *)realloc(pcapng_flows, size * sizeof(pcapng_flow));
+        if (tmp == NULL)
+        {
+            return NULL;
+        }
+        memset(tmp + pcapng_flows_size, 0,
+               (size - pcapng_flows_size) * sizeof(pcapng_flow));
+
+        pcapng_flows = tmp;
+        pcapng_flows_size = size;
+    }
+
+    return &pcapng_flows[session];
+}
+
+/*
+ * Appends a packet of a flow, sent by the local end if from_local is
+ * set: an enhanced packet block holding the Ethernet frame, with IPv4
+ * and TCP or UDP headers in front of the payload.
+ *
+ * Returns 0 on success, -1 on a write error
+ */
+int pcapng_packet(pcapng_flow *f, int from_local, uint64_t ts_ns, int flags,
+                  const unsigned char *payload, int len)
+{
+    unsigned char *b, *eth, *ip, *l4, pseudo[12];
+    uint32_t *w, src, dst, sum;
+    uint16_t sport, dport;
+    int l4_size, frame, block;
+
+    l4_size = f->udp ? PCAPNG_UDP_SIZE : PCAPNG_TCP_SIZE;
+    frame = PCAPNG_ETHERNET_SIZE + PCAPNG_IP_SIZE + l4_size + len;
+    block = 28 + ((frame + 3) & ~3) + 4;
+
+    if ((b = pcapng_reserve(block)) == NULL)
+    {
+        return -1;
+    }
+    memset(b, 0, block);
+
+    /* the addresses are kept in network byte order */
+    src = ntohl(from_local ? f->local_addr : f->peer_addr);
+    dst = ntohl(from_local ? f->peer_addr : f->local_addr);
+    sport = ntohs(from_local ? f->local_port : f->peer_port);
+    dport = ntohs(from_local ? f->peer_port : f->local_port);
+
+    w = (uint32_t *)b;
+    w[0] = PCAPNG_ENHANCED_PACKET;
+    w[1] = block;
+    w[2] = 0;  /* interface */
+    w[3] = ts_ns >> 32;
+    w[4] = ts_ns;
+    w[5] = frame;
+    w[6] = frame;
+    *(uint32_t *)(b + block - 4) = block;
+
+    eth = b + 28;
+    memcpy(eth, from_local ? pcapng_peer_mac : pcapng_local_mac, 6);
+    memcpy(eth + 6, from_local ? pcapng_local_mac : pcapng_peer_mac, 6);
+    put16(eth + 12, 0x0800);
+
+    ip = eth + PCAPNG_ETHERNET_SIZE;
+    ip[0] = 0x45;
+    put16(ip + 2, PCAPNG_IP_SIZE + l4_size + len);
+    put16(ip + 4, f->ip_id++);
+    put16(ip + 6, 0x4000);  /* don't fragment */
+    ip[8] = 64;
+    ip[9] = f->udp ? IPPROTO_UDP : IPPROTO_TCP;
+    put32(ip + 12, src);
+    put32(ip + 16, dst);
+    put16(ip + 10, checksum_fold(checksum_add(0, ip, PCAPNG_IP_SIZE)));
+
+    l4 = ip + PCAPNG_IP_SIZE;
+    put16(l4, sport);
+    put16(l4 + 2, dport);
+    if (f->udp)
+    {
+        put16(l4 + 4, PCAPNG_UDP_SIZE + len);
+    }
+    else
+    {
+        put32(l4 + 4, from_local ? f->local_seq : f->peer_seq);
+        put32(l4 + 8, (flags & PCAPNG_TCP_ACK) ? (from_local ? f->peer_seq : f->local_seq) : 0);
+        l4[12] = (PCAPNG_TCP_SIZE / 4) << 4;
+        l4[13] = flags;
+        put16(l4 + 14, 65535);
+    }
+    memcpy(l4 + l4_size, payload, len);
+
+    /* the TCP and UDP checksums cover a pseudo header */
+    memcpy(pseudo, ip + 12, 8);
+    pseudo[8] = 0;
+    pseudo[9] = ip[9];
+    put16(pseudo + 10, l4_size + len);
+    sum = checksum_add(checksum_add(0, pseudo, 12), l4, l4_size + len);
+    put16(l4 + (f->udp ? 6 : 16), checksum_fold(sum));
+
+    pcapng_used += block;
+    pcapng_packets++;
+
+    if (!f->udp)
+    {
+        if (from_local)
+        {
+            f->local_seq += len + ((flags & (PCAPNG_TCP_SYN | PCAPNG_TCP_FIN)) ? 1 : 0);
+        }
+        else
+        {
+            f->peer_seq += len + ((flags & (PCAPNG_TCP_SYN | PCAPNG_TCP_FIN)) ? 1 : 0);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Turns a capture record into packets: the handshake of a TCP session
+ * when it is opened, its bytes cut into segments or datagrams, and
+ * the closing exchange of FINs.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int pcapng_record(capture_record *rec, const unsigned char *buf)
+{
+    capture_endpoints *ends;
+    pcapng_flow *f;
+    uint64_t ts;
+    int from_local, n, max, r;
+
+    if ((f = pcapng_get_flow(rec->session)) == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    ts = pcapng_realtime_base + (rec->timestamp_ns - pcapng_monotonic_base);
+    r = 0;
+
+    switch (rec->type)
+    {
+    case CAPTURE_OPEN:
+        if (rec->length >= sizeof(capture_endpoints))
+        {
+            ends = (capture_endpoints *)buf;
+            f->local_addr = ends->local_addr;
+            f->local_port = ends->local_port;
+            f->peer_addr = ends->peer_addr;
+            f->peer_port = ends->peer_port;
+        }
+        f->udp = (rec->flags & CAPTURE_FLAG_UDP) != 0;
+
+        if (f->udp || f->open)
+        {
+            f->open = TRUE;
+            break;
+        }
+
+        /* made up initial sequence numbers, apart for each session */
+        f->local_seq = 0x10000000 + rec->session * 0x00100000;
+        f->peer_seq = 0x80000000 + rec->session * 0x00100000;
+        f->open = TRUE;
+
+        /* the end that connected sends the SYN */
+        from_local = !(rec->flags & CAPTURE_FLAG_ACCEPTED);
+        r = pcapng_packet(f, from_local, ts, PCAPNG_TCP_SYN, NULL, 0);
+        if (r == 0)
+        {
+            r = pcapng_packet(f, !from_local, ts, PCAPNG_TCP_SYN | PCAPNG_TCP_ACK, NULL, 0);
+        }
+        if (r == 0)
+        {
+            r = pcapng_packet(f, from_local, ts, PCAPNG_TCP_ACK, NULL, 0);
+        }
+        break;
+
+    case CAPTURE_IN:
+    case CAPTURE_OUT:
+        from_local = (rec->type == CAPTURE_OUT);
+        max = f->udp ? 65507 : PCAPNG_SEGMENT_SIZE;
+
+        for (n = 0; (n < (int)rec->length) && (r == 0); n += max)
+        {
+            r = pcapng_packet(f, from_local, ts,
+                              f->udp ? 0 : PCAPNG_TCP_PSH | PCAPNG_TCP_ACK, buf + n,
+                              ((int)rec->length - n < max) ? (int)rec->length - n : max);
+        }
+        break;
+
+    case CAPTURE_CLOSE:
+        if (!f->udp && f->open)
+        {
+            r = pcapng_packet(f, TRUE, ts, PCAPNG_TCP_FIN | PCAPNG_TCP_ACK, NULL, 0);
+            if (r == 0)
+            {
+                r = pcapng_packet(f, FALSE, ts, PCAPNG_TCP_FIN | PCAPNG_TCP_ACK, NULL, 0);
+            }
+            if (r == 0)
+            {
+                r = pcapng_packet(f, TRUE, ts, PCAPNG_TCP_ACK, NULL, 0);
+            }
+        }
+        f->open = FALSE;
+        break;
+    }
+
+    return r;
+}
+
+/*
+ * Exports a record of a live session. A write error stops the export.
+ */
+void pcapng_write(capture_record *rec, const unsigned char *buf)
+{
+    char msg[512];
+
+    if (pcapng_record(rec, buf) == -1)
+    {
+        sprintf(msg, "pcapng export stopped (%s)\n", strerror(errno));
+        pcapng_close();
+        write_info_wnd(msg);
+    }
+}
+
+/*
+ * Writes out what is buffered and closes the file.
+ */
+void pcapng_close()
+{
+    if (pcapng_fd == -1)
+    {
+        return;
+    }
+
+    pcapng_flush();
+    close(pcapng_fd);
+    pcapng_fd = -1;
+    pcapng_writing = FALSE;
+
+    free(pcapng_flows);
+    pcapng_flows = NULL;
+    pcapng_flows_size = 0;
+}
+
+/*
+ * Converts a capture log into a pcapng file. The log is streamed: only
+ * the record at hand is in memory.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int pcapng_convert(char *capture_path, char *path)
+{
+    FILE *in;
+    capture_header header;
+    capture_record rec;
+    unsigned char *payload, *tmp;
+    uint32_t payload_size;
+    long long records;
+    int pad_len, r;
+
+    in = fopen(capture_path, "r");
+    if (in == NULL)
+    {
+        printf("Couldn't open %s (%s)\n", capture_path, strerror(errno));
+        return -1;
+    }
+    posix_fadvise(fileno(in), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if ((fread(&header, sizeof(header), 1, in) != 1) ||
+        (memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0) ||
+        (header.version != CAPTURE_VERSION) ||
+        (fseek(in, header.header_size, SEEK_SET) == -1))
+    {
+        printf("%s is not a pint capture\n", capture_path);
+        fclose(in);
+        return -1;
+    }
+
+    if (pcapng_open(path, header.start_realtime_ns, header.start_monotonic_ns) == -1)
+    {
+        fclose(in);
+        return -1;
+    }
+
+    payload = NULL;
+    payload_size = 0;
+    records = 0;
+    r = 0;
+
+    while ((r == 0) && (fread(&rec, sizeof(rec), 1, in) == 1) &&
+           (rec.type != CAPTURE_END))
+    {
+        if (rec.length > payload_size)
+        {
+            tmp = (unsigned char *)realloc(payload, rec.length);
+            if (tmp == NULL)
+            {
+                printf("out of memory for a record of %u bytes\n", rec.length);
+                r = -1;
+                break;
+            }
+            payload = tmp;
+            payload_size = rec.length;
+        }
+
+        if (fread(payload, 1, rec.length, in) != rec.length)
+        {
+            printf("%s ends in the middle of a record\n", capture_path);
+            break;
+        }
+
+        pad_len = (CAPTURE_ALIGN - (sizeof(rec) + rec.length) % CAPTURE_ALIGN) % CAPTURE_ALIGN;
+        fseek(in, pad_len, SEEK_CUR);
+
+        if ((r = pcapng_record(&rec, payload)) == -1)
+        {
+            printf("Couldn't write %s (%s)\n", path, strerror(errno));
+        }
+        records++;
+    }
+
+    if ((r == 0) && (pcapng_flush() == -1))
+    {
+        printf("Couldn't write %s (%s)\n", path, strerror(errno));
+        r = -1;
+    }
+
+    if (r == 0)
+    {
+        printf("%lld records of %s written to %s as %lld packets\n",
+               records, capture_path, path, pcapng_packets);
+    }
+
+    pcapng_close();
+    free(payload);
+    fclose(in);
+
+    return r;
+}
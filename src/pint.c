@@ -24,15 +24,18 @@ SOFTWARE.
 */
 
 #include <string.h>
+#include <stdint.h>
 #include <signal.h>
 #include <unistd.h>
 #include <ncurses.h>
 
+#include <time.h>
 #include <sys/time.h>
 #include <sys/socket.h>
 #include <asm/errno.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <netinet/in.h>
 
 #include "../include/pint.h"
@@ -40,21 +43,33 @@ SOFTWARE.
 #include "../include/formatters.h"
 #include "../include/cmdline.h"
 #include "../include/network.h"
-
-/* stdin reading stuff */
-unsigned char stdin_input_buffer[STDIN_INPUT_BUFFER_SIZE];
-int stdin_bytes_read;
+#include "../include/history.h"
+#include "../include/viewport.h"
+#include "../include/batch.h"
+#include "../include/stats.h"
+#include "../include/pipemode.h"
+#include "../include/eventloop.h"
+#include "../include/sendqueue.h"
+#include "../include/session.h"
+#include "../include/servermode.h"
+#include "../include/capture.h"
+#include "../include/replay.h"
+#include "../include/pcapng.h"
+#include "../include/viewer.h"
+#include "../include/capdiff.h"
+#include "../include/histogram.h"
+#include "../include/loadgen.h"
+#include "../include/probe.h"
+#include "../include/throughput.h"
+#include "../include/metrics.h"
+#include "../include/tcpinfo.h"
+
+/* stdin reading stuff; the line being typed is kept per session */
 char escape_chars[ESCAPE_CHARS_BUFFER_SIZE];
 int escape_chars_read;
 long last_escape_char_sec;
 long last_escape_char_usec;
 
-/* bytes written to sock in/out wnds for later reformatting */
-unsigned char sock_in_buffer[SOCK_IN_BUFFER_SIZE];
-unsigned char sock_out_buffer[SOCK_OUT_BUFFER_SIZE];
-int bytes_in_sock_in_buffer;
-int bytes_in_sock_out_buffer;
-
 /* enter key behaviour mode */
 int enter_behaviour_mode;
 
@@ -64,10 +79,14 @@ int stdin_input_interpretation_mode;
 /* socket type: TCP UDP or RAW */
 int socket_type;
 
-/* UDP remote address; used for listen mode with UDP */
-struct sockaddr_in udp_remote_addr;
-socklen_t udp_remote_addr_len;
-int udp_remote_addr_given;
+/* TCP server socket accepting further sessions, or -1 */
+int server_sockfd;
+
+/* TRUE while batch mode leaves stdin unread for a full send queue */
+int stdin_paused;
+
+/* status pint exits with when it is done */
+int exit_code;
 
 /* key sequences for special keys */
 int seq_f1_len;
@@ -78,6 +97,44 @@ int seq_f3_len;
 char *seq_f3;
 int seq_f4_len;
 char *seq_f4;
+int seq_f5_len;
+char *seq_f5;
+int seq_f6_len;
+char *seq_f6;
+int seq_pgup_len;
+char *seq_pgup;
+int seq_pgdn_len;
+char *seq_pgdn;
+
+/* window scrolled by PgUp/PgDn */
+int scroll_target;
+
+/* event loop timer for postponed frames, and whether it is armed */
+int frame_timer;
+int frame_timer_armed;
+
+/*
+ * Reads the sequence of a single key from termcap.
+ *
+ * Returns a copy of the sequence, or NULL if the terminal lacks the key.
+ */
+char *read_key_sequence(char *cap, int *len)
+{
+	char *tmp, *seq;
+
+	tmp = (char *)tgetstr(cap, NULL);
+	if (tmp == NULL)
+	{
+		*len = 0;
+		return NULL;
+	}
+
+	*len = strlen(tmp);
+	seq = (char *)malloc(*len * sizeof(char) + 1);
+	strcpy(seq, tmp);
+
+	return seq;
+}
 
 /*
  * Reads escape sequences for function keys etc. from
@@ -85,7 +142,7 @@ char *seq_f4;
  */
 void read_escape_sequences()
 {
-	char *termname, *tmp;
+	char *termname;
 
 	termname = (char *)getenv("TERM");
 	if (termname == NULL)
@@ -101,25 +158,14 @@ void read_escape_sequences()
 	}
 	else
 	{
-		tmp = (char *)tgetstr("k1", NULL);
-		seq_f1_len = strlen(tmp);
-		seq_f1 = (char *)malloc(seq_f1_len * sizeof(char) + 1);
-		strcpy(seq_f1, tmp);
-
-		tmp = (char *)tgetstr("k2", NULL);
-		seq_f2_len = strlen(tmp);
-		seq_f2 = (char *)malloc(seq_f2_len * sizeof(char) + 1);
-		strcpy(seq_f2, tmp);
-
-		tmp = (char *)tgetstr("k3", NULL);
-		seq_f3_len = strlen(tmp);
-		seq_f3 = (char *)malloc(seq_f3_len * sizeof(char) + 1);
-		strcpy(seq_f3, tmp);
-
-		tmp = (char *)tgetstr("k4", NULL);
-		seq_f4_len = strlen(tmp);
-		seq_f4 = (char *)malloc(seq_f4_len * sizeof(char) + 1);
-		strcpy(seq_f4, tmp);
+		seq_f1 = read_key_sequence("k1", &seq_f1_len);
+		seq_f2 = read_key_sequence("k2", &seq_f2_len);
+		seq_f3 = read_key_sequence("k3", &seq_f3_len);
+		seq_f4 = read_key_sequence("k4", &seq_f4_len);
+		seq_f5 = read_key_sequence("k5", &seq_f5_len);
+		seq_f6 = read_key_sequence("k6", &seq_f6_len);
+		seq_pgup = read_key_sequence("kP", &seq_pgup_len);
+		seq_pgdn = read_key_sequence("kN", &seq_pgdn_len);
 	}
 }
 
@@ -131,12 +177,16 @@ void init()
 	int rows, cols;
 	int win_rows;
 
+	sigset_t winch;
+
 	signal(SIGINT, finish);
 	signal(SIGKILL, finish);
-	signal(SIGWINCH, resize);
 
-	memset(stdin_input_buffer, 0, STDIN_INPUT_BUFFER_SIZE * sizeof(char));
-	stdin_bytes_read = 0;
+	/* window size changes are handled by the event loop; keep them
+	   queued until it runs */
+	sigemptyset(&winch);
+	sigaddset(&winch, SIGWINCH);
+	sigprocmask(SIG_BLOCK, &winch, NULL);
 
 	memset(escape_chars, 0, ESCAPE_CHARS_BUFFER_SIZE * sizeof(char));
 	escape_chars_read = 0;
@@ -146,13 +196,13 @@ void init()
 	enter_behaviour_mode = ENTER_SENDS_CRLF;
 	stdin_input_interpretation_mode = STDIN_INTERP_PLAIN_TEXT;
 
-	bytes_in_sock_in_buffer = 0;
-	bytes_in_sock_out_buffer = 0;
-
-	udp_remote_addr_given = FALSE;
-	memset(&udp_remote_addr, 0, sizeof(udp_remote_addr));
+	server_sockfd = -1;
+	stdin_paused = FALSE;
+	exit_code = 0;
 
-	read_escape_sequences();
+	scroll_target = SCROLL_SOCK_IN;
+	frame_timer = -1;
+	frame_timer_armed = FALSE;
 }
 
 /*
@@ -160,6 +210,18 @@ void init()
  */
 void deinit()
 {
+	batch_close();
+	server_mode_stop();
+	event_loop_deinit();
+
+	load_stop();
+	throughput_stop();
+	metrics_close();
+	destroy_sessions();
+	capture_close();
+	pcapng_close();
+	view_close();
+
 	if (seq_f1 != NULL)
 		free(seq_f1);
 	if (seq_f2 != NULL)
@@ -168,6 +230,14 @@ void deinit()
 		free(seq_f3);
 	if (seq_f4 != NULL)
 		free(seq_f4);
+	if (seq_f5 != NULL)
+		free(seq_f5);
+	if (seq_f6 != NULL)
+		free(seq_f6);
+	if (seq_pgup != NULL)
+		free(seq_pgup);
+	if (seq_pgdn != NULL)
+		free(seq_pgdn);
 }
 
 /*
@@ -200,6 +270,171 @@ int array_match(int len1, char *array1, int len2, char *array2)
 	;
 }
 
+/*
+ * Scrolls the window selected with F5 by a page; direction is -1 for
+ * older data and 1 for newer.
+ */
+void scroll_window(int direction)
+{
+	if (active_session == NULL)
+	{
+		return;
+	}
+
+	if (scroll_target == SCROLL_SOCK_IN)
+	{
+		viewport_scroll(sock_in_view, direction * (sock_in_wnd_rows - 1));
+		mark_dirty(DIRTY_SOCK_IN | DIRTY_FRAMES);
+	}
+	else
+	{
+		viewport_scroll(sock_out_view, direction * (sock_out_wnd_rows - 1));
+		mark_dirty(DIRTY_SOCK_OUT | DIRTY_FRAMES);
+	}
+}
+
+/*
+ * Formats a byte count with a K/M/G suffix.
+ */
+void format_size(long long bytes, char *s)
+{
+	if (bytes >= 1024LL * 1024 * 1024)
+		sprintf(s, "%.1fG", bytes / (1024.0 * 1024 * 1024));
+	else if (bytes >= 1024 * 1024)
+		sprintf(s, "%.1fM", bytes / (1024.0 * 1024));
+	else if (bytes >= 1024)
+		sprintf(s, "%.1fK", bytes / 1024.0);
+	else
+		sprintf(s, "%lld", bytes);
+}
+
+/*
+ * Returns the microseconds elapsed since the given time.
+ */
+long long usec_since(struct timeval *since)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+
+	return (now.tv_sec - since->tv_sec) * 1000000LL +
+		   (now.tv_usec - since->tv_usec);
+}
+
+/*
+ * Formats the rate of moving bytes in usec microseconds.
+ */
+void format_rate(long long bytes, long long usec, char *s)
+{
+	char size[16];
+
+	if (usec <= 0)
+	{
+		usec = 1;
+	}
+
+	format_size((long long)(bytes * 1000000.0 / usec), size);
+	sprintf(s, "%s/s", size);
+}
+
+/*
+ * Shows the history size, resident memory and compression ratio of
+ * the active session in the info window title, and the depth of its
+ * send queue while anything is waiting there.
+ */
+void update_history_title()
+{
+	char title[192], kept[16], resident[16], queued[16];
+	long long kept_bytes, resident_bytes, packed_raw, packed_bytes;
+	history *in, *out;
+
+	if (active_session == NULL)
+	{
+		set_info_title("Info");
+		return;
+	}
+
+	if (view_mode)
+	{
+		format_size(active_session->bytes_in, kept);
+		format_size(active_session->bytes_out, resident);
+		sprintf(title, "Info - capture of %s received, %s sent", kept, resident);
+		set_info_title(title);
+		return;
+	}
+
+	in = active_session->in_history;
+	out = active_session->out_history;
+	kept_bytes = (in->end - in->start) + (out->end - out->start);
+	resident_bytes = in->resident + out->resident;
+	packed_raw = in->packed_raw + out->packed_raw;
+	packed_bytes = in->packed_bytes + out->packed_bytes;
+
+	format_size(kept_bytes, kept);
+	format_size(resident_bytes, resident);
+
+	if (packed_bytes > 0)
+	{
+		sprintf(title, "Info - history %s in %s resident, compressed %.1f:1",
+				kept, resident, (double)packed_raw / packed_bytes);
+	}
+	else
+	{
+		sprintf(title, "Info - history %s in %s resident", kept, resident);
+	}
+
+	if (active_session->queue.head != NULL)
+	{
+		format_size(active_session->queue.bytes, queued);
+		sprintf(title + strlen(title), ", send queue %s in %d buffers",
+				queued, active_session->queue.buffers);
+	}
+
+	set_info_title(title);
+}
+
+/*
+ * Shows the active session in the socket windows, titled with its
+ * number and state.
+ */
+void update_session_title()
+{
+	char title[128];
+	session *s = active_session;
+
+	if (s == NULL)
+	{
+		return;
+	}
+
+	sprintf(title, "session %d/%d %s%s", s->id, num_sessions, s->name,
+			s->open ? "" : " (closed)");
+	show_views(&s->in_view, &s->out_view, title);
+}
+
+/*
+ * Makes a session the active one: shows it in the socket windows and
+ * sends typed lines to it.
+ */
+void switch_session(session *s)
+{
+	char in[16], out[16], queued[16], peak[16], msg[512];
+
+	active_session = s;
+	update_session_title();
+	update_history_title();
+
+	format_size(s->bytes_in, in);
+	format_size(s->bytes_out, out);
+	format_size(s->queue.bytes, queued);
+	format_size(s->queue.peak_bytes, peak);
+	sprintf(msg, "Session %d/%d: %s, %s, %s received, %s sent, "
+				 "send queue %s (peak %s)\n",
+			s->id, num_sessions, s->name, s->open ? "open" : "closed",
+			in, out, queued, peak);
+	write_info_wnd(msg);
+}
+
 /*
  * Matches the bytes in escape_chars[] against the special (function) key
  * sequences.
@@ -208,13 +443,18 @@ int array_match(int len1, char *array1, int len2, char *array2)
  */
 int match_sequences()
 {
-	int newmode, i;
-	char token[16];
+	int newmode;
 
 	if (array_match(escape_chars_read, escape_chars, seq_f1_len, seq_f1))
 	{
+		if (active_session == NULL)
+		{
+			write_info_wnd("No connection yet\n");
+			return TRUE;
+		}
+
 		/* toggle socket input display formatting mode */
-		newmode = toggle_sock_in_format();
+		newmode = next_format_type(active_session->in_view.format);
 		switch (newmode)
 		{
 		case FORMATTER_WIDE:
@@ -228,30 +468,23 @@ int match_sequences()
 			break;
 		}
 
-		/* apply reformatting to sock_in window from buffer */
-		if (bytes_in_sock_in_buffer < SOCK_IN_BUFFER_SIZE)
-		{
-			clear_sock_in_wnd();
-
-			for (i = 0; i < bytes_in_sock_in_buffer; i++)
-			{
-				sock_in_format->formatter(sock_in_format->pattern,
-										  sock_in_buffer[i], token);
-				write_sock_in_wnd(token);
-			}
-		}
-		else
-		{
-			write_info_wnd("reformatting disabled.\n");
-		}
+		/* only the visible lines get reformatted */
+		active_session->in_view.format = &display_formats[newmode];
+		mark_dirty(DIRTY_SOCK_IN | DIRTY_FRAMES);
 
 		return TRUE;
 	}
 
 	if (array_match(escape_chars_read, escape_chars, seq_f2_len, seq_f2))
 	{
+		if (active_session == NULL)
+		{
+			write_info_wnd("No connection yet\n");
+			return TRUE;
+		}
+
 		/* toggle socket output display formatting mode */
-		newmode = toggle_sock_out_format();
+		newmode = next_format_type(active_session->out_view.format);
 		switch (newmode)
 		{
 		case FORMATTER_WIDE:
@@ -265,22 +498,9 @@ int match_sequences()
 			break;
 		}
 
-		/* apply reformatting to sock_out window from buffer */
-		if (bytes_in_sock_out_buffer < SOCK_OUT_BUFFER_SIZE)
-		{
-			clear_sock_out_wnd();
-
-			for (i = 0; i < bytes_in_sock_out_buffer; i++)
-			{
-				sock_out_format->formatter(sock_out_format->pattern,
-										   sock_out_buffer[i], token);
-				write_sock_out_wnd(token);
-			}
-		}
-		else
-		{
-			write_info_wnd("reformatting disabled.\n");
-		}
+		/* only the visible lines get reformatted */
+		active_session->out_view.format = &display_formats[newmode];
+		mark_dirty(DIRTY_SOCK_OUT | DIRTY_FRAMES);
 
 		return TRUE;
 	}
@@ -320,37 +540,125 @@ int match_sequences()
 
 		return TRUE;
 	}
+
+	if (array_match(escape_chars_read, escape_chars, seq_f5_len, seq_f5))
+	{
+		/* toggles the window scrolled by PgUp/PgDn */
+		switch (scroll_target)
+		{
+		case SCROLL_SOCK_IN:
+			scroll_target = SCROLL_SOCK_OUT;
+			write_info_wnd("PgUp/PgDn now scroll Bytes sent window\n");
+			break;
+		case SCROLL_SOCK_OUT:
+			scroll_target = SCROLL_SOCK_IN;
+			write_info_wnd("PgUp/PgDn now scroll Bytes received window\n");
+			break;
+		}
+
+		return TRUE;
+	}
+
+	if (array_match(escape_chars_read, escape_chars, seq_f6_len, seq_f6))
+	{
+		/* switches to the next session */
+		if (num_sessions == 0)
+		{
+			write_info_wnd("No connection yet\n");
+		}
+		else
+		{
+			switch_session(session_following(active_session));
+		}
+
+		return TRUE;
+	}
+
+	if (array_match(escape_chars_read, escape_chars, seq_pgup_len, seq_pgup))
+	{
+		scroll_window(-1);
+		return TRUE;
+	}
+
+	if (array_match(escape_chars_read, escape_chars, seq_pgdn_len, seq_pgdn))
+	{
+		scroll_window(1);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*
+ * Translates the line typed for a session into raw bytes for sending.
+ *
+ * return: number of bytes to send
+ */
+int translate_stdin_buffer(session *s, unsigned char *dest,
+						   file_escape *files, int *num_files)
+{
+	return translate_escapes(s->stdin_input_buffer, s->stdin_bytes_read, dest,
+							 files, num_files);
 }
 
 /*
- * Translates escaped sequences into raw bytes for sending.
+ * Translates escaped sequences of len bytes of input into raw bytes
+ * for sending. The files of \f{path} escapes are not read; they are
+ * listed in files[], with their positions within the bytes.
  *
  * return: number of bytes to send
  */
-int translate_stdin_buffer(unsigned char *dest)
+int translate_escapes(unsigned char *input, int len, unsigned char *dest,
+					  file_escape *files, int *num_files)
 {
-	int i, count;
+	int i, count, path_len;
 	unsigned char c;
 	int escape_mode, escape_seq_len;
 	char msg[512];
 	char hex[3], *end_ptr;
 	long hex_value;
 
+	*num_files = 0;
+
 	/* plain text mode: just copy the buffer */
 	if (stdin_input_interpretation_mode == STDIN_INTERP_PLAIN_TEXT)
 	{
-		memcpy(dest, stdin_input_buffer, stdin_bytes_read * sizeof(char));
-		return stdin_bytes_read;
+		memcpy(dest, input, len * sizeof(char));
+		return len;
 	}
 
 	/* escaped mode: parse the escape sequences */
 	if (stdin_input_interpretation_mode == STDIN_INTERP_ESCAPED)
 	{
 		escape_mode = ESCAPE_MODE_INACTIVE;
+		path_len = 0;
 
-		for (i = 0, count = 0; i < stdin_bytes_read; i++)
+		for (i = 0, count = 0; i < len; i++)
 		{
-			c = stdin_input_buffer[i];
+			c = input[i];
+
+			/* a file path is taken as it is, up to the closing brace */
+			if (escape_mode == ESCAPE_MODE_FILE_PATH)
+			{
+				if (c == '}')
+				{
+					files[*num_files].path[path_len] = '\0';
+					files[*num_files].at = count;
+					(*num_files)++;
+					escape_mode = ESCAPE_MODE_INACTIVE;
+				}
+				else if (path_len < STDIN_FILE_PATH_SIZE - 1)
+				{
+					files[*num_files].path[path_len++] = (char)c;
+				}
+				else
+				{
+					write_info_wnd("File path too long\n");
+					*num_files = 0;
+					return 0;
+				}
+				continue;
+			}
 
 			if (c == '\\')
 			{
@@ -366,11 +674,33 @@ int translate_stdin_buffer(unsigned char *dest)
 					case 'x':
 						escape_mode = ESCAPE_MODE_HEX_STARTED;
 						break;
+					case 'f':
+						if (*num_files == STDIN_MAX_FILES)
+						{
+							sprintf(msg, "At most %d files per line\n", STDIN_MAX_FILES);
+							write_info_wnd(msg);
+							*num_files = 0;
+							return 0;
+						}
+						escape_mode = ESCAPE_MODE_FILE_STARTED;
+						break;
 					default:
 						sprintf(msg, "Bad escape sequence \\%c\n", c);
 						write_info_wnd(msg);
+						*num_files = 0;
+						return 0;
+					}
+					break;
+				case ESCAPE_MODE_FILE_STARTED:
+					if (c != '{')
+					{
+						sprintf(msg, "Bad escape sequence \\f%c, expected \\f{path}\n", c);
+						write_info_wnd(msg);
+						*num_files = 0;
 						return 0;
 					}
+					escape_mode = ESCAPE_MODE_FILE_PATH;
+					path_len = 0;
 					break;
 				case ESCAPE_MODE_HEX_STARTED:
 					escape_mode = ESCAPE_MODE_HEX_1READ;
@@ -386,6 +716,7 @@ int translate_stdin_buffer(unsigned char *dest)
 					{
 						sprintf(msg, "Bad hex number %s\n", hex);
 						write_info_wnd(msg);
+						*num_files = 0;
 						return 0;
 					}
 
@@ -400,100 +731,430 @@ int translate_stdin_buffer(unsigned char *dest)
 			}
 		}
 
+		if ((escape_mode == ESCAPE_MODE_FILE_STARTED) ||
+			(escape_mode == ESCAPE_MODE_FILE_PATH))
+		{
+			write_info_wnd("Unterminated \\f{path} escape\n");
+			*num_files = 0;
+			return 0;
+		}
+
 		return count;
 	}
 }
 
 /*
- * Handles stdin input. Upon pressing ENTER, the stdin input buffer
- * is translated and sent to the remote host.
- *
- * Bytes originating from pressing special keys are not sent
- * but parsed out and processed separately.
+ * Stores bytes of a session for display. Every UDP datagram is kept
+ * as a record of its own, with its length and the time it was read
+ * or sent.
  */
-void handle_stdin_input(int input, int sockfd)
+void store_session_bytes(history *h, unsigned char *buf, int n)
 {
-	static unsigned char send_buf[STDIN_INPUT_BUFFER_SIZE];
-	ssize_t num_sent;
-	int num_translated;
-	char msg[512];
-	int i;
-	char token[16];
-	struct timeval tv;
-	struct timezone tz;
-	long timediff;
-	int x, y;
-
-	/* handle tab */
-	if (input == 9)
+	if (socket_type == SOCKTYPE_UDP)
 	{
-		// ##TODO show help screen
+		history_append_record(h, buf, n, capture_clock_ns(CLOCK_REALTIME));
+	}
+	else
+	{
+		history_append(h, buf, n);
+	}
+}
+
+/*
+ * Records bytes the send queue of a session wrote into its socket.
+ * The bytes of files are only counted and captured.
+ */
+void record_sent_bytes(unsigned char *buf, int n, int from_file, void *data)
+{
+	session *s = (session *)data;
 
+	s->bytes_out += n;
+	stats_count(&stats_out, n);
+
+	if (buf == NULL)
+	{
 		return;
 	}
 
-	/* handle backspace */
-	if (input == 127)
+	capture_write(CAPTURE_OUT, s->id, buf, n);
+
+	if (from_file)
 	{
-		if (stdin_bytes_read > 0)
-		{
-			getyx(info_wnd, y, x);
-			mvwdelch(info_wnd, y, x - 1);
-			wrefresh(info_wnd);
-			stdin_bytes_read--;
-		}
 		return;
 	}
 
-	/* handle escape character */
-	if (input == 27)
+	if (batch_mode)
 	{
-		escape_chars[0] = 27;
-		escape_chars_read = 1;
-		gettimeofday(&tv, &tz);
-		last_escape_char_sec = tv.tv_sec;
-		last_escape_char_usec = tv.tv_usec;
+		batch_write(DIRECTION_OUT, buf, n);
 		return;
 	}
 
-	if (escape_chars_read > 0)
+	/* store bytes for display; formatted when the window is drawn */
+	store_session_bytes(s->out_history, buf, n);
+	if (s == active_session)
 	{
-		/* active escape sequence exists. see if the current input
-		   byte is part of the sequence. This is done by a timeout of
-		   250ms. Avoid overflow in timediff by a 2s limit. */
-		gettimeofday(&tv, &tz);
+		mark_dirty(DIRTY_SOCK_OUT);
+	}
+}
 
-		if (((tv.tv_sec - last_escape_char_sec) < 2) &&
-			(tv.tv_sec >= last_escape_char_sec))
-		{
-			timediff = (tv.tv_sec - last_escape_char_sec) * 1000000 +
-					   (tv.tv_usec - last_escape_char_usec);
-			if (timediff < 250000)
-			{
-				/* the byte is part of the escape sequence */
-				// sprintf(msg, "tv_sec: %u tv_usec: %u chars: %d\n",
-				// tv.tv_sec, tv.tv_usec, escape_chars_read + 1);
-				// write_info_wnd(msg);
-				escape_chars[escape_chars_read++] = (char)input;
+/*
+ * Shows a summary of a file the send queue of a session has sent in
+ * the info window: size, throughput and checksum.
+ */
+void record_file_sent(send_file *f, void *data)
+{
+	session *s = (session *)data;
+	char summary[512], size[16], rate[24], crc[24];
+	long long usec;
+
+	usec = usec_since(&f->started);
+	format_size(f->sent, size);
+	format_rate(f->sent, usec, rate);
+	if (f->map != NULL)
+	{
+		sprintf(crc, ", crc32 %08x", f->crc);
+	}
+	else
+	{
+		crc[0] = '\0';
+	}
 
-				/* compare against the defined key sequences */
-				if (!match_sequences())
-				{
-					/* no match: keep recording the sequence */
-					last_escape_char_sec = tv.tv_sec;
-					last_escape_char_usec = tv.tv_usec;
-				}
+	snprintf(summary, sizeof(summary),
+			 "[session %d sent file %s: %lld bytes (%s) in %.3fs, %s%s]\n",
+			 s->id, f->name, f->sent, size, usec / 1000000.0, rate, crc);
 
-				return;
-			}
-		}
-	}
+	/* kept out of the sent bytes, whose offsets must match the socket;
+	   batch mode writes it to stderr */
+	write_info_wnd(summary);
+}
 
-	/* echo the character */
-	wechochar(info_wnd, input);
+/* the writer below drains the queue with flush_send_queue() */
+void handle_socket_writable(int, int, void *);
+
+/*
+ * Writes what the socket of a session takes from its send queue. The
+ * socket is watched for writability while anything is left; once the
+ * queue is empty, a pending shutdown is done and paused stdin is read
+ * again.
+ *
+ * Returns the number of bytes written, or -1 on error
+ */
+long long flush_send_queue(session *s)
+{
+	char msg[512], queued[16];
+	long long n;
+
+	n = send_queue_drain(&s->queue, s->sockfd, record_sent_bytes,
+						 record_file_sent, s);
+	if (n < 0)
+	{
+		stats_errors++;
+		format_size(s->queue.bytes, queued);
+		sprintf(msg, "Error writing to the connection (%s), %s of queued bytes dropped\n",
+				strerror(errno), queued);
+		write_info_wnd(msg);
+		send_queue_clear(&s->queue);
+	}
+
+	event_set_writer(s->sockfd, (s->queue.head != NULL) ? handle_socket_writable : NULL);
+
+	if (s->queue.head == NULL)
+	{
+		if (s->shutdown_pending)
+		{
+			shutdown(s->sockfd, SHUT_WR);
+			s->shutdown_pending = FALSE;
+		}
+
+		if (stdin_paused)
+		{
+			event_modify(STDIN_FILENO, EVENT_READ);
+			stdin_paused = FALSE;
+		}
+	}
+
+	if (!batch_mode && (s == active_session))
+	{
+		update_history_title();
+	}
+
+	return n;
+}
+
+/*
+ * Writer callback of a session socket with bytes in its send queue.
+ */
+void handle_socket_writable(int sockfd, int events, void *data)
+{
+	session *s = (session *)data;
+
+	if ((flush_send_queue(s) > 0) && (s->queue.head == NULL) && !batch_mode)
+	{
+		write_info_wnd("send queue drained\n");
+	}
+}
+
+/*
+ * Translates the stdin input buffer of a session and queues it for
+ * sending, with the files of its \f{path} escapes in their places.
+ *
+ * Returns the number of buffers queued, or -1 if the line was refused
+ */
+int queue_stdin_buffer(session *s)
+{
+	static unsigned char send_buf[STDIN_INPUT_BUFFER_SIZE];
+	static file_escape files[STDIN_MAX_FILES];
+	int num_translated, num_files, num_queued, start, len, i;
+	send_buffer *mark;
+	struct stat st;
+	char msg[512], queued[16];
+
+	if (!s->open)
+	{
+		write_info_wnd("Connection is closed\n");
+		s->stdin_bytes_read = 0;
+		return -1;
+	}
+
+	/* translate stdin input buffer to bytes for sending */
+	num_translated = translate_stdin_buffer(s, send_buf, files, &num_files);
+	s->stdin_bytes_read = 0;
+
+	if ((num_files > 0) && (socket_type != SOCKTYPE_TCP))
+	{
+		write_info_wnd("Files can only be sent over TCP\n");
+		return -1;
+	}
+
+	/* check the files first, so that a bad one sends nothing */
+	for (i = 0; i < num_files; i++)
+	{
+		if (stat(files[i].path, &st) == -1)
+		{
+			sprintf(msg, "Can't send %.256s (%s)\n", files[i].path, strerror(errno));
+			write_info_wnd(msg);
+			return -1;
+		}
+
+		if (!S_ISREG(st.st_mode))
+		{
+			sprintf(msg, "Can't send %.256s (not a regular file)\n", files[i].path);
+			write_info_wnd(msg);
+			return -1;
+		}
+	}
+
+	/* a failure halfway takes back what the line has queued */
+	mark = s->queue.tail;
+
+	for (i = 0, start = 0, num_queued = 0; i <= num_files; i++)
+	{
+		len = ((i < num_files) ? files[i].at : num_translated) - start;
+		if (len > 0)
+		{
+			if (send_queue_push(&s->queue, send_buf + start, len) == -1)
+			{
+				send_queue_rollback(&s->queue, mark);
+				format_size(s->queue.bytes, queued);
+				sprintf(msg, "Send queue full (%s waiting), line dropped\n", queued);
+				write_info_wnd(msg);
+				return -1;
+			}
+			num_queued++;
+		}
+		start += len;
+
+		if (i == num_files)
+		{
+			break;
+		}
+
+		if (send_queue_push_file(&s->queue, files[i].path) == -1)
+		{
+			sprintf(msg, "Can't send %.256s (%s), line dropped\n", files[i].path,
+					strerror(errno));
+			send_queue_rollback(&s->queue, mark);
+			write_info_wnd(msg);
+			return -1;
+		}
+		num_queued++;
+	}
+
+	return num_queued;
+}
+
+/*
+ * Translates the stdin input buffer of a session and sends it to the
+ * remote host. What the socket does not take right away is sent when
+ * it becomes writable.
+ */
+void send_stdin_buffer(session *s)
+{
+	char msg[512], queued[16];
+	long long num_sent;
+
+	if (queue_stdin_buffer(s) <= 0)
+	{
+		return;
+	}
+
+	/* time the response from the moment the line goes out */
+	probe_sent(s);
+	num_sent = flush_send_queue(s);
+	if ((num_sent < 0) || batch_mode)
+	{
+		return;
+	}
+
+	if (s->queue.head == NULL)
+	{
+		sprintf(msg, "wrote %lld bytes into the socket\n", num_sent);
+	}
+	else
+	{
+		format_size(s->queue.bytes, queued);
+		sprintf(msg, "wrote %lld bytes into the socket, %s waiting in the send queue\n",
+				num_sent, queued);
+	}
+	write_info_wnd(msg);
+}
+
+/*
+ * Handles stdin input in batch mode. Input is read in lines; each
+ * linefeed acts as the enter key. The lines are queued and sent
+ * together.
+ */
+void handle_batch_stdin_input(int num_read, unsigned char *buf, session *s)
+{
+	int i;
+
+	for (i = 0; i < num_read; i++)
+	{
+		if (buf[i] == '\n')
+		{
+			if (enter_behaviour_mode == ENTER_SENDS_CRLF)
+			{
+				s->stdin_input_buffer[s->stdin_bytes_read++] = 10;
+				s->stdin_input_buffer[s->stdin_bytes_read++] = 13;
+			}
+			queue_stdin_buffer(s);
+			continue;
+		}
+
+		/* send overlong lines in pieces, leaving room for cr lf */
+		if (s->stdin_bytes_read > (STDIN_INPUT_BUFFER_SIZE - 3))
+		{
+			queue_stdin_buffer(s);
+		}
+
+		s->stdin_input_buffer[s->stdin_bytes_read++] = buf[i];
+	}
+
+	flush_send_queue(s);
+
+	/* leave the rest of stdin unread until the peer catches up */
+	if (s->queue.bytes > SEND_QUEUE_HIGH_WATER)
+	{
+		event_modify(STDIN_FILENO, 0);
+		stdin_paused = TRUE;
+	}
+}
+
+/*
+ * Handles stdin input. Upon pressing ENTER, the stdin input buffer
+ * is translated and sent to the remote host.
+ *
+ * Bytes originating from pressing special keys are not sent
+ * but parsed out and processed separately.
+ */
+void handle_stdin_input(int input, session *s)
+{
+	struct timeval tv;
+	struct timezone tz;
+	long timediff;
+	int x, y;
+
+	/* handle tab */
+	if (input == 9)
+	{
+		// ##TODO show help screen
+
+		return;
+	}
+
+	/* handle backspace */
+	if (input == 127)
+	{
+		if ((s != NULL) && (s->stdin_bytes_read > 0))
+		{
+			getyx(info_wnd, y, x);
+			mvwdelch(info_wnd, y, x - 1);
+			mark_dirty(DIRTY_INFO);
+			s->stdin_bytes_read--;
+		}
+		return;
+	}
+
+	/* handle escape character */
+	if (input == 27)
+	{
+		escape_chars[0] = 27;
+		escape_chars_read = 1;
+		gettimeofday(&tv, &tz);
+		last_escape_char_sec = tv.tv_sec;
+		last_escape_char_usec = tv.tv_usec;
+		return;
+	}
+
+	if (escape_chars_read > 0)
+	{
+		/* active escape sequence exists. see if the current input
+		   byte is part of the sequence. This is done by a timeout of
+		   250ms. Avoid overflow in timediff by a 2s limit. */
+		gettimeofday(&tv, &tz);
+
+		if (((tv.tv_sec - last_escape_char_sec) < 2) &&
+			(tv.tv_sec >= last_escape_char_sec))
+		{
+			timediff = (tv.tv_sec - last_escape_char_sec) * 1000000 +
+					   (tv.tv_usec - last_escape_char_usec);
+			if (timediff < 250000)
+			{
+				/* the byte is part of the escape sequence */
+				// sprintf(msg, "tv_sec: %u tv_usec: %u chars: %d\n",
+				// tv.tv_sec, tv.tv_usec, escape_chars_read + 1);
+				// write_info_wnd(msg);
+				escape_chars[escape_chars_read++] = (char)input;
+
+				/* compare against the defined key sequences */
+				if (!match_sequences())
+				{
+					/* no match: keep recording the sequence */
+					last_escape_char_sec = tv.tv_sec;
+					last_escape_char_usec = tv.tv_usec;
+				}
+
+				return;
+			}
+		}
+	}
+
+	/* nothing to type into before the first connection */
+	if (s == NULL)
+	{
+		if (input == 13)
+		{
+			write_info_wnd("No connection yet\n");
+		}
+		return;
+	}
+
+	/* echo the character */
+	waddch(info_wnd, input);
+	mark_dirty(DIRTY_INFO);
 
 	/* look for buffer overflow, being prepared for possible cr lf */
-	if (stdin_bytes_read > (STDIN_INPUT_BUFFER_SIZE - 2))
+	if (s->stdin_bytes_read > (STDIN_INPUT_BUFFER_SIZE - 2))
 	{
 		deinit_curses();
 		printf("avoiding stdin input buffer overflow\n");
@@ -503,193 +1164,545 @@ void handle_stdin_input(int input, int sockfd)
 	//    sprintf(msg, "read: %d\n", input);
 	//    write_info_wnd(msg);
 
-	if (input == 13)
+	if ((input == 13) && view_mode)
+	{
+		/* a capture is being browsed: the line is a command */
+		s->stdin_input_buffer[s->stdin_bytes_read] = 0;
+		view_command(&s->in_view, &s->out_view, (char *)s->stdin_input_buffer,
+					 scroll_target == SCROLL_SOCK_IN);
+		s->stdin_bytes_read = 0;
+		return;
+	}
+
+	if (input == 13)
+	{
+		/* check if we should send cr/lf or both on enter */
+		if (enter_behaviour_mode == ENTER_SENDS_CRLF)
+		{
+			s->stdin_input_buffer[s->stdin_bytes_read++] = 10;
+			s->stdin_input_buffer[s->stdin_bytes_read++] = 13;
+		}
+
+		send_stdin_buffer(s);
+	}
+	else
+	{
+		s->stdin_input_buffer[s->stdin_bytes_read++] = (unsigned char)input;
+	}
+}
+
+/*
+ * Manages socket input of a session.
+ */
+void handle_socket_input(session *s, int num_read, unsigned char *buf)
+{
+	if (num_read <= 0)
+	{
+		return;
+	}
+
+	s->bytes_in += num_read;
+	stats_count(&stats_in, num_read);
+	renew_quickack(s->sockfd);
+
+	capture_write(CAPTURE_IN, s->id, buf, num_read);
+
+	if (batch_mode)
+	{
+		batch_write(DIRECTION_IN, buf, num_read);
+		return;
+	}
+
+	probe_received(s, num_read);
+
+	/* store bytes for display; formatted when the window is drawn */
+	store_session_bytes(s->in_history, buf, num_read);
+
+	if (s == active_session)
+	{
+		mark_dirty(DIRTY_SOCK_IN);
+
+		if (s->in_history->end % HISTORY_CHUNK_SIZE < num_read)
+		{
+			update_history_title();
+		}
+	}
+}
+
+/*
+ * Draws a frame if one is due; otherwise arms the frame timer to wake
+ * the event loop in time for the next one. Called before each wait.
+ */
+void schedule_frame()
+{
+	long delay;
+
+	render_frame();
+
+	delay = render_delay_usec();
+	if ((delay > 0) && !frame_timer_armed)
+	{
+		event_set_timer(frame_timer, delay);
+		frame_timer_armed = TRUE;
+	}
+}
+
+/*
+ * Frame timer callback; the frame itself is drawn by schedule_frame().
+ */
+void frame_timer_expired(int fd, int events, void *data)
+{
+	frame_timer_armed = FALSE;
+}
+
+/*
+ * Returns TRUE while there is work to do when no input is waiting:
+ * batch output to write, a capture window to prepare, or cold history
+ * to compress.
+ */
+int idle_work_pending()
+{
+	int i;
+
+	if (capture_prepare_pending())
+	{
+		return TRUE;
+	}
+
+	if (batch_mode)
+	{
+		return batch_pending();
+	}
+
+	for (i = 0; i < num_sessions; i++)
+	{
+		if (history_compress_pending(sessions[i]->in_history) ||
+			history_compress_pending(sessions[i]->out_history))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/*
+ * Does a step of the idle work.
+ */
+void do_idle_work()
+{
+	int i;
+
+	capture_prepare_step();
+
+	if (batch_mode)
+	{
+		batch_flush();
+		return;
+	}
+
+	for (i = 0; i < num_sessions; i++)
+	{
+		history_compress_step(sessions[i]->in_history);
+		history_compress_step(sessions[i]->out_history);
+	}
+	update_history_title();
+}
+
+/*
+ * Signal callback of the event loop.
+ */
+void handle_signal(int sig, int events, void *data)
+{
+	if (sig == SIGWINCH)
+	{
+		resize_curses();
+	}
+	else
+	{
+		finish(sig);
+	}
+}
+
+/*
+ * Reader of stdin; writes the input to the active session.
+ */
+void handle_stdin_data(int fd, unsigned char *buf, int n, void *data)
+{
+	session *s = active_session;
+	char msg[512];
+	int i;
+
+	if (n < 0)
+	{
+		sprintf(msg, "Error reading stdin (%s)\n", strerror(errno));
+		write_info_wnd(msg);
+
+		if (s != NULL)
+		{
+			shutdown(s->sockfd, SHUT_WR);
+		}
+		finish(-1);
+	}
+
+	if ((server_mode != SERVER_MODE_NONE) || load_mode || throughput_mode)
+	{
+		/* a server, load generator or throughput test takes no
+		   input; without a terminal it runs until it gets a signal */
+		if ((n == 0) && batch_mode)
+		{
+			event_remove(STDIN_FILENO);
+		}
+		else if (n == 0)
+		{
+			finish(0);
+		}
+		return;
+	}
+
+	if ((n == 0) && batch_mode)
+	{
+		/* end of input: send what is left and keep reading
+		   the socket until the remote host closes it */
+		event_remove(STDIN_FILENO);
+		stdin_paused = FALSE;
+
+		if (s->stdin_bytes_read > 0)
+		{
+			queue_stdin_buffer(s);
+		}
+		if (socket_type == SOCKTYPE_TCP)
+		{
+			s->shutdown_pending = TRUE;
+		}
+		flush_send_queue(s);
+		return;
+	}
+
+	if (n == 0)
+	{
+		/* read EOF from stdin */
+		finish(0);
+	}
+
+	if (batch_mode)
+	{
+		handle_batch_stdin_input(n, buf, s);
+	}
+	else
+	{
+		for (i = 0; i < n; i++)
+		{
+			handle_stdin_input(buf[i], s);
+		}
+	}
+}
+
+/*
+ * Records the endpoints of a session in the capture log, and whether
+ * it was accepted or connected.
+ */
+void record_session_opened(session *s)
+{
+	int flags = 0;
+
+	if (socket_type == SOCKTYPE_UDP)
+	{
+		flags |= CAPTURE_FLAG_UDP;
+	}
+	if (cmdline_params.switches & SWITCH_LISTEN_MASK)
+	{
+		flags |= CAPTURE_FLAG_ACCEPTED;
+	}
+
+	capture_session(s->id, s->sockfd, flags, s->name);
+}
+
+/*
+ * Reader of a session socket; hands the bytes over for display.
+ */
+void handle_socket_data(int sockfd, unsigned char *buf, int n, void *data)
+{
+	session *s = (session *)data;
+	char msg[512], in[16], out[16];
+
+	if (n < 0)
+	{
+		stats_errors++;
+		sprintf(msg, "Error reading socket of session %d (%s): %s\n",
+				s->id, s->name, strerror(errno));
+
+		/* other clients of a server keep going */
+		if (batch_mode || (num_sessions == 1))
+		{
+			write_info_wnd(msg);
+			shutdown(sockfd, SHUT_WR);
+			finish(-1);
+		}
+
+		event_remove(sockfd);
+		session_close(s);
+		probe_closed(s);
+
+		write_info_wnd(msg);
+		update_session_title();
+		return;
+	}
+
+	if ((n == 0) && (socket_type == SOCKTYPE_TCP))
 	{
-		/* check if we should send cr/lf or both on enter */
-		if (enter_behaviour_mode == ENTER_SENDS_CRLF)
+		/* connection closed by the remote host */
+		if (batch_mode)
 		{
-			stdin_input_buffer[stdin_bytes_read++] = 10;
-			stdin_input_buffer[stdin_bytes_read++] = 13;
+			finish(0);
 		}
 
-		/* translate stdin input buffer to bytes for sending */
-		num_translated = translate_stdin_buffer(send_buf);
+		event_remove(sockfd);
+		session_close(s);
+		probe_closed(s);
 
-		if (num_translated == 0)
-		{
-			stdin_bytes_read = 0;
-			return;
-		}
+		format_size(s->bytes_in, in);
+		format_size(s->bytes_out, out);
+		sprintf(msg, "Session %d (%s) closed by the remote host, "
+					 "%s received, %s sent\n", s->id, s->name, in, out);
+		write_info_wnd(msg);
+		update_session_title();
+		return;
+	}
 
-		/* send the buffer */
-		num_sent = write(sockfd, send_buf, num_translated);
+	handle_socket_input(s, n, buf);
+}
 
-		if (num_sent < 0)
-		{
-			sprintf(msg, "Error writing to the connection (%s)\n", strerror(errno));
-			write_info_wnd(msg);
+/*
+ * Handles the first datagram arriving at a UDP server socket: the
+ * socket is connected to its sender and read normally from then on.
+ */
+void handle_udp_peer(int sockfd, int events, void *data)
+{
+	static unsigned char read_buf[READ_BUFFER_SIZE];
+	session *s = (session *)data;
+	int n;
 
-			stdin_bytes_read = 0;
-			return;
-		}
+	n = accept_udp_peer(sockfd, read_buf, READ_BUFFER_SIZE);
+	if ((n < 0) && (errno == EWOULDBLOCK))
+	{
+		return;
+	}
 
-		/* display bytes written into the socket */
-		for (i = 0; i < num_sent; i++)
-		{
-			sock_out_format->formatter(sock_out_format->pattern,
-									   send_buf[i], token);
-			write_sock_out_wnd(token);
+	s->udp_peer_known = TRUE;
+	get_peer_name(sockfd, s->name, SESSION_NAME_SIZE);
+	record_session_opened(s);
+	update_session_title();
 
-			/* store byte for later reformatting */
-			if (bytes_in_sock_out_buffer < SOCK_OUT_BUFFER_SIZE)
-			{
-				sock_out_buffer[bytes_in_sock_out_buffer++] = send_buf[i];
-				if (bytes_in_sock_out_buffer == SOCK_OUT_BUFFER_SIZE)
-				{
-					write_info_wnd("sock_out_buffer full, disabling reformatting\n");
-				}
-			}
-		}
+	event_remove(sockfd);
+	if (event_add_datagram_reader(sockfd, handle_socket_data, s) == -1)
+	{
+		finish(-1);
+	}
 
-		sprintf(msg, "wrote %d bytes into the socket\n", num_sent);
-		write_info_wnd(msg);
-		stdin_bytes_read = 0;
+	handle_socket_data(sockfd, read_buf, n, s);
+}
+
+/*
+ * Starts reading the socket of a session.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int add_session_socket(session *s)
+{
+	/* a UDP server learns its peer from the first datagram */
+	if ((socket_type == SOCKTYPE_UDP) &&
+		(cmdline_params.switches & SWITCH_LISTEN_MASK) &&
+		(!s->udp_peer_known))
+	{
+		return event_add(s->sockfd, EVENT_READ, handle_udp_peer, s);
 	}
-	else
+
+	if (socket_type == SOCKTYPE_UDP)
 	{
-		stdin_input_buffer[stdin_bytes_read++] = (unsigned char)input;
+		return event_add_datagram_reader(s->sockfd, handle_socket_data, s);
 	}
+
+	return event_add_reader(s->sockfd, handle_socket_data, s);
 }
 
 /*
- * Manages socket input.
+ * Creates and registers a session for a connected socket. On error the
+ * socket is closed.
+ *
+ * Returns the session, or NULL on error
  */
-void handle_socket_input(int num_read, unsigned char *buf)
+session *open_session(int sockfd)
 {
-	int i;
-	char token[16];
+	session *s;
 
-	for (i = 0; i < num_read; i++)
+	if ((s = session_create(sockfd, cmdline_params.history_size,
+							cmdline_params.switches & SWITCH_CORK_MASK)) == NULL)
 	{
-		sock_in_format->formatter(sock_in_format->pattern,
-								  buf[i], token);
-		write_sock_in_wnd(token);
+		close(sockfd);
+		return NULL;
+	}
 
-		/* store byte for later reformatting */
-		if (bytes_in_sock_in_buffer < SOCK_IN_BUFFER_SIZE)
-		{
-			sock_in_buffer[bytes_in_sock_in_buffer++] = buf[i];
-			if (bytes_in_sock_in_buffer == SOCK_IN_BUFFER_SIZE)
-			{
-				write_info_wnd("sock_in_buffer full, disabling reformatting\n");
-			}
-		}
+	if (session_register(s) == -1)
+	{
+		session_destroy(s);
+		return NULL;
 	}
+	record_session_opened(s);
+
+	return s;
 }
 
 /*
- * Reads given socket and prints output on stdout. Also read stdin and write
- * the input to the socket.
+ * Accepts the connections waiting on the server socket, each into a
+ * session of its own. The first one is shown right away; the others
+ * are reached with F6.
  */
-void handle_connection(int sockfd)
+void handle_incoming_connections(int fd, int events, void *data)
 {
-	static unsigned char read_buf[READ_BUFFER_SIZE];
-	int keep_reading = 1;
-	int maxfd = 0;
-	fd_set rset;
-	ssize_t n;
+	session *s;
+	int sockfd;
 	char msg[512];
-	int i;
-
-	maxfd = (sockfd > STDIN_FILENO) ? sockfd : STDIN_FILENO;
 
-	while (keep_reading)
+	while ((sockfd = accept_pending_connection(fd)) != -1)
 	{
-		FD_ZERO(&rset);
-		FD_SET(STDIN_FILENO, &rset);
-		FD_SET(sockfd, &rset);
+		if (set_nonblocking(sockfd) == -1)
+		{
+			close(sockfd);
+			continue;
+		}
 
-		select(maxfd + 1, &rset, NULL, NULL, NULL);
+		if ((s = open_session(sockfd)) == NULL)
+		{
+			write_info_wnd("out of memory for a new session\n");
+			continue;
+		}
 
-		if (FD_ISSET(STDIN_FILENO, &rset))
+		if (add_session_socket(s) == -1)
 		{
-			n = read(STDIN_FILENO, read_buf, READ_BUFFER_SIZE);
-			if ((n < 0) && (errno != EWOULDBLOCK))
-			{
-				sprintf(msg, "Error reading stdin (%s)\n", strerror(errno));
-				write_info_wnd(msg);
+			session_close(s);
+			continue;
+		}
 
-				shutdown(sockfd, SHUT_WR);
-				finish(-1);
-			}
+		sprintf(msg, "Got connection from %s (session %d)\n", s->name, s->id);
+		write_info_wnd(msg);
 
-			if (n == 0)
-			{
-				/* read EOF from stdin */
-				finish(0);
-			}
+		if (active_session == NULL)
+		{
+			switch_session(s);
+		}
+		else
+		{
+			update_session_title();
+		}
+	}
+}
 
-			for (i = 0; i < n; i++)
-			{
-				handle_stdin_input(read_buf[i], sockfd);
-			}
+/*
+ * Reads the sockets and shows their output. Also read stdin and write
+ * the input to the active session. Runs the event loop until the
+ * program exits.
+ */
+void handle_connection()
+{
+	int i;
+
+	if (event_loop_init(cmdline_params.io_backend) == -1)
+	{
+		finish(-1);
+	}
+
+	for (i = 0; i < num_sessions; i++)
+	{
+		if (sessions[i]->open && (add_session_socket(sessions[i]) == -1))
+		{
+			finish(-1);
 		}
+	}
 
-		if (FD_ISSET(sockfd, &rset))
+	if (cmdline_params.server_mode != SERVER_MODE_NONE)
+	{
+		if (server_mode_start(cmdline_params.server_mode, server_sockfd) == -1)
 		{
-			/*
-			   if first time to read with listen mode/UDP, need to use recvfrom() and
-			   then connect()
-			*/
-			if ((socket_type == SOCKTYPE_UDP) &&
-				(cmdline_params.switches & SWITCH_LISTEN_MASK) &&
-				(!udp_remote_addr_given))
-			{
-				udp_remote_addr_len = sizeof(udp_remote_addr);
-				udp_remote_addr_given = TRUE;
-				n = recvfrom(sockfd, read_buf, READ_BUFFER_SIZE, 0,
-							 (struct sockaddr *)&udp_remote_addr, &udp_remote_addr_len);
+			finish(-1);
+		}
+	}
+	else if (load_mode)
+	{
+		if (load_start() == -1)
+		{
+			finish(-1);
+		}
+	}
+	else if (throughput_mode)
+	{
+		if (throughput_start() == -1)
+		{
+			finish(-1);
+		}
+	}
+	else if ((server_sockfd != -1) &&
+			 (event_add(server_sockfd, EVENT_READ, handle_incoming_connections, NULL) == -1))
+	{
+		finish(-1);
+	}
 
-				if (n < 0)
-				{
-					sprintf(msg, "recvfrom() failed (%s)\n", strerror(errno));
-					write_info_wnd(msg);
-				}
-				else
-				{
-					if (connect(sockfd, (struct sockaddr *)&udp_remote_addr, udp_remote_addr_len))
-					{
-						sprintf(msg, "UDP: Error connecting to %s (%s)\n",
-								inet_ntoa(udp_remote_addr.sin_addr), strerror(errno));
-						write_info_wnd(msg);
-					}
-					else
-					{
-						sprintf(msg, "Using %s:%d for udp remote host:port\n",
-								inet_ntoa(udp_remote_addr.sin_addr),
-								ntohs(udp_remote_addr.sin_port), udp_remote_addr_len);
-						write_info_wnd(msg);
-					}
-				}
-			}
-			else
-			{
-				/* otherwise, use normal read() */
-				n = read(sockfd, read_buf, READ_BUFFER_SIZE);
-			}
+	if ((event_add_reader(STDIN_FILENO, handle_stdin_data, NULL) == -1) ||
+		(event_add_signal(SIGINT, handle_signal, NULL) == -1) ||
+		(event_add_signal(SIGHUP, handle_signal, NULL) == -1) ||
+		(event_add_signal(SIGTERM, handle_signal, NULL) == -1))
+	{
+		finish(-1);
+	}
 
-			if ((n < 0) && (errno != EWOULDBLOCK))
-			{
-				sprintf(msg, "Error reading socket (%s)\n", strerror(errno));
-				write_info_wnd(msg);
+	if (!batch_mode)
+	{
+		if ((event_add_signal(SIGWINCH, handle_signal, NULL) == -1) ||
+			((frame_timer = event_add_timer(frame_timer_expired, NULL)) == -1) ||
+			(probe_init() == -1) ||
+			(!view_mode && ((stats_start() == -1) || (tcpinfo_start() == -1))))
+		{
+			finish(-1);
+		}
 
-				shutdown(sockfd, SHUT_WR);
-				finish(-1);
-			}
+		/* draw at most one frame per loop iteration; if the frame rate
+		   cap postpones it, the timer wakes the loop for it */
+		event_set_prepare(schedule_frame);
+	}
 
-			handle_socket_input(n, read_buf);
-		}
+	if (metrics_start() == -1)
+	{
+		finish(-1);
+	}
+
+	/* with history left to compress or batch output to write, only
+	   poll for input */
+	event_set_idle(idle_work_pending, do_idle_work);
+
+	event_loop_run();
+}
+
+/*
+ * Replays a recorded session over the connection and exits with 0 if
+ * the response matched the recording, 1 if not.
+ */
+void handle_replay(int sockfd)
+{
+	if ((event_loop_init(cmdline_params.io_backend) == -1) ||
+		(replay_start(sockfd, cmdline_params.replay_speed) == -1) ||
+		(event_add_signal(SIGINT, handle_signal, NULL) == -1) ||
+		(event_add_signal(SIGHUP, handle_signal, NULL) == -1) ||
+		(event_add_signal(SIGTERM, handle_signal, NULL) == -1) ||
+		(metrics_start() == -1))
+	{
+		finish(-1);
 	}
+
+	event_set_idle(idle_work_pending, do_idle_work);
+	event_loop_run();
+
+	exit_code = replay_finish();
+	finish(0);
 }
 
 /*
@@ -698,29 +1711,180 @@ void handle_connection(int sockfd)
  */
 int main(int argc, char *argv[])
 {
-	int sockfd, server_sockfd;
-	char msg[512];
+	int sockfd, listen_sockfd;
+	load_params load;
+	session *s;
 
 	init();
 	parse_commandline_args(argc, argv);
 	init_formatters();
-	init_curses();
+
+	/* a server mode, load generator or throughput test without a
+	   terminal runs headless */
+	if (((cmdline_params.server_mode != SERVER_MODE_NONE) ||
+		 (cmdline_params.load_connections > 0) || cmdline_params.throughput) &&
+		!isatty(STDOUT_FILENO))
+	{
+		cmdline_params.switches |= SWITCH_BATCH_MASK;
+	}
+
+	if (cmdline_params.convert_file != NULL)
+	{
+		if (pcapng_convert(cmdline_params.convert_file, cmdline_params.pcapng_file) == -1)
+		{
+			finish(-1);
+		}
+		finish(0);
+	}
+
+	if (cmdline_params.diff_files[0] != NULL)
+	{
+		exit_code = capdiff_run(cmdline_params.diff_files[0], cmdline_params.diff_files[1],
+								cmdline_params.replay_session);
+		if (exit_code == -1)
+		{
+			finish(-1);
+		}
+		finish(0);
+	}
+
+	if ((cmdline_params.view_file != NULL) && !isatty(STDOUT_FILENO))
+	{
+		printf("-view needs a terminal\n");
+		finish(-1);
+	}
+
+	if ((cmdline_params.view_file != NULL) &&
+		(view_open(cmdline_params.view_file) == -1))
+	{
+		finish(-1);
+	}
+
+	if ((cmdline_params.record_file != NULL) &&
+		(capture_open(cmdline_params.record_file) == -1))
+	{
+		finish(-1);
+	}
+
+	if ((cmdline_params.pcapng_file != NULL) &&
+		(pcapng_open(cmdline_params.pcapng_file, capture_clock_ns(CLOCK_REALTIME),
+					 capture_clock_ns(CLOCK_MONOTONIC)) == -1))
+	{
+		finish(-1);
+	}
+
+	if ((cmdline_params.replay_file != NULL) &&
+		(replay_open(cmdline_params.replay_file, cmdline_params.replay_session) == -1))
+	{
+		finish(-1);
+	}
+
+	if ((cmdline_params.metrics_name != NULL) &&
+		(metrics_open(cmdline_params.metrics_name) == -1))
+	{
+		finish(-1);
+	}
+
+	if (cmdline_params.load_connections > 0)
+	{
+		load.connections = cmdline_params.load_connections;
+		load.request = cmdline_params.load_request;
+		load.delimiter = cmdline_params.load_delimiter;
+		load.length = cmdline_params.load_length;
+		load.max_requests = cmdline_params.load_requests;
+		load.duration = cmdline_params.duration;
+
+		/* a request on the command line can only carry line breaks
+		   and binary bytes as escapes */
+		stdin_input_interpretation_mode = STDIN_INTERP_ESCAPED;
+		socket_type = cmdline_params.socket_type;
+		if (load_open(cmdline_params.remote_host, cmdline_params.remote_port, &load) == -1)
+		{
+			finish(-1);
+		}
+	}
+
+	if (cmdline_params.switches & SWITCH_BATCH_MASK)
+	{
+		if (batch_open(cmdline_params.output_file) == -1)
+		{
+			finish(-1);
+		}
+	}
+	else if (!detect_pipe_mode())
+	{
+		read_escape_sequences();
+		init_curses();
+		set_frame_rate(cmdline_params.frame_rate);
+	}
 
 	enter_behaviour_mode = cmdline_params.enter_behaviour_mode;
 	stdin_input_interpretation_mode = cmdline_params.stdin_interp_mode;
 	socket_type = cmdline_params.socket_type;
+	socket_sndbuf = cmdline_params.sndbuf;
+	socket_rcvbuf = cmdline_params.rcvbuf;
+	socket_nodelay = cmdline_params.nodelay;
+	socket_quickack = cmdline_params.quickack;
+	socket_notsent_lowat = cmdline_params.notsent_lowat;
+	socket_keepalive = cmdline_params.keepalive;
+	socket_keepidle = cmdline_params.keepalive_params[0];
+	socket_keepintvl = cmdline_params.keepalive_params[1];
+	socket_keepcnt = cmdline_params.keepalive_params[2];
+	sockfd = -1;
+
+	if (load_mode)
+	{
+		/* the load generator opens connections of its own */
+		handle_connection();
+		finish(0);
+	}
+
+	if (view_mode)
+	{
+		/* browse the recorded sessions; there is nothing to connect */
+		active_session = sessions[0];
+		update_session_title();
+		update_history_title();
+		mark_dirty(DIRTY_ALL);
+
+		write_info_wnd("Viewing a capture: F1/F2 change formatting, F5 selects the window\n"
+					   "PgUp/PgDn scroll, F6 switches sessions. Type t SECONDS or\n"
+					   "o OFFSET and Enter to jump.\n");
+		handle_connection();
+		finish(0);
+	}
 
 	if (cmdline_params.switches & SWITCH_LISTEN_MASK)
 	{
 		/* acquire socket descriptor by listening incoming connections */
-		if ((server_sockfd = create_server_socket(cmdline_params.listen_port)) == -1)
+		if ((listen_sockfd = create_server_socket(cmdline_params.listen_port)) == -1)
 		{
 			finish(-1);
 		}
 
-		if (socket_type == SOCKTYPE_TCP)
+		if (cmdline_params.server_mode != SERVER_MODE_NONE)
+		{
+			/* the server mode serves the socket itself */
+			if (set_nonblocking(listen_sockfd) == -1)
+			{
+				finish(-1);
+			}
+			server_sockfd = listen_sockfd;
+		}
+		else if (socket_type == SOCKTYPE_TCP)
 		{
-			if ((sockfd = accept_incoming_connection(server_sockfd)) == -1)
+			if (!batch_mode && !pipe_mode && !cmdline_params.throughput)
+			{
+				/* interactive: keep accepting connections, each
+				   into a session of its own */
+				if (set_nonblocking(listen_sockfd) == -1)
+				{
+					finish(-1);
+				}
+				server_sockfd = listen_sockfd;
+				write_info_wnd("Waiting for connections; F6 switches between them\n");
+			}
+			else if ((sockfd = accept_incoming_connection(listen_sockfd)) == -1)
 			{
 				finish(-1);
 			}
@@ -728,7 +1892,7 @@ int main(int argc, char *argv[])
 		else
 		{
 			/* UDP */
-			sockfd = server_sockfd;
+			sockfd = listen_sockfd;
 		}
 	}
 	else
@@ -746,13 +1910,63 @@ int main(int argc, char *argv[])
 		finish(-1);
 	}
 
-	if (set_nonblocking(sockfd))
+	if ((sockfd != -1) && set_nonblocking(sockfd))
 	{
 		finish(-1);
 	}
 
-	write_info_wnd("For help, run pint with no arguments.\n");
-	handle_connection(sockfd);
+	if (pipe_mode)
+	{
+		if (set_nonblocking(STDOUT_FILENO) == -1)
+		{
+			finish(-1);
+		}
+
+		if (handle_pipe_connection(sockfd, (socket_type == SOCKTYPE_UDP) &&
+								   (cmdline_params.switches & SWITCH_LISTEN_MASK)) == -1)
+		{
+			finish(-1);
+		}
+		finish(0);
+	}
+
+	if (replay_mode)
+	{
+		handle_replay(sockfd);
+	}
+
+	if (cmdline_params.throughput)
+	{
+		/* the bytes are counted, not kept in a session */
+		throughput_open(sockfd, !(cmdline_params.switches & SWITCH_LISTEN_MASK),
+						cmdline_params.duration);
+		handle_connection();
+		finish(0);
+	}
+
+	if (sockfd != -1)
+	{
+		if ((s = open_session(sockfd)) == NULL)
+		{
+			deinit_curses();
+			printf("out of memory for history\n");
+			finish(-1);
+		}
+
+		active_session = s;
+		if (!batch_mode)
+		{
+			update_session_title();
+			update_history_title();
+		}
+	}
+	mark_dirty(DIRTY_ALL);
+
+	if (!batch_mode)
+	{
+		write_info_wnd("For help, run pint with no arguments.\n");
+	}
+	handle_connection();
 
 	finish(0);
 }
@@ -773,6 +1987,9 @@ const char *get_signal_name(int sig)
 	case SIGKILL:
 		return "SIGKILL";
 		break;
+	case SIGTERM:
+		return "SIGTERM";
+		break;
 	case SIGWINCH:
 		return "SIGWINCH";
 		break;
@@ -782,14 +1999,6 @@ const char *get_signal_name(int sig)
 	}
 }
 
-/*
- * SIGWINCH handler.
- */
-void resize(int sig)
-{
-	resize_curses();
-}
-
 /*
  * SIGHUP/SIGKILL handler.
  */
@@ -798,9 +2007,19 @@ void finish(int sig)
 	deinit();
 	deinit_curses();
 
+	/* the final reports outlive the windows */
+	if (load_print_report() == 1)
+	{
+		exit_code = 1;
+	}
+	if (throughput_print_report() == 1)
+	{
+		exit_code = 1;
+	}
+
 	if (sig == 0)
 	{
-		exit(0);
+		exit(exit_code);
 	}
 	else if (sig < 0)
 	{
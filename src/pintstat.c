@@ -0,0 +1,427 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * pint-stat: prints the counters a pint started with -metrics
+ * publishes, as text or in the Prometheus text exposition format.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../include/metrics.h"
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+/* how many times a copy is attempted while pint keeps updating */
+#define READ_ATTEMPTS 1000
+
+/*
+ * Shows how to run pint-stat.
+ */
+void show_usage()
+{
+    printf("Usage: pint-stat [-prom] NAME\n\n");
+    printf("Prints the counters published by pint -metrics NAME, read from\n");
+    printf("%sNAME (or NAME, if it has a directory).\n\n", METRICS_DIR);
+    printf("\t-prom\t\tprint them in the Prometheus text format, eg. for\n");
+    printf("\t\t\tthe textfile collector of the node exporter\n");
+}
+
+/*
+ * Maps the segment at path and copies it once pint is not in the
+ * middle of updating it.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int read_segment(char *path, metrics_segment *copy)
+{
+    metrics_segment *seg;
+    struct stat st;
+    uint64_t seq;
+    int fd, i, done;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        fprintf(stderr, "Couldn't open %s (%s)\n", path, strerror(errno));
+        return -1;
+    }
+
+    if ((fstat(fd, &st) == -1) || (st.st_size < sizeof(metrics_segment)))
+    {
+        fprintf(stderr, "%s is not a pint metrics segment\n", path);
+        close(fd);
+        return -1;
+    }
+
+    seg = mmap(NULL, sizeof(metrics_segment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED)
+    {
+        fprintf(stderr, "Couldn't map %s (%s)\n", path, strerror(errno));
+        return -1;
+    }
+
+    if ((__atomic_load_n(&seg->magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC) ||
+        (seg->version != METRICS_VERSION) || (seg->size != sizeof(metrics_segment)))
+    {
+        fprintf(stderr, "%s is not a pint metrics segment of version %d\n",
+                path, METRICS_VERSION);
+        munmap(seg, sizeof(metrics_segment));
+        return -1;
+    }
+
+    done = FALSE;
+    for (i = 0; (i < READ_ATTEMPTS) && !done; i++)
+    {
+        seq = __atomic_load_n(&seg->sequence, __ATOMIC_ACQUIRE);
+        if (seq & 1)
+        {
+            /* an update is in progress */
+            usleep(100);
+            continue;
+        }
+
+        memcpy(copy, seg, sizeof(metrics_segment));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        done = (__atomic_load_n(&seg->sequence, __ATOMIC_RELAXED) == seq);
+    }
+    munmap(seg, sizeof(metrics_segment));
+
+    if (!done)
+    {
+        fprintf(stderr, "%s is being updated all the time; is pint stuck?\n", path);
+        return -1;
+    }
+
+    /* the strings come from pint; make sure they end */
+    copy->mode[METRICS_MODE_SIZE - 1] = '\0';
+    if ((copy->listed_sessions < 0) || (copy->listed_sessions > METRICS_MAX_SESSIONS))
+    {
+        copy->listed_sessions = 0;
+    }
+    for (i = 0; i < copy->listed_sessions; i++)
+    {
+        copy->sessions[i].name[METRICS_NAME_SIZE - 1] = '\0';
+    }
+
+    return 0;
+}
+
+/*
+ * Returns TRUE if the process that published the segment is running.
+ * A segment is removed when pint exits, so one left behind means that
+ * pint was killed.
+ */
+int publisher_running(metrics_segment *m)
+{
+    return ((kill(m->pid, 0) == 0) || (errno == EPERM));
+}
+
+/*
+ * Returns the current wall clock time in nanoseconds.
+ */
+uint64_t now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Formats a latency bucket bound of 2^i microseconds.
+ */
+void format_bound(int i, char *s)
+{
+    if (i < 10)
+    {
+        sprintf(s, "%dus", 1 << i);
+    }
+    else if (i < 20)
+    {
+        sprintf(s, "%.3gms", (1 << i) / 1000.0);
+    }
+    else
+    {
+        sprintf(s, "%.3gs", (1 << i) / 1000000.0);
+    }
+}
+
+/*
+ * Prints the counters for a human.
+ */
+void print_text(metrics_segment *m)
+{
+    char started[64], bound[16];
+    time_t t;
+    int i, open;
+
+    t = m->started_ns / 1000000000ULL;
+    strftime(started, sizeof(started), "%Y-%m-%d %H:%M:%S", localtime(&t));
+
+    printf("pint %d (%s), %s, started %s, updated %.1fs ago\n",
+           m->pid, publisher_running(m) ? "running" : "gone", m->mode, started,
+           (now_ns() - m->updated_ns) / 1e9);
+    printf("in   %lld bytes in %lld reads\n", (long long)m->bytes_in, (long long)m->reads);
+    printf("out  %lld bytes in %lld sends\n", (long long)m->bytes_out, (long long)m->sends);
+    printf("errors %lld, queued %lld bytes\n", (long long)m->errors, (long long)m->queued);
+
+    if (m->latency_count > 0)
+    {
+        printf("latency: %lld measured, mean %.3fms\n", (long long)m->latency_count,
+               m->latency_sum_ns / 1e6 / m->latency_count);
+        for (i = 0; i < METRICS_LATENCY_BUCKETS; i++)
+        {
+            if (m->latency_buckets[i] == 0)
+            {
+                continue;
+            }
+
+            if (i < METRICS_LATENCY_BUCKETS - 1)
+            {
+                format_bound(i, bound);
+                printf("  <%-8s %lld\n", bound, (long long)m->latency_buckets[i]);
+            }
+            else
+            {
+                format_bound(i - 1, bound);
+                printf("  >=%-7s %lld\n", bound, (long long)m->latency_buckets[i]);
+            }
+        }
+    }
+
+    open = 0;
+    for (i = 0; i < m->listed_sessions; i++)
+    {
+        open += (m->sessions[i].state == METRICS_SESSION_OPEN);
+    }
+    printf("sessions: %d", m->num_sessions);
+    if (m->listed_sessions < m->num_sessions)
+    {
+        printf(", first %d listed", m->listed_sessions);
+    }
+    printf("\n");
+
+    for (i = 0; i < m->listed_sessions; i++)
+    {
+        printf("  #%d %-6s %-24s in %lld, out %lld, queued %lld\n",
+               m->sessions[i].id,
+               (m->sessions[i].state == METRICS_SESSION_OPEN) ? "open" : "closed",
+               m->sessions[i].name, (long long)m->sessions[i].bytes_in,
+               (long long)m->sessions[i].bytes_out, (long long)m->sessions[i].queued);
+    }
+}
+
+/*
+ * Prints a label value with backslashes, quotes and line breaks
+ * escaped, as the Prometheus text format wants.
+ */
+void print_label_value(char *s)
+{
+    for (; *s != '\0'; s++)
+    {
+        if ((*s == '\\') || (*s == '"'))
+        {
+            printf("\\%c", *s);
+        }
+        else if (*s == '\n')
+        {
+            printf("\\n");
+        }
+        else
+        {
+            putchar(*s);
+        }
+    }
+}
+
+/*
+ * Prints the labels identifying a session, for the metrics given per
+ * session.
+ */
+void print_session_labels(metrics_session *ms)
+{
+    printf("{session=\"%d\",peer=\"", ms->id);
+    print_label_value(ms->name);
+    printf("\"");
+}
+
+/*
+ * Prints the comment lines introducing a metric.
+ */
+void print_metric_header(char *name, char *type, char *help)
+{
+    printf("# HELP %s %s\n", name, help);
+    printf("# TYPE %s %s\n", name, type);
+}
+
+/*
+ * Prints the counters in the Prometheus text exposition format.
+ */
+void print_prometheus(metrics_segment *m)
+{
+    long long cumulative;
+    int i;
+
+    print_metric_header("pint_up", "gauge", "Whether the pint publishing the metrics is running.");
+    printf("pint_up %d\n", publisher_running(m));
+
+    print_metric_header("pint_info", "gauge", "What pint is doing.");
+    printf("pint_info{mode=\"");
+    print_label_value(m->mode);
+    printf("\",pid=\"%d\",version=\"%d\"} 1\n", m->pid, m->version);
+
+    print_metric_header("pint_start_time_seconds", "gauge",
+                        "When pint started, in seconds since the epoch.");
+    printf("pint_start_time_seconds %.3f\n", m->started_ns / 1e9);
+    print_metric_header("pint_last_update_time_seconds", "gauge",
+                        "When pint last published the metrics, in seconds since the epoch.");
+    printf("pint_last_update_time_seconds %.3f\n", m->updated_ns / 1e9);
+
+    print_metric_header("pint_bytes_total", "counter", "Bytes read from and sent to the network.");
+    printf("pint_bytes_total{direction=\"in\"} %lld\n", (long long)m->bytes_in);
+    printf("pint_bytes_total{direction=\"out\"} %lld\n", (long long)m->bytes_out);
+    print_metric_header("pint_socket_calls_total", "counter",
+                        "Reads and sends that moved data.");
+    printf("pint_socket_calls_total{direction=\"in\"} %lld\n", (long long)m->reads);
+    printf("pint_socket_calls_total{direction=\"out\"} %lld\n", (long long)m->sends);
+    print_metric_header("pint_errors_total", "counter",
+                        "Connections and transfers broken off by errors.");
+    printf("pint_errors_total %lld\n", (long long)m->errors);
+    print_metric_header("pint_queued_bytes", "gauge", "Bytes waiting to be sent.");
+    printf("pint_queued_bytes %lld\n", (long long)m->queued);
+    print_metric_header("pint_sessions", "gauge", "Sessions, open or closed.");
+    printf("pint_sessions %d\n", m->num_sessions);
+
+    if (m->listed_sessions > 0)
+    {
+        print_metric_header("pint_session_open", "gauge", "Whether a session is open.");
+        for (i = 0; i < m->listed_sessions; i++)
+        {
+            printf("pint_session_open");
+            print_session_labels(&m->sessions[i]);
+            printf("} %d\n", (m->sessions[i].state == METRICS_SESSION_OPEN));
+        }
+        print_metric_header("pint_session_bytes_total", "counter",
+                            "Bytes received and sent in a session.");
+        for (i = 0; i < m->listed_sessions; i++)
+        {
+            printf("pint_session_bytes_total");
+            print_session_labels(&m->sessions[i]);
+            printf(",direction=\"in\"} %lld\n", (long long)m->sessions[i].bytes_in);
+            printf("pint_session_bytes_total");
+            print_session_labels(&m->sessions[i]);
+            printf(",direction=\"out\"} %lld\n", (long long)m->sessions[i].bytes_out);
+        }
+        print_metric_header("pint_session_queued_bytes", "gauge",
+                            "Bytes waiting to be sent in a session.");
+        for (i = 0; i < m->listed_sessions; i++)
+        {
+            printf("pint_session_queued_bytes");
+            print_session_labels(&m->sessions[i]);
+            printf("} %lld\n", (long long)m->sessions[i].queued);
+        }
+    }
+
+    print_metric_header("pint_latency_seconds", "histogram",
+                        "Request to first response byte latencies.");
+    cumulative = 0;
+    for (i = 0; i < METRICS_LATENCY_BUCKETS - 1; i++)
+    {
+        cumulative += m->latency_buckets[i];
+        printf("pint_latency_seconds_bucket{le=\"%.6f\"} %lld\n", (1 << i) / 1e6, cumulative);
+    }
+    printf("pint_latency_seconds_bucket{le=\"+Inf\"} %lld\n", (long long)m->latency_count);
+    printf("pint_latency_seconds_sum %.9f\n", m->latency_sum_ns / 1e9);
+    printf("pint_latency_seconds_count %lld\n", (long long)m->latency_count);
+}
+
+/*
+ * Reads the segment named on the command line and prints it.
+ */
+int main(int argc, char *argv[])
+{
+    metrics_segment m;
+    char path[512], *name;
+    int i, prometheus;
+
+    name = NULL;
+    prometheus = FALSE;
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-prom") == 0)
+        {
+            prometheus = TRUE;
+        }
+        else if ((argv[i][0] != '-') && (name == NULL))
+        {
+            name = argv[i];
+        }
+        else
+        {
+            show_usage();
+            return 2;
+        }
+    }
+    if (name == NULL)
+    {
+        show_usage();
+        return 2;
+    }
+
+    snprintf(path, sizeof(path), "%s%s", (strchr(name, '/') == NULL) ? METRICS_DIR : "", name);
+    if (read_segment(path, &m) == -1)
+    {
+        return 1;
+    }
+
+    if (prometheus)
+    {
+        print_prometheus(&m);
+    }
+    else
+    {
+        print_text(&m);
+    }
+
+    return 0;
+}
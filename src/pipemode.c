@@ -0,0 +1,433 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <asm/errno.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/cmdline.h"
+#include "../include/network.h"
+#include "../include/stats.h"
+#include "../include/pipemode.h"
+#include "../include/metrics.h"
+
+/* TRUE when relaying raw bytes between stdio and the socket */
+int pipe_mode = FALSE;
+
+/*
+ * Checks whether pint is being used as a pipe, ie. neither stdin nor
+ * stdout is a terminal, and enables pipe mode if so.
+ *
+ * Returns TRUE if pipe mode was enabled
+ */
+int detect_pipe_mode()
+{
+    pipe_mode = (!isatty(STDIN_FILENO) && !isatty(STDOUT_FILENO));
+
+    return pipe_mode;
+}
+
+/*
+ * Sets up one direction of the relay. Splicing moves data through a
+ * kernel pipe without copying it to user space; copying goes through
+ * a buffer of the given capacity.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int init_pipe_stream(pipe_stream *ps, int in_fd, int out_fd,
+                     int transfer, int capacity)
+{
+    int size;
+
+    memset(ps, 0, sizeof(pipe_stream));
+    ps->in_fd = in_fd;
+    ps->out_fd = out_fd;
+    ps->pipe_fds[0] = ps->pipe_fds[1] = -1;
+    ps->capacity = capacity;
+    ps->in_open = TRUE;
+
+    if (transfer == PIPE_TRANSFER_SPLICE)
+    {
+        if (pipe2(ps->pipe_fds, O_NONBLOCK) == 0)
+        {
+            fcntl(ps->pipe_fds[1], F_SETPIPE_SZ, PIPE_MODE_PIPE_SIZE);
+            if ((size = fcntl(ps->pipe_fds[1], F_GETPIPE_SZ)) > 0)
+            {
+                ps->capacity = size;
+            }
+        }
+        else
+        {
+            transfer = PIPE_TRANSFER_COPY;
+        }
+    }
+    ps->transfer = transfer;
+
+    /* also allocated for splicing streams, which may fall back to copying */
+    if ((ps->buf = malloc(ps->capacity)) == NULL)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Releases the resources of a relay direction.
+ */
+void deinit_pipe_stream(pipe_stream *ps)
+{
+    if (ps->pipe_fds[0] != -1)
+    {
+        close(ps->pipe_fds[0]);
+        close(ps->pipe_fds[1]);
+        ps->pipe_fds[0] = ps->pipe_fds[1] = -1;
+    }
+
+    free(ps->buf);
+    ps->buf = NULL;
+}
+
+/*
+ * Switches a splicing stream to copying, used when one of its
+ * descriptors does not support splice(). Data already in the kernel
+ * pipe is moved to the copy buffer.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int fall_back_to_copy(pipe_stream *ps)
+{
+    int n;
+
+    ps->buf_off = 0;
+    n = 0;
+    while (n < ps->pending)
+    {
+        int r = read(ps->pipe_fds[0], ps->buf + n, ps->pending - n);
+        if (r <= 0)
+        {
+            return -1;
+        }
+        n += r;
+    }
+
+    close(ps->pipe_fds[0]);
+    close(ps->pipe_fds[1]);
+    ps->pipe_fds[0] = ps->pipe_fds[1] = -1;
+    ps->transfer = PIPE_TRANSFER_COPY;
+
+    return 0;
+}
+
+/*
+ * Returns TRUE if the stream has room for more input. A copy buffer is
+ * refilled only once it has been emptied, so that each read (and thus
+ * each datagram) is written out as a unit.
+ */
+int pipe_stream_wants_input(pipe_stream *ps)
+{
+    if (!ps->in_open)
+    {
+        return FALSE;
+    }
+
+    if (ps->transfer == PIPE_TRANSFER_SPLICE)
+    {
+        return (ps->pending < ps->capacity);
+    }
+
+    return (ps->pending == 0);
+}
+
+/*
+ * Moves available input of a stream into its pipe or buffer. For a
+ * UDP server socket that has no peer yet, the first datagram decides
+ * the peer.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int fill_pipe_stream(pipe_stream *ps)
+{
+    int n;
+    char msg[512];
+
+    if (!pipe_stream_wants_input(ps))
+    {
+        return 0;
+    }
+
+    n = -1;
+    if (ps->transfer == PIPE_TRANSFER_SPLICE)
+    {
+        n = splice(ps->in_fd, NULL, ps->pipe_fds[1], NULL,
+                   ps->capacity - ps->pending,
+                   SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+        if ((n == -1) && (errno == EINVAL))
+        {
+            if (fall_back_to_copy(ps) == -1)
+            {
+                write_info_wnd("failed to empty splice pipe\n");
+                return -1;
+            }
+
+            if (ps->pending > 0)
+            {
+                return 0;
+            }
+        }
+    }
+
+    if (ps->transfer == PIPE_TRANSFER_COPY)
+    {
+        if (ps->accept_peer)
+        {
+            ps->accept_peer = FALSE;
+            n = accept_udp_peer(ps->in_fd, ps->buf, ps->capacity);
+            if (n == -1)
+            {
+                return -1;
+            }
+        }
+        else
+        {
+            n = read(ps->in_fd, ps->buf, ps->capacity);
+        }
+        ps->buf_off = 0;
+    }
+
+    if (n > 0)
+    {
+        ps->pending += n;
+        if (ps->read_stats != NULL)
+        {
+            stats_count(ps->read_stats, n);
+        }
+    }
+    else if (n == 0)
+    {
+        if (!ps->datagrams)
+        {
+            ps->in_open = FALSE;
+        }
+    }
+    else if ((errno != EAGAIN) && (errno != EINTR))
+    {
+        stats_errors++;
+        sprintf(msg, "reading descriptor %d failed (%s)\n",
+                ps->in_fd, strerror(errno));
+        write_info_wnd(msg);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Writes out as much of the pending data of a stream as the output
+ * descriptor accepts.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int drain_pipe_stream(pipe_stream *ps)
+{
+    int n;
+    char msg[512];
+
+    if (ps->pending == 0)
+    {
+        return 0;
+    }
+
+    n = -1;
+    if (ps->transfer == PIPE_TRANSFER_SPLICE)
+    {
+        n = splice(ps->pipe_fds[0], NULL, ps->out_fd, NULL, ps->pending,
+                   SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+        if ((n == -1) && (errno == EINVAL))
+        {
+            if (fall_back_to_copy(ps) == -1)
+            {
+                write_info_wnd("failed to empty splice pipe\n");
+                return -1;
+            }
+        }
+    }
+
+    if (ps->transfer == PIPE_TRANSFER_COPY)
+    {
+        n = write(ps->out_fd, ps->buf + ps->buf_off, ps->pending);
+        if (n > 0)
+        {
+            ps->buf_off += n;
+        }
+    }
+
+    if (n > 0)
+    {
+        ps->pending -= n;
+        if (ps->write_stats != NULL)
+        {
+            stats_count(ps->write_stats, n);
+        }
+    }
+    else if ((n == -1) && (errno != EAGAIN) && (errno != EINTR))
+    {
+        stats_errors++;
+        sprintf(msg, "writing descriptor %d failed (%s)\n",
+                ps->out_fd, strerror(errno));
+        write_info_wnd(msg);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Relays bytes between stdio and the socket until both directions are
+ * done. TCP data is spliced; UDP data is copied one datagram at a time
+ * since splicing would not preserve datagram boundaries. When stdin
+ * reaches EOF, the sending side of a TCP connection is shut down; the
+ * remote end closing its side only ends the other direction, so the
+ * relay goes on until stdin is sent too. If accept_peer is TRUE, the
+ * socket is an unconnected UDP server socket and stdin is held back
+ * until the first datagram has arrived.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int handle_pipe_connection(int sockfd, int accept_peer)
+{
+    pipe_stream to_sock, from_sock;
+    fd_set read_set, write_set;
+    struct timeval timeout;
+    int socket_type, transfer, stream;
+    int shut_down, maxfd, error;
+    char msg[512];
+
+    socket_type = cmdline_params.socket_type;
+    stream = (socket_type == SOCKTYPE_TCP);
+    transfer = stream ? PIPE_TRANSFER_SPLICE : PIPE_TRANSFER_COPY;
+
+    if ((init_pipe_stream(&to_sock, STDIN_FILENO, sockfd, transfer,
+                          stream ? PIPE_MODE_PIPE_SIZE : PIPE_MODE_DATAGRAM_SIZE) == -1) ||
+        (init_pipe_stream(&from_sock, sockfd, STDOUT_FILENO, transfer,
+                          stream ? PIPE_MODE_PIPE_SIZE : PIPE_MODE_DATAGRAM_SIZE + 1) == -1))
+    {
+        write_info_wnd("out of memory for pipe buffers\n");
+        deinit_pipe_stream(&to_sock);
+        deinit_pipe_stream(&from_sock);
+        return -1;
+    }
+    from_sock.datagrams = !stream;
+    from_sock.accept_peer = accept_peer;
+    from_sock.read_stats = &stats_in;
+    to_sock.write_stats = &stats_out;
+
+    /* a closed stdout or socket shows up as EPIPE instead */
+    signal(SIGPIPE, SIG_IGN);
+
+    maxfd = (sockfd > STDOUT_FILENO) ? sockfd : STDOUT_FILENO;
+    shut_down = !stream;
+    error = FALSE;
+
+    while (!error && (from_sock.in_open || (from_sock.pending > 0) || !shut_down))
+    {
+        FD_ZERO(&read_set);
+        FD_ZERO(&write_set);
+
+        if (pipe_stream_wants_input(&to_sock) && !from_sock.accept_peer)
+        {
+            FD_SET(STDIN_FILENO, &read_set);
+        }
+        if (to_sock.pending > 0)
+        {
+            FD_SET(sockfd, &write_set);
+        }
+        if (pipe_stream_wants_input(&from_sock))
+        {
+            FD_SET(sockfd, &read_set);
+        }
+        if (from_sock.pending > 0)
+        {
+            FD_SET(STDOUT_FILENO, &write_set);
+        }
+
+        /* with metrics on, wake up to publish them even when idle */
+        timeout.tv_sec = METRICS_INTERVAL / 1000000;
+        timeout.tv_usec = METRICS_INTERVAL % 1000000;
+        if (select(maxfd + 1, &read_set, &write_set, NULL,
+                   (cmdline_params.metrics_name != NULL) ? &timeout : NULL) == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            sprintf(msg, "select() failed (%s)\n", strerror(errno));
+            write_info_wnd(msg);
+            error = TRUE;
+            break;
+        }
+
+        if (FD_ISSET(STDIN_FILENO, &read_set))
+        {
+            error |= (fill_pipe_stream(&to_sock) == -1);
+        }
+        if (FD_ISSET(sockfd, &read_set))
+        {
+            error |= (fill_pipe_stream(&from_sock) == -1);
+        }
+
+        /* try writing right away; the output is usually ready */
+        error |= (drain_pipe_stream(&to_sock) == -1);
+        error |= (drain_pipe_stream(&from_sock) == -1);
+
+        if (!shut_down && !to_sock.in_open && (to_sock.pending == 0))
+        {
+            shutdown(sockfd, SHUT_WR);
+            shut_down = TRUE;
+        }
+
+        metrics_tick(to_sock.pending + from_sock.pending);
+    }
+
+    deinit_pipe_stream(&to_sock);
+    deinit_pipe_stream(&from_sock);
+
+    return error ? -1 : 0;
+}
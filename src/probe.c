@@ -0,0 +1,228 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/formatters.h"
+#include "../include/history.h"
+#include "../include/viewport.h"
+#include "../include/sendqueue.h"
+#include "../include/session.h"
+#include "../include/eventloop.h"
+#include "../include/capture.h"
+#include "../include/histogram.h"
+#include "../include/probe.h"
+
+/* the session the last line went to while its response is awaited,
+   or NULL */
+session *probe_session = NULL;
+
+/* when the line was sent, and when the first and the latest byte of
+   the response arrived */
+uint64_t probe_sent_ns;
+uint64_t probe_first_ns;
+uint64_t probe_last_ns;
+long long probe_bytes;
+
+/* responses measured, and their latencies to the first byte and to
+   the end */
+long long probe_responses = 0;
+histogram probe_first_bytes;
+histogram probe_completions;
+
+/* the timer noticing that a response has gone quiet */
+int probe_timer = -1;
+int probe_timer_armed = FALSE;
+
+/* the first byte latencies are shown counted in these decades */
+uint64_t probe_decades[] = { 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL };
+char *probe_decade_names[] = { "<100us", "<1ms", "<10ms", "<100ms", "<1s", "1s+" };
+
+void probe_quiet(int, int, void *);
+
+/*
+ * Prepares the measurements; called once the event loop is up.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int probe_init()
+{
+    histogram_reset(&probe_first_bytes);
+    histogram_reset(&probe_completions);
+
+    if ((probe_timer = event_add_timer(probe_quiet, NULL)) == -1)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Shows the latencies of the response just completed, and the first
+ * byte latencies so far counted in decades.
+ */
+void probe_report()
+{
+    char msg[512], first[16], complete[16], first50[16], complete50[16];
+    uint64_t below, counted;
+    int i, len;
+
+    probe_responses++;
+    histogram_record(&probe_completions, probe_last_ns - probe_sent_ns);
+
+    format_latency(probe_first_ns - probe_sent_ns, first);
+    format_latency(probe_last_ns - probe_sent_ns, complete);
+    format_latency(histogram_percentile(&probe_first_bytes, 50), first50);
+    format_latency(histogram_percentile(&probe_completions, 50), complete50);
+    sprintf(msg, "Response %lld: first byte %s, complete %s, %lld bytes; p50 %s / %s\n",
+            probe_responses, first, complete, probe_bytes, first50, complete50);
+    write_info_wnd(msg);
+
+    len = sprintf(msg, "First byte:");
+    counted = 0;
+    for (i = 0; i < sizeof(probe_decades) / sizeof(uint64_t); i++)
+    {
+        below = histogram_count_below(&probe_first_bytes, probe_decades[i]);
+        len += sprintf(msg + len, " %s %llu,", probe_decade_names[i],
+                       (unsigned long long)(below - counted));
+        counted = below;
+    }
+    sprintf(msg + len, " %s %llu\n", probe_decade_names[i],
+            (unsigned long long)(probe_first_bytes.total - counted));
+    write_info_wnd(msg);
+}
+
+/*
+ * Ends the measurement of the response being awaited. A line that got
+ * no response at all is not counted; not every line asks for one.
+ */
+void probe_finish()
+{
+    if (probe_session == NULL)
+    {
+        return;
+    }
+
+    if (probe_first_ns != 0)
+    {
+        probe_report();
+    }
+    probe_session = NULL;
+}
+
+/*
+ * Timer callback: the response is complete if nothing has arrived
+ * for PROBE_QUIET_USEC, otherwise the timer is set for the rest of
+ * the quiet time.
+ */
+void probe_quiet(int fd, int events, void *data)
+{
+    uint64_t quiet_usec;
+
+    probe_timer_armed = FALSE;
+    if (probe_session == NULL)
+    {
+        return;
+    }
+
+    quiet_usec = (capture_clock_ns(CLOCK_MONOTONIC) - probe_last_ns) / 1000;
+    if (quiet_usec >= PROBE_QUIET_USEC)
+    {
+        probe_finish();
+        return;
+    }
+
+    event_set_timer(probe_timer, PROBE_QUIET_USEC - quiet_usec);
+    probe_timer_armed = TRUE;
+}
+
+/*
+ * Starts measuring the response to a line about to be sent to a
+ * session. The response to the previous line ends here if it has not
+ * gone quiet yet.
+ */
+void probe_sent(session *s)
+{
+    if (probe_timer == -1)
+    {
+        return;
+    }
+
+    probe_finish();
+
+    probe_session = s;
+    probe_sent_ns = capture_clock_ns(CLOCK_MONOTONIC);
+    probe_first_ns = 0;
+    probe_last_ns = 0;
+    probe_bytes = 0;
+}
+
+/*
+ * Notes the arrival of bytes from a session. The quiet timer is armed
+ * once per quiet period rather than per read.
+ */
+void probe_received(session *s, int n)
+{
+    uint64_t now;
+
+    if (s != probe_session)
+    {
+        return;
+    }
+
+    now = capture_clock_ns(CLOCK_MONOTONIC);
+    if (probe_first_ns == 0)
+    {
+        probe_first_ns = now;
+        histogram_record(&probe_first_bytes, now - probe_sent_ns);
+    }
+    probe_last_ns = now;
+    probe_bytes += n;
+
+    if (!probe_timer_armed)
+    {
+        event_set_timer(probe_timer, PROBE_QUIET_USEC);
+        probe_timer_armed = TRUE;
+    }
+}
+
+/*
+ * Ends the measurement when the session it is for closes: the
+ * response is complete.
+ */
+void probe_closed(session *s)
+{
+    if (s == probe_session)
+    {
+        probe_finish();
+    }
+}
@@ -0,0 +1,576 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/formatters.h"
+#include "../include/network.h"
+#include "../include/batch.h"
+#include "../include/eventloop.h"
+#include "../include/sendqueue.h"
+#include "../include/capture.h"
+#include "../include/replay.h"
+
+/* TRUE when replaying a capture */
+int replay_mode = FALSE;
+
+/* the mapped capture, and the session replayed from it */
+unsigned char *replay_map = MAP_FAILED;
+size_t replay_map_size = 0;
+int replay_session = 0;
+char replay_name[256];
+
+/* the recorded outbound messages, and the next one to send */
+replay_chunk *replay_out = NULL;
+int num_replay_out = 0;
+int replay_next = 0;
+long long replay_out_bytes = 0;
+
+/* the recorded response, and how far the live one has matched it */
+replay_chunk *replay_in = NULL;
+int num_replay_in = 0;
+int replay_in_index = 0;
+int replay_in_off = 0;
+long long replay_in_bytes = 0;
+
+int replay_sockfd = -1;
+send_queue replay_queue;
+double replay_speed = 1.0;
+unsigned long long replay_started_ns = 0;
+int replay_send_timer = -1;
+int replay_wait_timer = -1;
+
+/* progress of the live session */
+long long replay_sent = 0;
+long long replay_received = 0;
+long long replay_extra = 0;
+int replay_divergences = 0;
+int replay_mismatch = FALSE;
+int replay_peer_closed = FALSE;
+int replay_done_sending = FALSE;
+
+/*
+ * Appends a record to a chunk array, growing it as needed.
+ *
+ * Returns 0 on success, -1 if out of memory
+ */
+int replay_add_chunk(replay_chunk **chunks, int *num, capture_record *rec,
+                     unsigned long long base_ns)
+{
+    replay_chunk *tmp;
+
+    /* grow by doubling; the size is kept implicitly as the next power
+       of two */
+    if ((*num & (*num - 1)) == 0)
+    {
+        tmp = (replay_chunk *)realloc(*chunks, ((*num > 0) ? *num * 2 : 16) *
+                                      sizeof(replay_chunk));
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+        *chunks = tmp;
+    }
+
+    (*chunks)[*num].data = (unsigned char *)(rec + 1);
+    (*chunks)[*num].len = rec->length;
+    (*chunks)[*num].at_ns = (rec->timestamp_ns > base_ns) ? rec->timestamp_ns - base_ns : 0;
+    (*num)++;
+
+    return 0;
+}
+
+/*
+ * Maps a capture log and picks the messages of a session out of it:
+ * the given one, or with 0, the first one that sent anything.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int replay_open(char *path, int session)
+{
+    capture_header *header;
+    capture_record *rec;
+    unsigned long long base_ns;
+    size_t off;
+
+    if ((replay_map = capture_map_log(path, &replay_map_size)) == NULL)
+    {
+        replay_map = MAP_FAILED;
+        return -1;
+    }
+    header = (capture_header *)replay_map;
+    madvise(replay_map, replay_map_size, MADV_SEQUENTIAL);
+
+    /* find the session */
+    off = header->header_size;
+    while ((session == 0) && ((rec = capture_next(replay_map, replay_map_size, &off)) != NULL))
+    {
+        if (rec->type == CAPTURE_OUT)
+        {
+            session = rec->session;
+        }
+    }
+
+    /* its messages are timed from when it was opened */
+    base_ns = 0;
+    off = header->header_size;
+    while ((rec = capture_next(replay_map, replay_map_size, &off)) != NULL)
+    {
+        if (rec->session != session)
+        {
+            continue;
+        }
+
+        if (base_ns == 0)
+        {
+            base_ns = rec->timestamp_ns;
+        }
+
+        switch (rec->type)
+        {
+        case CAPTURE_OPEN:
+            base_ns = rec->timestamp_ns;
+            if (rec->length >= sizeof(capture_endpoints))
+            {
+                snprintf(replay_name, sizeof(replay_name), "%.*s",
+                         (int)(rec->length - sizeof(capture_endpoints)),
+                         (char *)(rec + 1) + sizeof(capture_endpoints));
+            }
+            break;
+        case CAPTURE_OUT:
+            if ((rec->length > 0) &&
+                (replay_add_chunk(&replay_out, &num_replay_out, rec, base_ns) == -1))
+            {
+                printf("out of memory for the capture index\n");
+                return -1;
+            }
+            replay_out_bytes += rec->length;
+            break;
+        case CAPTURE_IN:
+            if ((rec->length > 0) &&
+                (replay_add_chunk(&replay_in, &num_replay_in, rec, base_ns) == -1))
+            {
+                printf("out of memory for the capture index\n");
+                return -1;
+            }
+            replay_in_bytes += rec->length;
+            break;
+        }
+    }
+
+    if (num_replay_out == 0)
+    {
+        printf("%s has no messages sent by session %d\n", path, session);
+        return -1;
+    }
+
+    replay_session = session;
+    replay_mode = TRUE;
+
+    return 0;
+}
+
+/*
+ * Returns the time since the replay started, in nanoseconds.
+ */
+unsigned long long replay_elapsed_ns()
+{
+    return capture_clock_ns(CLOCK_MONOTONIC) - replay_started_ns;
+}
+
+/*
+ * Copies up to len bytes of the recorded response, starting at the
+ * current comparison point plus skip bytes.
+ *
+ * Returns the number of bytes copied
+ */
+int replay_expected(int skip, unsigned char *buf, int len)
+{
+    int i, off, n, copied;
+
+    copied = 0;
+    off = replay_in_off + skip;
+    for (i = replay_in_index; (i < num_replay_in) && (copied < len); i++, off = 0)
+    {
+        if (off >= replay_in[i].len)
+        {
+            off -= replay_in[i].len;
+            continue;
+        }
+
+        n = replay_in[i].len - off;
+        if (n > len - copied)
+        {
+            n = len - copied;
+        }
+        memcpy(buf + copied, replay_in[i].data + off, n);
+        copied += n;
+    }
+
+    return copied;
+}
+
+/*
+ * Formats bytes the way the received bytes window does; the text
+ * format is swapped for the wide one, which keeps to a single line.
+ */
+void replay_format(const unsigned char *buf, int len, char *dest)
+{
+    display_format *format;
+    int n;
+
+    format = (sock_in_format->formatter == text_formatter) ?
+             &display_formats[FORMATTER_WIDE] : sock_in_format;
+
+    n = format->formatter(buf, len, dest);
+    if (n > 0)
+    {
+        /* drop the separator after the last cell */
+        dest[n - 1] = '\0';
+    }
+}
+
+/*
+ * Reports a divergence from the recorded response. It starts skip
+ * bytes past the comparison point; buf holds the received bytes from
+ * there on.
+ */
+void replay_report(long long offset, int skip, const unsigned char *buf, int len)
+{
+    unsigned char expected[REPLAY_DIFF_CONTEXT];
+    char line[FORMAT_BUFFER_SIZE(REPLAY_DIFF_CONTEXT) + 64];
+    char cells[FORMAT_BUFFER_SIZE(REPLAY_DIFF_CONTEXT)];
+    int n;
+
+    replay_divergences++;
+    if (replay_divergences > REPLAY_MAX_REPORTS)
+    {
+        return;
+    }
+
+    sprintf(line, "divergence at offset %lld (+%.3fs, after message %d of %d)\n",
+            offset, replay_elapsed_ns() / 1e9, replay_next, num_replay_out);
+    batch_write_line(line);
+
+    n = replay_expected(skip, expected, REPLAY_DIFF_CONTEXT);
+    replay_format(expected, n, cells);
+    sprintf(line, "  recorded: %s\n", cells);
+    batch_write_line(line);
+
+    replay_format(buf, (len < REPLAY_DIFF_CONTEXT) ? len : REPLAY_DIFF_CONTEXT, cells);
+    sprintf(line, "  received: %s\n", cells);
+    batch_write_line(line);
+}
+
+/*
+ * Compares received bytes with the recorded response. Matching runs
+ * are compared chunk by chunk; past a divergence, byte by byte, so
+ * that each new divergence is reported where it starts.
+ */
+void replay_compare(const unsigned char *buf, int n)
+{
+    replay_chunk *c;
+    const unsigned char *exp;
+    char line[128];
+    int i, j, piece, match;
+
+    for (i = 0; (i < n) && (replay_in_index < num_replay_in); i += piece)
+    {
+        c = &replay_in[replay_in_index];
+        exp = c->data + replay_in_off;
+        piece = c->len - replay_in_off;
+        if (piece > n - i)
+        {
+            piece = n - i;
+        }
+
+        if (replay_mismatch || (memcmp(exp, buf + i, piece) != 0))
+        {
+            for (j = 0; j < piece; j++)
+            {
+                match = (exp[j] == buf[i + j]);
+                if (!match && !replay_mismatch)
+                {
+                    replay_report(replay_received + i + j, j, buf + i + j, n - i - j);
+                }
+                replay_mismatch = !match;
+            }
+        }
+
+        replay_in_off += piece;
+        if (replay_in_off == c->len)
+        {
+            replay_in_index++;
+            replay_in_off = 0;
+        }
+    }
+
+    if ((i < n) && (replay_extra == 0))
+    {
+        sprintf(line, "unexpected bytes past the recorded response at offset %lld\n",
+                replay_received + i);
+        batch_write_line(line);
+    }
+    replay_extra += n - i;
+    replay_received += n;
+}
+
+/*
+ * Arms the timer that ends the replay once the response has paused
+ * long enough. Only runs once everything has been sent.
+ */
+void replay_arm_wait()
+{
+    if (replay_done_sending)
+    {
+        event_set_timer(replay_wait_timer, (replay_received >= replay_in_bytes) ?
+                        REPLAY_LINGER : REPLAY_TIMEOUT);
+    }
+}
+
+/*
+ * Counts the bytes the send queue wrote.
+ */
+void replay_written(unsigned char *buf, int n, int from_file, void *data)
+{
+    replay_sent += n;
+}
+
+/* the writer below drains the queue with replay_pump() */
+void replay_writable(int, int, void *);
+
+/*
+ * Queues the messages that are due, as long as the queue has room,
+ * and writes what the socket takes. Once the last message is out, the
+ * sending side is shut down, like at the end of stdin in batch mode.
+ */
+void replay_pump()
+{
+    unsigned long long due;
+    replay_chunk *m;
+    char msg[512];
+    int waiting;
+
+    /* the queue may drain at once, leaving room for more */
+    do
+    {
+        waiting = FALSE;
+        while ((replay_next < num_replay_out) &&
+               (replay_queue.bytes < SEND_QUEUE_HIGH_WATER))
+        {
+            m = &replay_out[replay_next];
+            if (replay_speed > 0)
+            {
+                due = (unsigned long long)(m->at_ns / replay_speed);
+                if (due > replay_elapsed_ns())
+                {
+                    event_set_timer(replay_send_timer,
+                                    (due - replay_elapsed_ns()) / 1000 + 1);
+                    waiting = TRUE;
+                    break;
+                }
+            }
+
+            if (send_queue_push(&replay_queue, (unsigned char *)m->data, m->len) == -1)
+            {
+                write_info_wnd("out of memory for the send queue\n");
+                event_loop_stop();
+                return;
+            }
+            replay_next++;
+        }
+
+        if (send_queue_drain(&replay_queue, replay_sockfd, replay_written, NULL, NULL) < 0)
+        {
+            sprintf(msg, "Error writing to the connection (%s)\n", strerror(errno));
+            write_info_wnd(msg);
+            event_loop_stop();
+            return;
+        }
+    } while ((replay_queue.head == NULL) && (replay_next < num_replay_out) && !waiting);
+
+    event_set_writer(replay_sockfd, (replay_queue.head != NULL) ? replay_writable : NULL);
+
+    if ((replay_next == num_replay_out) && (replay_queue.head == NULL) &&
+        !replay_done_sending)
+    {
+        replay_done_sending = TRUE;
+        if (socket_type == SOCKTYPE_TCP)
+        {
+            shutdown(replay_sockfd, SHUT_WR);
+        }
+        replay_arm_wait();
+    }
+}
+
+/*
+ * Writer of the replay socket.
+ */
+void replay_writable(int fd, int events, void *data)
+{
+    replay_pump();
+}
+
+/*
+ * Sends the next messages when they are due.
+ */
+void replay_send_due(int fd, int events, void *data)
+{
+    replay_pump();
+}
+
+/*
+ * Ends the replay when the response has paused for long enough.
+ */
+void replay_wait_expired(int fd, int events, void *data)
+{
+    event_loop_stop();
+}
+
+/*
+ * Reader of the replay socket.
+ */
+void replay_input(int fd, unsigned char *buf, int n, void *data)
+{
+    char msg[512];
+
+    if (n < 0)
+    {
+        sprintf(msg, "Error reading socket (%s)\n", strerror(errno));
+        write_info_wnd(msg);
+        event_loop_stop();
+        return;
+    }
+
+    if ((n == 0) && (socket_type == SOCKTYPE_TCP))
+    {
+        replay_peer_closed = TRUE;
+        event_loop_stop();
+        return;
+    }
+
+    replay_compare(buf, n);
+    replay_arm_wait();
+}
+
+/*
+ * Starts replaying the session over a connected socket, at the given
+ * speed relative to the recording; 0 sends as fast as possible.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int replay_start(int sockfd, double speed)
+{
+    char line[512], size[16];
+
+    replay_sockfd = sockfd;
+    replay_speed = speed;
+    send_queue_init(&replay_queue, socket_type == SOCKTYPE_UDP, FALSE);
+
+    if ((event_add_reader(sockfd, replay_input, NULL) == -1) ||
+        ((replay_send_timer = event_add_timer(replay_send_due, NULL)) == -1) ||
+        ((replay_wait_timer = event_add_timer(replay_wait_expired, NULL)) == -1))
+    {
+        return -1;
+    }
+
+    format_size(replay_out_bytes, size);
+    if (speed > 0)
+    {
+        snprintf(line, sizeof(line), "replaying session %d (%s): %d messages, %s, at %gx speed\n",
+                 replay_session, replay_name, num_replay_out, size, speed);
+    }
+    else
+    {
+        snprintf(line, sizeof(line), "replaying session %d (%s): %d messages, %s, as fast as possible\n",
+                 replay_session, replay_name, num_replay_out, size);
+    }
+    batch_write_line(line);
+
+    replay_started_ns = capture_clock_ns(CLOCK_MONOTONIC);
+    replay_pump();
+
+    return 0;
+}
+
+/*
+ * Reports how the replay went and releases it.
+ *
+ * Returns 0 if the response matched the recorded one, 1 if not
+ */
+int replay_finish()
+{
+    char line[512], sent[16], rate[24];
+    int identical;
+
+    format_size(replay_sent, sent);
+    format_rate(replay_sent, replay_elapsed_ns() / 1000, rate);
+
+    if (replay_divergences > REPLAY_MAX_REPORTS)
+    {
+        sprintf(line, "%d more divergences not shown\n",
+                replay_divergences - REPLAY_MAX_REPORTS);
+        batch_write_line(line);
+    }
+
+    if (replay_received < replay_in_bytes)
+    {
+        sprintf(line, "response ended at offset %lld of %lld%s\n", replay_received,
+                replay_in_bytes, replay_peer_closed ? ", closed by the remote host" : "");
+        batch_write_line(line);
+    }
+
+    sprintf(line, "replay %s: %d of %d messages (%s) sent in %.3fs, %s; "
+            "%lld of %lld bytes received, %d divergence%s, %lld extra bytes\n",
+            (replay_next == num_replay_out) ? "done" : "cut short",
+            replay_next, num_replay_out, sent, replay_elapsed_ns() / 1e9, rate,
+            replay_received - replay_extra, replay_in_bytes, replay_divergences,
+            (replay_divergences == 1) ? "" : "s", replay_extra);
+    batch_write_line(line);
+
+    identical = (replay_divergences == 0) && (replay_extra == 0) &&
+                (replay_received == replay_in_bytes) && (replay_next == num_replay_out);
+
+    send_queue_clear(&replay_queue);
+    free(replay_out);
+    free(replay_in);
+    munmap(replay_map, replay_map_size);
+    replay_out = replay_in = NULL;
+    replay_map = MAP_FAILED;
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,479 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/checksum.h"
+#include "../include/sendqueue.h"
+
+/*
+ * Initializes an empty queue.
+ */
+void send_queue_init(send_queue *q, int datagrams, int cork)
+{
+    memset(q, 0, sizeof(send_queue));
+    q->datagrams = datagrams;
+    q->cork = cork && !datagrams;
+}
+
+/*
+ * Links a buffer of len bytes to the end of the queue.
+ */
+void send_queue_append(send_queue *q, send_buffer *b, long long len)
+{
+    if (q->tail != NULL)
+    {
+        q->tail->next = b;
+    }
+    else
+    {
+        q->head = b;
+    }
+    q->tail = b;
+
+    q->buffers++;
+    q->bytes += len;
+    if (q->bytes > q->peak_bytes)
+    {
+        q->peak_bytes = q->bytes;
+    }
+}
+
+/*
+ * Appends a copy of len bytes to the queue.
+ *
+ * Returns 0 on success, -1 if the queue is full or out of memory
+ */
+int send_queue_push(send_queue *q, unsigned char *buf, int len)
+{
+    send_buffer *b;
+
+    if (q->bytes + len > SEND_QUEUE_LIMIT)
+    {
+        return -1;
+    }
+
+    /* the data follows the buffer header in the same allocation */
+    b = (send_buffer *)malloc(sizeof(send_buffer) + len);
+    if (b == NULL)
+    {
+        return -1;
+    }
+
+    b->next = NULL;
+    b->len = len;
+    b->off = 0;
+    b->data = (unsigned char *)(b + 1);
+    b->file = NULL;
+    memcpy(b->data, buf, len);
+
+    send_queue_append(q, b, len);
+
+    return 0;
+}
+
+/*
+ * Appends a regular file to the queue. Its contents are not read
+ * into memory; they count towards the queued bytes but not towards
+ * the limit.
+ *
+ * Returns 0 on success, -1 on error (errno tells the reason)
+ */
+int send_queue_push_file(send_queue *q, char *path)
+{
+    send_buffer *b;
+    send_file *f;
+    struct stat st;
+    char *name;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) == -1)
+    {
+        return -1;
+    }
+
+    if ((fstat(fd, &st) == -1) || !S_ISREG(st.st_mode))
+    {
+        close(fd);
+        errno = (errno != 0) ? errno : EINVAL;
+        return -1;
+    }
+
+    b = (send_buffer *)malloc(sizeof(send_buffer) + sizeof(send_file));
+    if (b == NULL)
+    {
+        close(fd);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    memset(b, 0, sizeof(send_buffer) + sizeof(send_file));
+    f = (send_file *)(b + 1);
+    b->file = f;
+
+    f->fd = fd;
+    f->size = st.st_size;
+    name = strrchr(path, '/');
+    snprintf(f->name, SEND_FILE_NAME_SIZE, "%s", (name != NULL) ? name + 1 : path);
+
+    /* the checksum reads the pages sendfile() sends; without a
+       mapping there is no checksum */
+    if (f->size > 0)
+    {
+        f->map = mmap(NULL, f->size, PROT_READ, MAP_SHARED, fd, 0);
+        if (f->map == MAP_FAILED)
+        {
+            f->map = NULL;
+        }
+        else
+        {
+            madvise(f->map, f->size, MADV_SEQUENTIAL);
+        }
+    }
+
+    send_queue_append(q, b, f->size);
+
+    return 0;
+}
+
+/*
+ * Frees a buffer unlinked from its queue, closing its file.
+ */
+void send_buffer_free(send_buffer *b)
+{
+    if (b->file != NULL)
+    {
+        if (b->file->map != NULL)
+        {
+            munmap(b->file->map, b->file->size);
+        }
+        close(b->file->fd);
+    }
+    free(b);
+}
+
+/*
+ * Frees the buffer at the head of the queue.
+ */
+void send_queue_pop(send_queue *q)
+{
+    send_buffer *b = q->head;
+
+    q->head = b->next;
+    if (q->head == NULL)
+    {
+        q->tail = NULL;
+    }
+    q->buffers--;
+
+    send_buffer_free(b);
+}
+
+/*
+ * Drops the buffers appended after mark, the tail of the queue at an
+ * earlier point (NULL if it was empty then). Nothing may have been
+ * written from the queue in between.
+ */
+void send_queue_rollback(send_queue *q, send_buffer *mark)
+{
+    send_buffer *b, *next;
+
+    b = (mark != NULL) ? mark->next : q->head;
+    while (b != NULL)
+    {
+        next = b->next;
+        q->buffers--;
+        q->bytes -= (b->file != NULL) ? b->file->size : b->len;
+        send_buffer_free(b);
+        b = next;
+    }
+
+    if (mark != NULL)
+    {
+        mark->next = NULL;
+    }
+    else
+    {
+        q->head = NULL;
+    }
+    q->tail = mark;
+}
+
+/*
+ * Sets or clears TCP_CORK on a socket for a corking queue.
+ */
+void send_queue_set_cork(send_queue *q, int fd, int on)
+{
+    if (!q->cork || (q->corked == on))
+    {
+        return;
+    }
+
+    setsockopt(fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+    q->corked = on;
+}
+
+/*
+ * Writes the next chunk of a queued file, checksumming what went.
+ *
+ * Returns the number of bytes written, or -1 on error
+ */
+ssize_t send_file_write(send_file *f, int fd)
+{
+    off_t off;
+    long long chunk;
+    ssize_t n;
+
+    if (f->started.tv_sec == 0)
+    {
+        gettimeofday(&f->started, NULL);
+    }
+
+    chunk = f->size - f->sent;
+    if (chunk > SEND_FILE_CHUNK)
+    {
+        chunk = SEND_FILE_CHUNK;
+    }
+
+    off = f->sent;
+    n = sendfile(fd, f->fd, &off, chunk);
+    if ((n == -1) && ((errno == EINVAL) || (errno == ENOSYS)) && (f->map != NULL))
+    {
+        /* no sendfile() between these two: write from the mapping */
+        n = write(fd, f->map + f->sent, chunk);
+    }
+
+    if (n > 0)
+    {
+        if (f->map != NULL)
+        {
+            f->crc = crc32_update(f->crc, f->map + f->sent, n);
+        }
+        f->sent += n;
+    }
+
+    return n;
+}
+
+/*
+ * Writes one round of a stream queue: up to SEND_QUEUE_MAX_IOV buffers
+ * with a single writev(), or a chunk of a file.
+ *
+ * Returns the number of bytes written, or -1 on error
+ */
+ssize_t send_queue_write(send_queue *q, int fd)
+{
+    struct iovec iov[SEND_QUEUE_MAX_IOV];
+    send_buffer *b;
+    int count;
+
+    if (q->head->file != NULL)
+    {
+        return send_file_write(q->head->file, fd);
+    }
+
+    /* gather the buffers up to the next file */
+    for (b = q->head, count = 0;
+         (b != NULL) && (b->file == NULL) && (count < SEND_QUEUE_MAX_IOV);
+         b = b->next, count++)
+    {
+        iov[count].iov_base = b->data + b->off;
+        iov[count].iov_len = b->len - b->off;
+    }
+
+    return writev(fd, iov, count);
+}
+
+/*
+ * Sends up to SEND_QUEUE_MAX_IOV buffers of a datagram queue, up to
+ * the next file, with a single sendmmsg(). Each buffer leaves whole as
+ * a datagram of its own and is popped; written is called with every
+ * one sent.
+ *
+ * Returns the number of bytes sent, or -1 on error
+ */
+long long send_queue_send_datagrams(send_queue *q, int fd, send_written written, void *data)
+{
+    struct mmsghdr msgs[SEND_QUEUE_MAX_IOV];
+    struct iovec iov[SEND_QUEUE_MAX_IOV];
+    send_buffer *b;
+    long long total;
+    int count, n, i;
+
+    memset(msgs, 0, sizeof(msgs));
+    for (b = q->head, count = 0;
+         (b != NULL) && (b->file == NULL) && (count < SEND_QUEUE_MAX_IOV);
+         b = b->next, count++)
+    {
+        iov[count].iov_base = b->data;
+        iov[count].iov_len = b->len;
+        msgs[count].msg_hdr.msg_iov = &iov[count];
+        msgs[count].msg_hdr.msg_iovlen = 1;
+    }
+
+    n = sendmmsg(fd, msgs, count, 0);
+    if (n < 0)
+    {
+        return -1;
+    }
+
+    total = 0;
+    for (i = 0; i < n; i++)
+    {
+        b = q->head;
+        written(b->data, msgs[i].msg_len, FALSE, data);
+        total += msgs[i].msg_len;
+        q->bytes -= b->len;
+        send_queue_pop(q);
+    }
+
+    return total;
+}
+
+/*
+ * Writes as much of the queue as the descriptor takes. written is
+ * called with every piece written, and file_sent with every file
+ * completed.
+ *
+ * Returns the number of bytes written, or -1 on error (errno tells the
+ * reason)
+ */
+long long send_queue_drain(send_queue *q, int fd, send_written written,
+                           send_file_sent file_sent, void *data)
+{
+    ssize_t n;
+    long long total;
+    int piece;
+    send_buffer *b;
+
+    total = 0;
+    while (q->head != NULL)
+    {
+        send_queue_set_cork(q, fd, TRUE);
+
+        if (q->datagrams && (q->head->file == NULL))
+        {
+            /* the datagrams sent are popped already */
+            n = send_queue_send_datagrams(q, fd, written, data);
+            if (n >= 0)
+            {
+                total += n;
+                continue;
+            }
+        }
+        else
+        {
+            n = send_queue_write(q, fd);
+        }
+        if (n < 0)
+        {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+            {
+                return total;
+            }
+            return -1;
+        }
+
+        if (q->head->file != NULL)
+        {
+            b = q->head;
+            written((b->file->map != NULL) ? b->file->map + b->file->sent - n : NULL,
+                    n, TRUE, data);
+            total += n;
+            q->bytes -= n;
+
+            if (b->file->sent == b->file->size)
+            {
+                file_sent(b->file, data);
+                send_queue_pop(q);
+            }
+            else if (n == 0)
+            {
+                /* the file shrank under us; send what is left */
+                q->bytes -= b->file->size - b->file->sent;
+                file_sent(b->file, data);
+                send_queue_pop(q);
+            }
+            continue;
+        }
+
+        /* consume the buffers written */
+        while (n > 0)
+        {
+            b = q->head;
+            piece = b->len - b->off;
+            if (piece > n)
+            {
+                piece = n;
+            }
+
+            written(b->data + b->off, piece, FALSE, data);
+            b->off += piece;
+            q->bytes -= piece;
+            n -= piece;
+            total += piece;
+
+            if (b->off == b->len)
+            {
+                send_queue_pop(q);
+            }
+        }
+    }
+
+    /* push out the last partial segment */
+    send_queue_set_cork(q, fd, FALSE);
+
+    return total;
+}
+
+/*
+ * Drops everything queued, closing the files.
+ */
+void send_queue_clear(send_queue *q)
+{
+    while (q->head != NULL)
+    {
+        send_queue_pop(q);
+    }
+    q->bytes = 0;
+}
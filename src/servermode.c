@@ -0,0 +1,659 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/network.h"
+#include "../include/eventloop.h"
+#include "../include/servermode.h"
+#include "../include/stats.h"
+
+/* the personality served, or SERVER_MODE_NONE */
+int server_mode = SERVER_MODE_NONE;
+
+/* open connections, and the number of connections ever accepted */
+server_conn **server_conns = NULL;
+int num_server_conns = 0;
+int server_conns_size = 0;
+int server_conns_accepted = 0;
+
+/* bytes moved by all connections, and when last reported */
+long long server_bytes_in = 0;
+long long server_bytes_out = 0;
+long long server_reported_in = 0;
+long long server_reported_out = 0;
+struct timeval server_last_report;
+int server_report_timer = -1;
+
+/* FALSE once the kernel turns down discarding with MSG_TRUNC */
+int sink_truncates = TRUE;
+
+/* every connection is read into this buffer; the chargen pattern is
+   repeated past its end, so that a buffer's worth of it starts at any
+   offset within the pattern */
+unsigned char server_buf[SERVER_BUFFER_SIZE];
+unsigned char *chargen_pattern = NULL;
+
+/*
+ * Parses the name of a server mode.
+ *
+ * Returns the mode, or -1 if there is no such mode
+ */
+int parse_server_mode(char *name)
+{
+    int mode;
+
+    for (mode = SERVER_MODE_ECHO; mode <= SERVER_MODE_SINK; mode++)
+    {
+        if (strcmp(name, server_mode_name(mode)) == 0)
+        {
+            return mode;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Returns the name of a server mode.
+ */
+char *server_mode_name(int mode)
+{
+    switch (mode)
+    {
+    case SERVER_MODE_ECHO:
+        return "echo";
+    case SERVER_MODE_DISCARD:
+        return "discard";
+    case SERVER_MODE_CHARGEN:
+        return "chargen";
+    case SERVER_MODE_SINK:
+        return "sink";
+    }
+
+    return "none";
+}
+
+/*
+ * Builds the chargen pattern.
+ *
+ * Returns 0 on success, -1 if out of memory
+ */
+int init_chargen_pattern()
+{
+    int i, line, col;
+    unsigned char *p;
+
+    chargen_pattern = (unsigned char *)malloc(CHARGEN_PATTERN_SIZE +
+                                              SERVER_BUFFER_SIZE);
+    if (chargen_pattern == NULL)
+    {
+        return -1;
+    }
+
+    p = chargen_pattern;
+    for (line = 0; line < CHARGEN_LINES; line++)
+    {
+        for (col = 0; col < CHARGEN_LINE_LENGTH; col++)
+        {
+            *p++ = ' ' + (line + col) % CHARGEN_LINES;
+        }
+        *p++ = '\r';
+        *p++ = '\n';
+    }
+
+    for (i = CHARGEN_PATTERN_SIZE; i < CHARGEN_PATTERN_SIZE + SERVER_BUFFER_SIZE; i++)
+    {
+        chargen_pattern[i] = chargen_pattern[i % CHARGEN_PATTERN_SIZE];
+    }
+
+    return 0;
+}
+
+/*
+ * Creates a connection for a socket and adds it to the open ones.
+ *
+ * Returns the connection, or NULL if out of memory
+ */
+server_conn *server_conn_create(int sockfd)
+{
+    server_conn *c, **conns;
+    int size;
+
+    if (num_server_conns == server_conns_size)
+    {
+        size = (server_conns_size == 0) ? 16 : server_conns_size * 2;
+        conns = (server_conn **)realloc(server_conns, size * sizeof(server_conn *));
+        if (conns == NULL)
+        {
+            return NULL;
+        }
+        server_conns = conns;
+        server_conns_size = size;
+    }
+
+    c = (server_conn *)malloc(sizeof(server_conn));
+    if (c == NULL)
+    {
+        return NULL;
+    }
+
+    memset(c, 0, sizeof(server_conn));
+    c->id = ++server_conns_accepted;
+    c->sockfd = sockfd;
+    gettimeofday(&c->started, NULL);
+
+    if (socket_type == SOCKTYPE_TCP)
+    {
+        get_peer_name(sockfd, c->name, SERVER_CONN_NAME_SIZE);
+    }
+    else
+    {
+        snprintf(c->name, SERVER_CONN_NAME_SIZE, "UDP clients");
+    }
+
+    server_conns[num_server_conns++] = c;
+
+    return c;
+}
+
+/*
+ * Frees a connection, closing its socket.
+ */
+void server_conn_destroy(server_conn *c)
+{
+    int i;
+
+    for (i = 0; i < num_server_conns; i++)
+    {
+        if (server_conns[i] == c)
+        {
+            server_conns[i] = server_conns[--num_server_conns];
+            break;
+        }
+    }
+
+    event_remove(c->sockfd);
+    close(c->sockfd);
+
+    if (c->pending != NULL)
+    {
+        free(c->pending);
+    }
+    free(c);
+}
+
+/*
+ * Closes a connection, reporting what it moved and how fast.
+ */
+void server_conn_close(server_conn *c, char *reason)
+{
+    char msg[512], in[16], out[16], in_rate[24], out_rate[24];
+    long long usec;
+
+    usec = usec_since(&c->started);
+    format_size(c->bytes_in, in);
+    format_size(c->bytes_out, out);
+    format_rate(c->bytes_in, usec, in_rate);
+    format_rate(c->bytes_out, usec, out_rate);
+
+    sprintf(msg, "#%d %s %s after %.1fs: %s in at %s, %s out at %s\n",
+            c->id, c->name, reason, usec / 1000000.0,
+            in, in_rate, out, out_rate);
+    write_info_wnd(msg);
+
+    server_conn_destroy(c);
+}
+
+/*
+ * Closes a connection after a failed read or write; the call would
+ * block unless errno says otherwise.
+ *
+ * Returns TRUE if the connection was closed
+ */
+int server_conn_failed(server_conn *c)
+{
+    char reason[256];
+
+    if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+    {
+        return FALSE;
+    }
+
+    stats_errors++;
+    snprintf(reason, sizeof(reason), "failed (%s)", strerror(errno));
+    server_conn_close(c, reason);
+
+    return TRUE;
+}
+
+/*
+ * Writes the echoed bytes a connection could not take earlier. Once
+ * they are all gone, reading resumes.
+ *
+ * Returns -1 if the connection was closed, otherwise 0
+ */
+int write_pending(server_conn *c)
+{
+    ssize_t n;
+
+    n = send(c->sockfd, c->pending + c->pending_off, c->pending_len, MSG_NOSIGNAL);
+    if (n < 0)
+    {
+        return server_conn_failed(c) ? -1 : 0;
+    }
+
+    c->bytes_out += n;
+    server_bytes_out += n;
+    stats_count(&stats_out, n);
+    c->pending_off += n;
+    c->pending_len -= n;
+
+    if (c->pending_len == 0)
+    {
+        c->pending_off = 0;
+        event_modify(c->sockfd, EVENT_READ);
+    }
+
+    return 0;
+}
+
+/*
+ * Echoes bytes read from a connection. What the socket does not take
+ * right away is kept, and reading stops until it is written.
+ */
+void echo_bytes(server_conn *c, int n)
+{
+    ssize_t sent;
+
+    sent = send(c->sockfd, server_buf, n, MSG_NOSIGNAL);
+    if (sent < 0)
+    {
+        if (server_conn_failed(c))
+        {
+            return;
+        }
+        sent = 0;
+    }
+
+    c->bytes_out += sent;
+    server_bytes_out += sent;
+    stats_count(&stats_out, sent);
+
+    if (sent == n)
+    {
+        return;
+    }
+
+    if (c->pending == NULL)
+    {
+        c->pending = (unsigned char *)malloc(SERVER_BUFFER_SIZE);
+        if (c->pending == NULL)
+        {
+            server_conn_close(c, "out of memory");
+            return;
+        }
+    }
+
+    memcpy(c->pending, server_buf + sent, n - sent);
+    c->pending_off = 0;
+    c->pending_len = n - sent;
+    event_modify(c->sockfd, EVENT_WRITE);
+}
+
+/*
+ * Reads from a connection: into the buffer, or for a sink, straight
+ * into the void where the kernel allows it.
+ *
+ * Returns the number of bytes read, or -1 on error
+ */
+ssize_t read_conn(server_conn *c)
+{
+    ssize_t n;
+
+    if ((server_mode == SERVER_MODE_SINK) && sink_truncates)
+    {
+        n = recv(c->sockfd, NULL, SINK_DISCARD_SIZE, MSG_TRUNC);
+        if ((n >= 0) || ((errno != EINVAL) && (errno != EOPNOTSUPP) &&
+                         (errno != EFAULT)))
+        {
+            return n;
+        }
+
+        sink_truncates = FALSE;
+    }
+
+    return read(c->sockfd, server_buf, SERVER_BUFFER_SIZE);
+}
+
+/*
+ * Sends the next piece of the chargen pattern to a connection.
+ *
+ * Returns -1 if the connection was closed, otherwise 0
+ */
+int write_chargen(server_conn *c)
+{
+    ssize_t n;
+
+    n = send(c->sockfd, chargen_pattern + c->chargen_off, SERVER_BUFFER_SIZE,
+             MSG_NOSIGNAL);
+    if (n < 0)
+    {
+        return server_conn_failed(c) ? -1 : 0;
+    }
+
+    c->bytes_out += n;
+    server_bytes_out += n;
+    stats_count(&stats_out, n);
+    c->chargen_off = (c->chargen_off + n) % CHARGEN_PATTERN_SIZE;
+
+    return 0;
+}
+
+/*
+ * Event callback of a TCP connection.
+ */
+void handle_conn_event(int fd, int events, void *data)
+{
+    server_conn *c = (server_conn *)data;
+    ssize_t n;
+
+    if (events & EVENT_WRITE)
+    {
+        if (server_mode == SERVER_MODE_CHARGEN)
+        {
+            if (write_chargen(c) == -1)
+            {
+                return;
+            }
+        }
+        else if (c->pending_len > 0)
+        {
+            if (write_pending(c) == -1)
+            {
+                return;
+            }
+        }
+    }
+
+    /* an echo with bytes still unsent waits for them to go first */
+    if (!(events & EVENT_READ) || (c->pending_len > 0))
+    {
+        return;
+    }
+
+    n = read_conn(c);
+    if (n < 0)
+    {
+        server_conn_failed(c);
+        return;
+    }
+
+    if (n == 0)
+    {
+        server_conn_close(c, "closed");
+        return;
+    }
+
+    c->bytes_in += n;
+    server_bytes_in += n;
+    stats_count(&stats_in, n);
+
+    if (server_mode == SERVER_MODE_ECHO)
+    {
+        echo_bytes(c, n);
+    }
+}
+
+/*
+ * Event callback of a UDP server socket: serves the datagrams waiting,
+ * replying to their senders as the mode says.
+ */
+void handle_udp_event(int fd, int events, void *data)
+{
+    server_conn *c = (server_conn *)data;
+    struct sockaddr_in addr;
+    socklen_t addr_len;
+    ssize_t n, sent;
+    int i, len;
+
+    for (i = 0; i < SERVER_DATAGRAMS_PER_EVENT; i++)
+    {
+        addr_len = sizeof(addr);
+        if (server_mode == SERVER_MODE_SINK)
+        {
+            /* tells the size without copying the datagram */
+            n = recvfrom(fd, NULL, 0, MSG_TRUNC, (struct sockaddr *)&addr, &addr_len);
+        }
+        else
+        {
+            n = recvfrom(fd, server_buf, SERVER_BUFFER_SIZE, 0,
+                         (struct sockaddr *)&addr, &addr_len);
+        }
+
+        if (n < 0)
+        {
+            return;
+        }
+
+        c->bytes_in += n;
+        server_bytes_in += n;
+        stats_count(&stats_in, n);
+
+        /* replies are best effort, like the datagrams themselves */
+        sent = -1;
+        if (server_mode == SERVER_MODE_ECHO)
+        {
+            sent = sendto(fd, server_buf, n, 0, (struct sockaddr *)&addr, addr_len);
+        }
+        else if (server_mode == SERVER_MODE_CHARGEN)
+        {
+            len = rand() % (CHARGEN_DATAGRAM_MAX + 1);
+            sent = sendto(fd, chargen_pattern + c->chargen_off, len, 0,
+                          (struct sockaddr *)&addr, addr_len);
+            c->chargen_off = (c->chargen_off + CHARGEN_LINE_LENGTH + 2) %
+                CHARGEN_PATTERN_SIZE;
+        }
+
+        if (sent > 0)
+        {
+            c->bytes_out += sent;
+            server_bytes_out += sent;
+            stats_count(&stats_out, sent);
+        }
+    }
+}
+
+/*
+ * Accepts the connections waiting on the server socket.
+ */
+void handle_server_accept(int fd, int events, void *data)
+{
+    server_conn *c;
+    int sockfd, watch;
+    char msg[512];
+
+    watch = (server_mode == SERVER_MODE_CHARGEN) ?
+        (EVENT_READ | EVENT_WRITE) : EVENT_READ;
+
+    while ((sockfd = accept_pending_connection(fd)) != -1)
+    {
+        if ((set_nonblocking(sockfd) == -1) ||
+            ((c = server_conn_create(sockfd)) == NULL))
+        {
+            close(sockfd);
+            continue;
+        }
+
+        if (event_add(sockfd, watch, handle_conn_event, c) == -1)
+        {
+            server_conn_destroy(c);
+            continue;
+        }
+
+        sprintf(msg, "#%d %s connected\n", c->id, c->name);
+        write_info_wnd(msg);
+    }
+}
+
+/*
+ * Timer callback: reports the throughput since the last report, in
+ * total and, while there are only a few, per connection.
+ */
+void report_throughput(int fd, int events, void *data)
+{
+    char msg[512], in_rate[24], out_rate[24], in[16], out[16];
+    long long usec;
+    server_conn *c;
+    int i;
+
+    event_set_timer(server_report_timer, SERVER_REPORT_INTERVAL);
+
+    if ((server_bytes_in == server_reported_in) &&
+        (server_bytes_out == server_reported_out))
+    {
+        gettimeofday(&server_last_report, NULL);
+        return;
+    }
+
+    usec = usec_since(&server_last_report);
+    gettimeofday(&server_last_report, NULL);
+
+    format_rate(server_bytes_in - server_reported_in, usec, in_rate);
+    format_rate(server_bytes_out - server_reported_out, usec, out_rate);
+    format_size(server_bytes_in, in);
+    format_size(server_bytes_out, out);
+    sprintf(msg, "%s: %d open, in %s, out %s (total %s in, %s out)\n",
+            server_mode_name(server_mode), num_server_conns,
+            in_rate, out_rate, in, out);
+    write_info_wnd(msg);
+
+    server_reported_in = server_bytes_in;
+    server_reported_out = server_bytes_out;
+
+    for (i = 0; i < num_server_conns; i++)
+    {
+        c = server_conns[i];
+
+        if ((num_server_conns > 1) && (num_server_conns <= SERVER_REPORT_CONNECTIONS))
+        {
+            format_rate(c->bytes_in - c->reported_in, usec, in_rate);
+            format_rate(c->bytes_out - c->reported_out, usec, out_rate);
+            sprintf(msg, "  #%d %s: in %s, out %s\n", c->id, c->name, in_rate, out_rate);
+            write_info_wnd(msg);
+        }
+
+        c->reported_in = c->bytes_in;
+        c->reported_out = c->bytes_out;
+    }
+}
+
+/*
+ * Starts serving a socket in the given mode: a TCP server socket gets
+ * its connections accepted, a UDP socket is served as it is.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int server_mode_start(int mode, int sockfd)
+{
+    server_conn *c;
+    char msg[512];
+
+    server_mode = mode;
+
+    if ((mode == SERVER_MODE_CHARGEN) && (init_chargen_pattern() == -1))
+    {
+        write_info_wnd("out of memory for the chargen pattern\n");
+        return -1;
+    }
+
+    if (socket_type == SOCKTYPE_TCP)
+    {
+        if (event_add(sockfd, EVENT_READ, handle_server_accept, NULL) == -1)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        if (((c = server_conn_create(sockfd)) == NULL) ||
+            (event_add(sockfd, EVENT_READ, handle_udp_event, c) == -1))
+        {
+            return -1;
+        }
+    }
+
+    if ((server_report_timer = event_add_timer(report_throughput, NULL)) == -1)
+    {
+        return -1;
+    }
+    event_set_timer(server_report_timer, SERVER_REPORT_INTERVAL);
+    gettimeofday(&server_last_report, NULL);
+
+    /* the bytes served are not displayed */
+    sprintf(msg, "%s server", server_mode_name(mode));
+    show_views(NULL, NULL, msg);
+
+    sprintf(msg, "Serving %s over %s, using %s\n", server_mode_name(mode),
+            socket_type_names[socket_type], event_backend_name());
+    write_info_wnd(msg);
+
+    return 0;
+}
+
+/*
+ * Closes the connections and frees the server mode state.
+ */
+void server_mode_stop()
+{
+    while (num_server_conns > 0)
+    {
+        server_conn_destroy(server_conns[0]);
+    }
+
+    if (server_conns != NULL)
+    {
+        free(server_conns);
+        server_conns = NULL;
+    }
+    server_conns_size = 0;
+
+    if (chargen_pattern != NULL)
+    {
+        free(chargen_pattern);
+        chargen_pattern = NULL;
+    }
+}
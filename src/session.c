@@ -0,0 +1,183 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/formatters.h"
+#include "../include/history.h"
+#include "../include/viewport.h"
+#include "../include/network.h"
+#include "../include/sendqueue.h"
+#include "../include/session.h"
+#include "../include/capture.h"
+
+/* all sessions in order of creation, and the one shown */
+session **sessions = NULL;
+int num_sessions = 0;
+int sessions_size = 0;
+session *active_session = NULL;
+
+/*
+ * Creates a session for a connected socket. Each direction gets a
+ * history of at most history_size resident bytes, shown in the
+ * default formats. A TCP send queue corks the socket if cork is set.
+ *
+ * Returns the session, or NULL if out of memory
+ */
+session *session_create(int sockfd, long long history_size, int cork)
+{
+    session *s;
+
+    s = (session *)malloc(sizeof(session));
+    if (s == NULL)
+    {
+        return NULL;
+    }
+
+    memset(s, 0, sizeof(session));
+    s->sockfd = sockfd;
+    s->open = TRUE;
+    get_peer_name(sockfd, s->name, SESSION_NAME_SIZE);
+    send_queue_init(&s->queue, socket_type == SOCKTYPE_UDP, cork);
+
+    s->in_history = history_create(history_size);
+    s->out_history = history_create(history_size);
+    if ((s->in_history == NULL) || (s->out_history == NULL))
+    {
+        session_destroy(s);
+        return NULL;
+    }
+
+    viewport_set_history(&s->in_view, s->in_history, sock_in_format,
+                         socket_type == SOCKTYPE_UDP);
+    viewport_set_history(&s->out_view, s->out_history, sock_out_format,
+                         socket_type == SOCKTYPE_UDP);
+
+    return s;
+}
+
+/*
+ * Closes the socket of a session, dropping what is still queued for
+ * sending. The histories are kept for viewing.
+ */
+void session_close(session *s)
+{
+    send_queue_clear(&s->queue);
+
+    if (s->open)
+    {
+        close(s->sockfd);
+        s->open = FALSE;
+        capture_write(CAPTURE_CLOSE, s->id, NULL, 0);
+    }
+}
+
+/*
+ * Closes a session and frees it.
+ */
+void session_destroy(session *s)
+{
+    if (s == NULL)
+    {
+        return;
+    }
+
+    session_close(s);
+    history_destroy(s->in_history);
+    history_destroy(s->out_history);
+    free(s);
+}
+
+/*
+ * Adds a session to the session list and numbers it.
+ *
+ * Returns 0 on success, -1 if out of memory
+ */
+int session_register(session *s)
+{
+    session **tmp;
+    int size;
+
+    if (num_sessions == sessions_size)
+    {
+        size = (sessions_size > 0) ? sessions_size * 2 : 8;
+        tmp = (session **)realloc(sessions, size * sizeof(session *));
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+
+        sessions = tmp;
+        sessions_size = size;
+    }
+
+    sessions[num_sessions++] = s;
+    s->id = num_sessions;
+
+    return 0;
+}
+
+/*
+ * Returns the session after the given one in the session list,
+ * wrapping around, or the first one if s is NULL.
+ */
+session *session_following(session *s)
+{
+    if (num_sessions == 0)
+    {
+        return NULL;
+    }
+
+    if ((s == NULL) || (s->id >= num_sessions))
+    {
+        return sessions[0];
+    }
+
+    return sessions[s->id];
+}
+
+/*
+ * Destroys all sessions.
+ */
+void destroy_sessions()
+{
+    int i;
+
+    for (i = 0; i < num_sessions; i++)
+    {
+        session_destroy(sessions[i]);
+    }
+
+    free(sessions);
+    sessions = NULL;
+    num_sessions = sessions_size = 0;
+    active_session = NULL;
+}
@@ -0,0 +1,184 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/network.h"
+#include "../include/eventloop.h"
+#include "../include/capture.h"
+#include "../include/stats.h"
+
+/* traffic received and sent, over all connections */
+stats_direction stats_in;
+stats_direction stats_out;
+
+/* connections and transfers broken off by errors */
+long long stats_errors = 0;
+
+/* the timer taking the samples, the number of samples taken (up to
+   STATS_SAMPLES) and where the next one goes */
+int stats_timer = -1;
+int stats_taken = 0;
+int stats_next = 0;
+
+/* the windows the rates are shown for, in seconds */
+int stats_windows[] = { 1, 10, 60 };
+
+/*
+ * Counts a read or a send of n bytes. Called on the hot path, so it
+ * only adds; the rest is done once per STATS_INTERVAL.
+ */
+void stats_count(stats_direction *d, int n)
+{
+    d->bytes += n;
+    d->calls++;
+}
+
+/*
+ * Samples the totals of a direction into the slot of the next sample.
+ */
+void stats_sample_direction(stats_direction *d, uint64_t now)
+{
+    stats_sample *last;
+
+    if (stats_taken > 0)
+    {
+        last = &d->samples[(stats_next + STATS_SAMPLES - 1) % STATS_SAMPLES];
+        if (d->calls != last->calls)
+        {
+            d->active_ns = now;
+        }
+    }
+
+    d->samples[stats_next].ns = now;
+    d->samples[stats_next].bytes = d->bytes;
+    d->samples[stats_next].calls = d->calls;
+}
+
+/*
+ * Formats the totals of a direction, its rates over the windows, and
+ * whether anything has moved lately, into a buffer of at least 256
+ * bytes.
+ */
+void stats_format(stats_direction *d, char *name, char *calls, uint64_t now, char *s)
+{
+    stats_sample *newest, *oldest;
+    char size[16], rate[24];
+    int i, back, len;
+    double secs;
+
+    format_size(d->bytes, size);
+    len = sprintf(s, "%-3s %s in %lld %s", name, size, d->calls, calls);
+
+    newest = &d->samples[(stats_next + STATS_SAMPLES - 1) % STATS_SAMPLES];
+    for (i = 0; i < sizeof(stats_windows) / sizeof(int); i++)
+    {
+        /* until there are enough samples, the window is what there is */
+        back = stats_windows[i];
+        if (back > stats_taken - 1)
+        {
+            back = stats_taken - 1;
+        }
+        if (back <= 0)
+        {
+            len += sprintf(s + len, " | %ds -", stats_windows[i]);
+            continue;
+        }
+
+        oldest = &d->samples[(stats_next + STATS_SAMPLES - 1 - back) % STATS_SAMPLES];
+        secs = (newest->ns - oldest->ns) / 1e9;
+        format_size((long long)((newest->bytes - oldest->bytes) / secs), rate);
+        len += sprintf(s + len, " | %ds %s/s %.0f/s", stats_windows[i], rate,
+                       (newest->calls - oldest->calls) / secs);
+    }
+
+    if (d->active_ns == 0)
+    {
+        sprintf(s + len, " | none yet");
+    }
+    else if (now - d->active_ns < 2 * STATS_INTERVAL * 1000ULL)
+    {
+        sprintf(s + len, " | active");
+    }
+    else
+    {
+        sprintf(s + len, " | idle %.0fs", (now - d->active_ns) / 1e9);
+    }
+}
+
+/*
+ * Timer callback: samples the totals and redraws the stats pane.
+ */
+void update_stats(int fd, int events, void *data)
+{
+    char line[256];
+    uint64_t now;
+    int udp;
+
+    if (fd != -1)
+    {
+        event_set_timer(stats_timer, STATS_INTERVAL);
+    }
+
+    now = capture_clock_ns(CLOCK_MONOTONIC);
+    stats_sample_direction(&stats_in, now);
+    stats_sample_direction(&stats_out, now);
+    stats_next = (stats_next + 1) % STATS_SAMPLES;
+    if (stats_taken < STATS_SAMPLES)
+    {
+        stats_taken++;
+    }
+
+    udp = (socket_type == SOCKTYPE_UDP);
+    stats_format(&stats_in, "in", udp ? "datagrams" : "reads", now, line);
+    write_stats_wnd(0, line);
+    stats_format(&stats_out, "out", udp ? "datagrams" : "sends", now, line);
+    write_stats_wnd(1, line);
+}
+
+/*
+ * Starts sampling the totals and showing them in the stats pane.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int stats_start()
+{
+    if ((stats_timer = event_add_timer(update_stats, NULL)) == -1)
+    {
+        return -1;
+    }
+    event_set_timer(stats_timer, STATS_INTERVAL);
+
+    /* the first sample, which the rates of the next ones start from */
+    update_stats(-1, 0, NULL);
+
+    return 0;
+}
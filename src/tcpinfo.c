@@ -0,0 +1,173 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/tcp.h>
+#include <linux/sockios.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/network.h"
+#include "../include/formatters.h"
+#include "../include/history.h"
+#include "../include/viewport.h"
+#include "../include/sendqueue.h"
+#include "../include/session.h"
+#include "../include/eventloop.h"
+#include "../include/histogram.h"
+#include "../include/throughput.h"
+#include "../include/tcpinfo.h"
+
+/* the timer polling the connection */
+int tcpinfo_timer = -1;
+
+/*
+ * Returns the connection whose state is shown: that of the session in
+ * view, or the one measured by the throughput test. -1 if there is
+ * none.
+ */
+int tcpinfo_socket()
+{
+    if ((active_session != NULL) && active_session->open)
+    {
+        return active_session->sockfd;
+    }
+
+    if (throughput_mode)
+    {
+        return throughput_sockfd;
+    }
+
+    return -1;
+}
+
+/*
+ * Formats the TCP state of a connection: the round trip time and its
+ * variance, the congestion window, retransmissions (of the segment
+ * being retransmitted now, and in total), segments not yet
+ * acknowledged, the pacing rate, and the bytes in the send and
+ * receive queues. The buffer must be at least 256 bytes.
+ */
+void tcpinfo_format(int sockfd, char *s)
+{
+    struct tcp_info ti;
+    socklen_t len;
+    int sendq, recvq, n;
+    char rtt[16], rttvar[16], pacing[16], sent[16], received[16];
+
+    memset(&ti, 0, sizeof(ti));
+    len = sizeof(ti);
+    if (getsockopt(sockfd, IPPROTO_TCP, TCP_INFO, &ti, &len) == -1)
+    {
+        sprintf(s, "tcp TCP_INFO failed (%s)", strerror(errno));
+        return;
+    }
+
+    format_latency(ti.tcpi_rtt * 1000ULL, rtt);
+    format_latency(ti.tcpi_rttvar * 1000ULL, rttvar);
+    n = sprintf(s, "tcp rtt %s var %s | cwnd %u | retrans %u/%u | unacked %u",
+                rtt, rttvar, ti.tcpi_snd_cwnd, ti.tcpi_retransmits,
+                ti.tcpi_total_retrans, ti.tcpi_unacked);
+
+    /* older kernels fill in less, and ~0 means no pacing */
+    if ((len >= offsetof(struct tcp_info, tcpi_pacing_rate) + sizeof(ti.tcpi_pacing_rate)) &&
+        (ti.tcpi_pacing_rate != ~0ULL))
+    {
+        format_size(ti.tcpi_pacing_rate, pacing);
+        n += sprintf(s + n, " | pacing %s/s", pacing);
+    }
+    else
+    {
+        n += sprintf(s + n, " | pacing -");
+    }
+
+    if ((ioctl(sockfd, SIOCOUTQ, &sendq) == 0) && (ioctl(sockfd, SIOCINQ, &recvq) == 0))
+    {
+        format_size(sendq, sent);
+        format_size(recvq, received);
+        sprintf(s + n, " | sendq %s recvq %s", sent, received);
+    }
+}
+
+/*
+ * Timer callback: polls the connection and shows its state in the
+ * stats pane.
+ */
+void update_tcpinfo(int fd, int events, void *data)
+{
+    char line[256];
+    int sockfd;
+
+    if (fd != -1)
+    {
+        event_set_timer(tcpinfo_timer, TCPINFO_INTERVAL);
+    }
+
+    /* a short terminal has no room for the row */
+    if (TCPINFO_ROW >= stats_wnd_rows)
+    {
+        return;
+    }
+
+    if ((sockfd = tcpinfo_socket()) == -1)
+    {
+        write_stats_wnd(TCPINFO_ROW, "tcp no connection");
+        return;
+    }
+
+    tcpinfo_format(sockfd, line);
+    write_stats_wnd(TCPINFO_ROW, line);
+}
+
+/*
+ * Starts polling the TCP state of the connection. Over UDP there is
+ * nothing to poll.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int tcpinfo_start()
+{
+    if (socket_type != SOCKTYPE_TCP)
+    {
+        return 0;
+    }
+
+    if ((tcpinfo_timer = event_add_timer(update_tcpinfo, NULL)) == -1)
+    {
+        return -1;
+    }
+    event_set_timer(tcpinfo_timer, TCPINFO_INTERVAL);
+    update_tcpinfo(-1, 0, NULL);
+
+    return 0;
+}
@@ -0,0 +1,475 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/network.h"
+#include "../include/eventloop.h"
+#include "../include/capture.h"
+#include "../include/throughput.h"
+#include "../include/stats.h"
+
+/* TRUE when measuring throughput */
+int throughput_mode = FALSE;
+
+/* the connection, whether this end sends, and how long it sends */
+int throughput_sockfd = -1;
+int throughput_sending;
+int throughput_state;
+double throughput_duration;
+
+/* bytes sent or received, in all and by the last report */
+long long throughput_bytes = 0;
+long long throughput_reported_bytes = 0;
+
+/* the sender starts the clock when it starts sending, the receiver
+   when the first byte arrives; the clock stops when the connection
+   closes */
+uint64_t throughput_started_ns = 0;
+uint64_t throughput_last_report_ns = 0;
+uint64_t throughput_ended_ns = 0;
+
+int throughput_report_timer = -1;
+int throughput_end_timer = -1;
+
+/* why the transfer broke off, or empty */
+char throughput_error[256];
+
+/* MSG_ZEROCOPY sends, and how many of them the kernel has reported
+   done, and done by copying after all */
+int throughput_zerocopy = FALSE;
+long long zerocopy_sends = 0;
+long long zerocopy_completed = 0;
+long long zerocopy_copied = 0;
+
+/* the sender sends this buffer over and over; it never changes, so
+   it may go out again while the pages of earlier zerocopy sends of
+   it are still in flight */
+unsigned char throughput_buf[THROUGHPUT_BUFFER_SIZE];
+
+/*
+ * Formats the goodput of moving bytes in ns nanoseconds in bits per
+ * second, into a buffer of at least 24 bytes.
+ */
+void format_goodput(long long bytes, uint64_t ns, char *s)
+{
+    double bits;
+
+    bits = (ns > 0) ? bytes * 8e9 / ns : 0;
+
+    if (bits >= 1e9)
+        sprintf(s, "%.2f Gbit/s", bits / 1e9);
+    else if (bits >= 1e6)
+        sprintf(s, "%.2f Mbit/s", bits / 1e6);
+    else if (bits >= 1e3)
+        sprintf(s, "%.2f Kbit/s", bits / 1e3);
+    else
+        sprintf(s, "%.0f bit/s", bits);
+}
+
+/*
+ * Ends the transfer, for the reason given, or NULL if it went fine.
+ */
+void throughput_end(char *error)
+{
+    if (throughput_ended_ns == 0)
+    {
+        throughput_ended_ns = capture_clock_ns(CLOCK_MONOTONIC);
+    }
+    if ((error != NULL) && (throughput_error[0] == '\0'))
+    {
+        stats_errors++;
+        snprintf(throughput_error, sizeof(throughput_error), "%s", error);
+    }
+
+    throughput_state = THROUGHPUT_DONE;
+    event_loop_stop();
+}
+
+/*
+ * Reads the completions of zerocopy sends from the error queue of
+ * the socket. Each one covers a range of sends, numbered in the
+ * order they were made.
+ */
+void throughput_reap()
+{
+#ifdef MSG_ZEROCOPY
+    unsigned char control[128];
+    struct sock_extended_err *serr;
+    struct cmsghdr *cm;
+    struct msghdr msg;
+    long long n;
+
+    while (TRUE)
+    {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(throughput_sockfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+        {
+            return;
+        }
+
+        for (cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm))
+        {
+            if ((cm->cmsg_level != SOL_IP) || (cm->cmsg_type != IP_RECVERR))
+            {
+                continue;
+            }
+
+            serr = (struct sock_extended_err *)CMSG_DATA(cm);
+            if ((serr->ee_errno != 0) || (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY))
+            {
+                continue;
+            }
+
+            n = (long long)serr->ee_data - serr->ee_info + 1;
+            zerocopy_completed += n;
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            {
+                zerocopy_copied += n;
+            }
+        }
+    }
+#endif
+}
+
+/*
+ * Sends the buffer as many times as the socket takes it, up to
+ * THROUGHPUT_BURST times.
+ */
+void throughput_send()
+{
+    int flags, i;
+    ssize_t n;
+
+    flags = MSG_NOSIGNAL;
+#ifdef MSG_ZEROCOPY
+    if (throughput_zerocopy)
+    {
+        flags |= MSG_ZEROCOPY;
+    }
+#endif
+
+    for (i = 0; i < THROUGHPUT_BURST; i++)
+    {
+        n = send(throughput_sockfd, throughput_buf, THROUGHPUT_BUFFER_SIZE, flags);
+        if (n < 0)
+        {
+            /* ENOBUFS: too many zerocopy sends wait for completion;
+               they are reaped when the socket wakes the loop again */
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR) &&
+                !(throughput_zerocopy && (errno == ENOBUFS)))
+            {
+                throughput_end(strerror(errno));
+            }
+            return;
+        }
+
+        throughput_bytes += n;
+        stats_count(&stats_out, n);
+        if (throughput_zerocopy)
+        {
+            zerocopy_sends++;
+        }
+    }
+}
+
+/*
+ * Reads what has arrived, up to THROUGHPUT_BURST times. The sender
+ * reads only to learn that the receiver has closed the connection.
+ */
+void throughput_receive()
+{
+    ssize_t n;
+    int i;
+
+    for (i = 0; i < THROUGHPUT_BURST; i++)
+    {
+        n = recv(throughput_sockfd, throughput_buf, THROUGHPUT_BUFFER_SIZE, 0);
+        if (n < 0)
+        {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+            {
+                throughput_end(strerror(errno));
+            }
+            return;
+        }
+
+        if (n == 0)
+        {
+            throughput_end((throughput_state == THROUGHPUT_SENDING) ?
+                           "connection closed by the receiver" : NULL);
+            return;
+        }
+
+        stats_count(&stats_in, n);
+        if (throughput_sending)
+        {
+            continue;
+        }
+
+        if (throughput_started_ns == 0)
+        {
+            throughput_started_ns = capture_clock_ns(CLOCK_MONOTONIC);
+            throughput_last_report_ns = throughput_started_ns;
+        }
+        throughput_bytes += n;
+    }
+}
+
+/*
+ * Event callback of the connection.
+ */
+void handle_throughput_event(int fd, int events, void *data)
+{
+    if (throughput_zerocopy)
+    {
+        throughput_reap();
+    }
+
+    if (events & EVENT_READ)
+    {
+        throughput_receive();
+    }
+
+    if ((events & EVENT_WRITE) && (throughput_state == THROUGHPUT_SENDING))
+    {
+        throughput_send();
+    }
+}
+
+/*
+ * Timer callback: reports the goodput since the last report.
+ */
+void report_goodput(int fd, int events, void *data)
+{
+    char msg[512], rate[24], moved[16], total[16];
+    uint64_t now;
+
+    event_set_timer(throughput_report_timer, THROUGHPUT_REPORT_INTERVAL);
+    if (throughput_started_ns == 0)
+    {
+        return;
+    }
+
+    now = capture_clock_ns(CLOCK_MONOTONIC);
+    format_goodput(throughput_bytes - throughput_reported_bytes,
+                   now - throughput_last_report_ns, rate);
+    format_size(throughput_bytes - throughput_reported_bytes, moved);
+    format_size(throughput_bytes, total);
+    sprintf(msg, "%s: %s (%s), %s in %.0fs\n",
+            throughput_sending ? "sent" : "received", rate, moved, total,
+            (now - throughput_started_ns) / 1e9);
+    write_info_wnd(msg);
+
+    throughput_reported_bytes = throughput_bytes;
+    throughput_last_report_ns = now;
+}
+
+/*
+ * Timer callback: the sender has sent for long enough, and closes its
+ * side of the connection. The transfer is complete once the receiver
+ * has read everything and closes the other side.
+ */
+void throughput_time_up(int fd, int events, void *data)
+{
+    if (throughput_state == THROUGHPUT_DRAINING)
+    {
+        throughput_end("the receiver did not close the connection");
+        return;
+    }
+
+    shutdown(throughput_sockfd, SHUT_WR);
+    throughput_state = THROUGHPUT_DRAINING;
+    event_modify(throughput_sockfd, EVENT_READ);
+    event_set_timer(throughput_end_timer, THROUGHPUT_DRAIN_USEC);
+    write_info_wnd("Waiting for the receiver to read everything\n");
+}
+
+/*
+ * Prepares measuring the throughput of a connection: the sending end
+ * sends for duration seconds, or THROUGHPUT_DEFAULT_DURATION if 0,
+ * and the receiving end reads until the connection closes.
+ */
+void throughput_open(int sockfd, int sending, double duration)
+{
+    throughput_mode = TRUE;
+    throughput_sockfd = sockfd;
+    throughput_sending = sending;
+    throughput_state = sending ? THROUGHPUT_SENDING : THROUGHPUT_RECEIVING;
+    throughput_duration = (duration > 0) ? duration : THROUGHPUT_DEFAULT_DURATION;
+    throughput_error[0] = '\0';
+}
+
+/*
+ * Starts the transfer. The sender turns on MSG_ZEROCOPY if the kernel
+ * has it.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int throughput_start()
+{
+    char msg[512], peer[64], sndbuf[16], rcvbuf[16], *zerocopy;
+    socklen_t len;
+    int one, size;
+
+    zerocopy = "";
+    if (throughput_sending)
+    {
+#ifdef SO_ZEROCOPY
+        one = 1;
+        throughput_zerocopy =
+            (setsockopt(throughput_sockfd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0);
+#endif
+        zerocopy = throughput_zerocopy ? ", MSG_ZEROCOPY" : ", MSG_ZEROCOPY not available";
+    }
+
+    if (event_add(throughput_sockfd,
+                  throughput_sending ? (EVENT_READ | EVENT_WRITE) : EVENT_READ,
+                  handle_throughput_event, NULL) == -1)
+    {
+        return -1;
+    }
+
+    if ((throughput_report_timer = event_add_timer(report_goodput, NULL)) == -1)
+    {
+        return -1;
+    }
+    event_set_timer(throughput_report_timer, THROUGHPUT_REPORT_INTERVAL);
+
+    if (throughput_sending)
+    {
+        if ((throughput_end_timer = event_add_timer(throughput_time_up, NULL)) == -1)
+        {
+            return -1;
+        }
+        event_set_timer(throughput_end_timer, (long)(throughput_duration * 1000000));
+
+        throughput_started_ns = capture_clock_ns(CLOCK_MONOTONIC);
+        throughput_last_report_ns = throughput_started_ns;
+    }
+
+    /* the bytes moved are not displayed */
+    get_peer_name(throughput_sockfd, peer, sizeof(peer));
+    sprintf(msg, "throughput %s %s", throughput_sending ? "to" : "from", peer);
+    show_views(NULL, NULL, msg);
+
+    len = sizeof(size);
+    getsockopt(throughput_sockfd, SOL_SOCKET, SO_SNDBUF, &size, &len);
+    format_size(size, sndbuf);
+    len = sizeof(size);
+    getsockopt(throughput_sockfd, SOL_SOCKET, SO_RCVBUF, &size, &len);
+    format_size(size, rcvbuf);
+
+    if (throughput_sending)
+    {
+        sprintf(msg, "Sending to %s for %gs, send buffer %s, receive buffer %s%s\n",
+                peer, throughput_duration, sndbuf, rcvbuf, zerocopy);
+    }
+    else
+    {
+        sprintf(msg, "Receiving from %s until it closes, send buffer %s, "
+                     "receive buffer %s\n", peer, sndbuf, rcvbuf);
+    }
+    write_info_wnd(msg);
+
+    return 0;
+}
+
+/*
+ * Closes the connection. The counts are kept for the final report.
+ */
+void throughput_stop()
+{
+    if (!throughput_mode || (throughput_sockfd == -1))
+    {
+        return;
+    }
+
+    if (throughput_ended_ns == 0)
+    {
+        throughput_ended_ns = capture_clock_ns(CLOCK_MONOTONIC);
+    }
+
+    if (throughput_zerocopy)
+    {
+        throughput_reap();
+    }
+    close(throughput_sockfd);
+    throughput_sockfd = -1;
+}
+
+/*
+ * Prints the final report of a transfer to stdout. The goodput of the
+ * sender counts to the receiver closing the connection, when all the
+ * bytes sent have been read.
+ *
+ * Returns 0 if the transfer went fine, 1 if it broke off or moved
+ * nothing
+ */
+int throughput_print_report()
+{
+    char moved[16], rate[24];
+    uint64_t ns;
+
+    if (!throughput_mode)
+    {
+        return 0;
+    }
+
+    ns = (throughput_started_ns > 0) ? throughput_ended_ns - throughput_started_ns : 0;
+    format_size(throughput_bytes, moved);
+    format_goodput(throughput_bytes, ns, rate);
+    printf("throughput: %s %s in %.2fs, goodput %s\n",
+           throughput_sending ? "sent" : "received", moved, ns / 1e9, rate);
+
+    if (throughput_zerocopy)
+    {
+        printf("MSG_ZEROCOPY: %lld sends, %lld completed, %lld of them copied after all\n",
+               zerocopy_sends, zerocopy_completed, zerocopy_copied);
+    }
+
+    if (throughput_error[0] != '\0')
+    {
+        printf("throughput: %s\n", throughput_error);
+        return 1;
+    }
+
+    return (throughput_bytes == 0) ? 1 : 0;
+}
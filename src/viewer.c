@@ -0,0 +1,614 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/curses.h"
+#include "../include/formatters.h"
+#include "../include/history.h"
+#include "../include/viewport.h"
+#include "../include/sendqueue.h"
+#include "../include/session.h"
+#include "../include/capture.h"
+#include "../include/viewer.h"
+
+/* TRUE when browsing a capture instead of a connection */
+int view_mode = FALSE;
+
+/* the mapped capture */
+unsigned char *view_map = NULL;
+size_t view_map_size = 0;
+
+/* the recorded sessions by id */
+view_session **view_sessions = NULL;
+int view_sessions_size = 0;
+
+/*
+ * Returns the stream offset of an index entry for a direction.
+ */
+static long long entry_offset(view_stream *st, int i)
+{
+    return (st->type == CAPTURE_IN) ? st->vs->index[i].in_off : st->vs->index[i].out_off;
+}
+
+/*
+ * Returns the last index entry of a direction at or before offset.
+ */
+static int find_entry(view_stream *st, long long offset)
+{
+    int lo, hi, mid;
+
+    lo = 0;
+    hi = st->vs->num_index - 1;
+    while (lo < hi)
+    {
+        mid = (lo + hi + 1) / 2;
+        if (entry_offset(st, mid) <= offset)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    return lo;
+}
+
+/* view_source adapters */
+static long long view_stream_start(void *ctx)
+{
+    return 0;
+}
+
+static long long view_stream_end(void *ctx)
+{
+    return ((view_stream *)ctx)->bytes;
+}
+
+/*
+ * Reads bytes of a recorded stream: the records from the nearest index
+ * entry on are walked until the range has been copied.
+ */
+static int view_stream_read(void *ctx, long long offset, unsigned char *buf, int len)
+{
+    view_stream *st = (view_stream *)ctx;
+    capture_record *rec;
+    long long pos, skip;
+    size_t off;
+    int i, n, copied;
+
+    if ((offset >= st->bytes) || (len <= 0))
+    {
+        return 0;
+    }
+
+    i = find_entry(st, offset);
+    pos = entry_offset(st, i);
+    off = st->vs->index[i].file_off;
+    copied = 0;
+
+    while ((copied < len) && ((rec = capture_next(view_map, view_map_size, &off)) != NULL))
+    {
+        if ((rec->session != st->vs->id) || (rec->type != st->type))
+        {
+            continue;
+        }
+
+        if (pos + rec->length > offset + copied)
+        {
+            skip = offset + copied - pos;
+            n = rec->length - skip;
+            if (n > len - copied)
+            {
+                n = len - copied;
+            }
+            memcpy(buf + copied, (unsigned char *)(rec + 1) + skip, n);
+            copied += n;
+        }
+        pos += rec->length;
+    }
+
+    return copied;
+}
+
+/*
+ * Returns the offset of the last linefeed in [from, to) of a stream,
+ * where from is the offset of index entry i, or -1 if there is none.
+ */
+static long long last_newline_in(view_stream *st, int i, long long to)
+{
+    capture_record *rec;
+    unsigned char *data, *nl;
+    long long pos, found;
+    size_t off;
+    int n;
+
+    pos = entry_offset(st, i);
+    off = st->vs->index[i].file_off;
+    found = -1;
+
+    while ((pos < to) && ((rec = capture_next(view_map, view_map_size, &off)) != NULL))
+    {
+        if ((rec->session != st->vs->id) || (rec->type != st->type))
+        {
+            continue;
+        }
+
+        data = (unsigned char *)(rec + 1);
+        n = (pos + rec->length > to) ? to - pos : rec->length;
+        if ((nl = memrchr(data, '\n', n)) != NULL)
+        {
+            found = pos + (nl - data);
+        }
+        pos += rec->length;
+    }
+
+    return found;
+}
+
+/*
+ * Returns where an index entry keeps the last linefeed before it in a
+ * direction.
+ */
+static long long *newline_slot(view_stream *st, int i)
+{
+    return (st->type == CAPTURE_IN) ? &st->vs->index[i].in_nl : &st->vs->index[i].out_nl;
+}
+
+/*
+ * Returns the offset of the last linefeed before index entry i. The
+ * answers are kept in the index, so that each stretch between two
+ * entries is searched at most once.
+ */
+static long long newline_before(view_stream *st, int i)
+{
+    long long nl, found;
+    int j;
+
+    /* the first entry starts the stream; find the nearest one that
+       knows */
+    j = i;
+    while ((j > 0) && (*newline_slot(st, j) == VIEW_NEWLINE_UNKNOWN))
+    {
+        j--;
+    }
+    nl = (j > 0) ? *newline_slot(st, j) : -1;
+
+    for (j++; j <= i; j++)
+    {
+        found = last_newline_in(st, j - 1, entry_offset(st, j));
+        if (found >= 0)
+        {
+            nl = found;
+        }
+        *newline_slot(st, j) = nl;
+    }
+
+    return nl;
+}
+
+static long long view_stream_prev_newline(void *ctx, long long offset)
+{
+    view_stream *st = (view_stream *)ctx;
+    long long nl;
+    int i;
+
+    if ((offset <= 0) || (st->vs->num_index == 0))
+    {
+        return -1;
+    }
+
+    i = find_entry(st, offset - 1);
+    nl = last_newline_in(st, i, offset);
+
+    return (nl >= 0) ? nl : newline_before(st, i);
+}
+
+/*
+ * Returns the recorded session with the given id, creating it if
+ * needed, or NULL if out of memory.
+ */
+static view_session *view_get_session(int id)
+{
+    view_session **tmp, *vs;
+    int size;
+
+    if (id >= view_sessions_size)
+    {
+        size = (view_sessions_size > 0) ? view_sessions_size : 16;
+        while (size <= id)
+        {
+            size *= 2;
+        }
+
+        tmp = (view_session **)realloc(view_sessions, size * sizeof(view_session *));
+        if (tmp == NULL)
+        {
+            return NULL;
+        }
+        memset(tmp + view_sessions_size, 0,
+               (size - view_sessions_size) * sizeof(view_session *));
+
+        view_sessions = tmp;
+        view_sessions_size = size;
+    }
+
+    if (view_sessions[id] == NULL)
+    {
+        vs = (view_session *)malloc(sizeof(view_session));
+        if (vs == NULL)
+        {
+            return NULL;
+        }
+
+        memset(vs, 0, sizeof(view_session));
+        vs->id = id;
+        vs->in.vs = vs;
+        vs->in.type = CAPTURE_IN;
+        vs->out.vs = vs;
+        vs->out.type = CAPTURE_OUT;
+        view_sessions[id] = vs;
+    }
+
+    return view_sessions[id];
+}
+
+/*
+ * Adds an index entry for a record of a session.
+ *
+ * Returns 0 on success, -1 if out of memory
+ */
+static int view_add_entry(view_session *vs, size_t file_off, capture_record *rec)
+{
+    view_index_entry *tmp, *e;
+    int size;
+
+    if (vs->num_index == vs->index_size)
+    {
+        size = (vs->index_size > 0) ? vs->index_size * 2 : 64;
+        tmp = (view_index_entry *)realloc(vs->index, size * sizeof(view_index_entry));
+        if (tmp == NULL)
+        {
+            return -1;
+        }
+
+        vs->index = tmp;
+        vs->index_size = size;
+    }
+
+    e = &vs->index[vs->num_index++];
+    e->file_off = file_off;
+    e->in_off = vs->in.bytes;
+    e->out_off = vs->out.bytes;
+    e->in_nl = VIEW_NEWLINE_UNKNOWN;
+    e->out_nl = VIEW_NEWLINE_UNKNOWN;
+    e->ts_ns = rec->timestamp_ns;
+
+    return 0;
+}
+
+/*
+ * Shows a recorded session as a closed session, its windows starting
+ * at the first bytes.
+ *
+ * Returns 0 on success, -1 if out of memory
+ */
+static int view_show_session(view_session *vs)
+{
+    view_source source;
+    session *s;
+
+    if ((s = session_create(-1, VIEW_HISTORY_SIZE, FALSE)) == NULL)
+    {
+        return -1;
+    }
+    s->open = FALSE;
+    snprintf(s->name, SESSION_NAME_SIZE, "%s", vs->name);
+
+    if (session_register(s) == -1)
+    {
+        session_destroy(s);
+        return -1;
+    }
+
+    source.start = view_stream_start;
+    source.end = view_stream_end;
+    source.read = view_stream_read;
+    source.prev_newline = view_stream_prev_newline;
+    source.find_record = NULL;
+
+    source.ctx = &vs->in;
+    viewport_init(&s->in_view, &source, sock_in_format);
+    viewport_jump(&s->in_view, 0);
+
+    source.ctx = &vs->out;
+    viewport_init(&s->out_view, &source, sock_out_format);
+    viewport_jump(&s->out_view, 0);
+
+    s->bytes_in = vs->in.bytes;
+    s->bytes_out = vs->out.bytes;
+
+    return 0;
+}
+
+/*
+ * Maps a capture log and indexes its sessions: one pass over the
+ * record headers, keeping an entry every VIEW_INDEX_SPAN bytes of the
+ * log per session. Each session is then shown as a session of its
+ * own.
+ *
+ * Returns 0 on success, -1 on error
+ */
+int view_open(char *path)
+{
+    capture_header *header;
+    capture_record *rec;
+    capture_endpoints *ends;
+    view_session *vs;
+    size_t off, rec_off;
+    int i, shown, len;
+
+    if ((view_map = capture_map_log(path, &view_map_size)) == NULL)
+    {
+        return -1;
+    }
+    header = (capture_header *)view_map;
+    madvise(view_map, view_map_size, MADV_SEQUENTIAL);
+
+    off = header->header_size;
+    rec_off = off;
+    while ((rec = capture_next(view_map, view_map_size, &off)) != NULL)
+    {
+        if ((vs = view_get_session(rec->session)) == NULL)
+        {
+            printf("out of memory for the capture index\n");
+            return -1;
+        }
+
+        switch (rec->type)
+        {
+        case CAPTURE_OPEN:
+            if (vs->opened_ns == 0)
+            {
+                vs->opened_ns = rec->timestamp_ns;
+            }
+            if (rec->length >= sizeof(capture_endpoints))
+            {
+                ends = (capture_endpoints *)(rec + 1);
+                len = rec->length - sizeof(capture_endpoints);
+                snprintf(vs->name, sizeof(vs->name), "%.*s", len, (char *)(ends + 1));
+            }
+            break;
+        case CAPTURE_IN:
+        case CAPTURE_OUT:
+            if (rec->length == 0)
+            {
+                break;
+            }
+            if (vs->opened_ns == 0)
+            {
+                vs->opened_ns = rec->timestamp_ns;
+            }
+
+            if (((vs->num_index == 0) ||
+                 (rec_off - vs->index[vs->num_index - 1].file_off >= VIEW_INDEX_SPAN)) &&
+                (view_add_entry(vs, rec_off, rec) == -1))
+            {
+                printf("out of memory for the capture index\n");
+                return -1;
+            }
+
+            if (rec->type == CAPTURE_IN)
+            {
+                vs->in.bytes += rec->length;
+            }
+            else
+            {
+                vs->out.bytes += rec->length;
+            }
+            break;
+        }
+
+        rec_off = off;
+    }
+
+    /* from here on only what is on screen is read */
+    madvise(view_map, view_map_size, MADV_RANDOM);
+
+    shown = 0;
+    for (i = 0; i < view_sessions_size; i++)
+    {
+        if (view_sessions[i] == NULL)
+        {
+            continue;
+        }
+
+        if (view_show_session(view_sessions[i]) == -1)
+        {
+            printf("out of memory for a session\n");
+            return -1;
+        }
+        shown++;
+    }
+
+    if (shown == 0)
+    {
+        printf("%s has no sessions\n", path);
+        return -1;
+    }
+
+    view_mode = TRUE;
+
+    return 0;
+}
+
+/*
+ * Frees the index and unmaps the capture.
+ */
+void view_close()
+{
+    int i;
+
+    for (i = 0; i < view_sessions_size; i++)
+    {
+        if (view_sessions[i] != NULL)
+        {
+            free(view_sessions[i]->index);
+            free(view_sessions[i]);
+        }
+    }
+    free(view_sessions);
+    view_sessions = NULL;
+    view_sessions_size = 0;
+
+    if (view_map != NULL)
+    {
+        munmap(view_map, view_map_size);
+        view_map = NULL;
+    }
+}
+
+/*
+ * Finds the stream offsets of a session at a time: the bytes of the
+ * records before it.
+ */
+static void view_offsets_at(view_session *vs, unsigned long long ts_ns,
+                     long long *in_off, long long *out_off)
+{
+    capture_record *rec;
+    size_t off;
+    int lo, hi, mid;
+
+    *in_off = 0;
+    *out_off = 0;
+    if (vs->num_index == 0)
+    {
+        return;
+    }
+
+    /* the last entry at or before the time */
+    lo = 0;
+    hi = vs->num_index - 1;
+    while (lo < hi)
+    {
+        mid = (lo + hi + 1) / 2;
+        if (vs->index[mid].ts_ns <= ts_ns)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    *in_off = vs->index[lo].in_off;
+    *out_off = vs->index[lo].out_off;
+    off = vs->index[lo].file_off;
+
+    while (((rec = capture_next(view_map, view_map_size, &off)) != NULL) &&
+           ((rec->session != vs->id) || (rec->timestamp_ns < ts_ns)))
+    {
+        if (rec->session != vs->id)
+        {
+            continue;
+        }
+
+        if (rec->type == CAPTURE_IN)
+        {
+            *in_off += rec->length;
+        }
+        else if (rec->type == CAPTURE_OUT)
+        {
+            *out_off += rec->length;
+        }
+    }
+}
+
+/*
+ * Runs a command typed in the info window while viewing a session:
+ * "t SECONDS" shows both windows as they were that long after the
+ * session was opened, "o OFFSET" moves the window PgUp/PgDn scroll to
+ * a byte offset.
+ */
+void view_command(viewport *in, viewport *out, char *line, int target_in)
+{
+    view_session *vs = ((view_stream *)in->source.ctx)->vs;
+    long long in_off, out_off, offset;
+    double seconds;
+    char msg[512], *end;
+
+    while (*line == ' ')
+    {
+        line++;
+    }
+
+    if (line[0] == 't')
+    {
+        seconds = strtod(line + 1, &end);
+        if ((end != line + 1) && (seconds >= 0))
+        {
+            view_offsets_at(vs, vs->opened_ns + (unsigned long long)(seconds * 1e9),
+                            &in_off, &out_off);
+            viewport_jump(in, in_off);
+            viewport_jump(out, out_off);
+            mark_dirty(DIRTY_SOCK_IN | DIRTY_SOCK_OUT | DIRTY_FRAMES);
+
+            sprintf(msg, "At +%.3fs: received offset %lld, sent offset %lld\n",
+                    seconds, in_off, out_off);
+            write_info_wnd(msg);
+            return;
+        }
+    }
+
+    if (line[0] == 'o')
+    {
+        offset = strtoll(line + 1, &end, 0);
+        if ((end != line + 1) && (offset >= 0))
+        {
+            viewport_jump(target_in ? in : out, offset);
+            mark_dirty(target_in ? DIRTY_SOCK_IN | DIRTY_FRAMES : DIRTY_SOCK_OUT | DIRTY_FRAMES);
+
+            sprintf(msg, "Bytes %s window at offset %lld\n",
+                    target_in ? "received" : "sent", offset);
+            write_info_wnd(msg);
+            return;
+        }
+    }
+
+    write_info_wnd("Type t SECONDS to go to a time since the session was opened, or\n"
+                   "o OFFSET to go to an offset in the window PgUp/PgDn scroll (F5)\n");
+}
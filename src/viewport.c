@@ -0,0 +1,393 @@
+/*
+The MIT License (MIT)
+
+PINT (Pint Is Not Telnet) - advanced debug tool for TCP/IP networks
+Copyright (C) 2002 Matti Dahlbom
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <ncurses.h>
+
+#include "../include/pint.h"
+#include "../include/formatters.h"
+#include "../include/history.h"
+#include "../include/viewport.h"
+
+/* history adapters for view_source */
+static long long history_source_start(void *ctx)
+{
+    return ((history *)ctx)->start;
+}
+
+static long long history_source_end(void *ctx)
+{
+    return ((history *)ctx)->end;
+}
+
+static int history_source_read(void *ctx, long long offset,
+                               unsigned char *buf, int len)
+{
+    return history_read((history *)ctx, offset, buf, len);
+}
+
+static long long history_source_prev_newline(void *ctx, long long offset)
+{
+    return history_prev_newline((history *)ctx, offset);
+}
+
+static history_record *history_source_find_record(void *ctx, long long offset)
+{
+    return history_find_record((history *)ctx, offset);
+}
+
+/*
+ * Initializes a viewport that follows the end of the given source.
+ */
+void viewport_init(viewport *vp, view_source *source, display_format *format)
+{
+    memset(vp, 0, sizeof(viewport));
+    vp->source = *source;
+    vp->format = format;
+    vp->rows = 1;
+    vp->cols = 1;
+    vp->follow = TRUE;
+}
+
+/*
+ * Initializes a viewport that shows a history, as datagrams if
+ * datagrams is TRUE.
+ */
+void viewport_set_history(viewport *vp, history *h, display_format *format,
+                          int datagrams)
+{
+    view_source source;
+
+    source.ctx = h;
+    source.start = history_source_start;
+    source.end = history_source_end;
+    source.read = history_source_read;
+    source.prev_newline = history_source_prev_newline;
+    source.find_record = datagrams ? history_source_find_record : NULL;
+
+    viewport_init(vp, &source, format);
+}
+
+/*
+ * Returns the number of columns the bytes of a line are shown in,
+ * besides the labels of datagrams.
+ */
+static int data_cols(viewport *vp)
+{
+    int cols;
+
+    cols = vp->cols;
+    if (vp->source.find_record != NULL)
+    {
+        cols -= VIEWPORT_LABEL_WIDTH;
+    }
+
+    return (cols > 0) ? cols : 1;
+}
+
+/*
+ * Returns the number of bytes on a full line in a fixed-width format.
+ */
+static int bytes_per_line(viewport *vp)
+{
+    int n;
+
+    n = data_cols(vp) / vp->format->cell_width;
+    return (n > 0) ? n : 1;
+}
+
+/*
+ * Finds the bytes the line holding offset is laid out within: its
+ * datagram, or the whole of a byte stream. The end of the range goes
+ * into limit.
+ *
+ * Returns the offset lines are counted from
+ */
+static long long line_range(viewport *vp, long long offset, long long *limit)
+{
+    history_record *r;
+
+    *limit = vp->source.end(vp->source.ctx);
+    if (vp->source.find_record == NULL)
+    {
+        return 0;
+    }
+
+    r = vp->source.find_record(vp->source.ctx, offset);
+    if (r == NULL)
+    {
+        /* past the last datagram, where only the next one goes */
+        return offset;
+    }
+
+    if (r->offset > offset)
+    {
+        /* bytes older than the datagrams indexed */
+        *limit = r->offset;
+        return vp->source.start(vp->source.ctx);
+    }
+
+    *limit = r->offset + r->len;
+    return r->offset;
+}
+
+/*
+ * Returns TRUE if lines are broken at linefeeds.
+ */
+static int breaks_at_newlines(viewport *vp)
+{
+    return vp->format->formatter == text_formatter;
+}
+
+/*
+ * Finds the start of the line that contains offset.
+ */
+long long viewport_line_start(viewport *vp, long long offset)
+{
+    long long start, base, limit, line_start;
+    int cols;
+
+    start = vp->source.start(vp->source.ctx);
+    if (offset <= start)
+    {
+        return start;
+    }
+
+    base = line_range(vp, offset, &limit);
+
+    if (breaks_at_newlines(vp))
+    {
+        line_start = vp->source.prev_newline(vp->source.ctx, offset) + 1;
+        if (line_start < base)
+        {
+            line_start = base;
+        }
+        if (line_start < start)
+        {
+            line_start = start;
+        }
+
+        cols = data_cols(vp);
+        return line_start + ((offset - line_start) / cols) * cols;
+    }
+
+    line_start = base + ((offset - base) / bytes_per_line(vp)) * bytes_per_line(vp);
+    return (line_start > start) ? line_start : start;
+}
+
+/*
+ * Returns the start of the line following the one starting at offset,
+ * or the end of the stream if the line is the last one.
+ */
+long long viewport_next_line(viewport *vp, long long offset)
+{
+    unsigned char buf[VIEWPORT_MAX_COLS];
+    unsigned char *nl;
+    long long base, limit, next;
+    int n, cols;
+
+    base = line_range(vp, offset, &limit);
+
+    if (breaks_at_newlines(vp))
+    {
+        cols = data_cols(vp);
+        n = vp->source.read(vp->source.ctx, offset, buf, cols);
+        nl = memchr(buf, '\n', n);
+        next = (nl != NULL) ? offset + (nl - buf) + 1 : offset + cols;
+    }
+    else
+    {
+        next = base + ((offset - base) / bytes_per_line(vp) + 1) * bytes_per_line(vp);
+    }
+
+    return (next < limit) ? next : limit;
+}
+
+/*
+ * Returns the start of the line preceding the one starting at offset.
+ */
+long long viewport_prev_line(viewport *vp, long long offset)
+{
+    if (offset <= vp->source.start(vp->source.ctx))
+    {
+        return offset;
+    }
+
+    return viewport_line_start(vp, offset - 1);
+}
+
+/*
+ * Returns the first visible line when following the end of the stream.
+ * The last line is the one the next byte will go to.
+ */
+static long long tail_top(viewport *vp)
+{
+    long long top;
+    int i;
+
+    top = viewport_line_start(vp, vp->source.end(vp->source.ctx));
+    for (i = 1; i < vp->rows; i++)
+    {
+        top = viewport_prev_line(vp, top);
+    }
+
+    return top;
+}
+
+/*
+ * Returns the first visible line.
+ */
+static long long current_top(viewport *vp)
+{
+    if (vp->follow)
+    {
+        return tail_top(vp);
+    }
+
+    return viewport_line_start(vp, vp->top);
+}
+
+/*
+ * Scrolls the viewport by the given number of lines; negative values
+ * scroll towards older data. Scrolling down to the end of the stream
+ * resumes following it.
+ */
+void viewport_scroll(viewport *vp, int lines)
+{
+    long long top, tail;
+
+    top = current_top(vp);
+    tail = tail_top(vp);
+
+    for (; lines < 0; lines++)
+    {
+        top = viewport_prev_line(vp, top);
+    }
+
+    for (; (lines > 0) && (top < tail); lines--)
+    {
+        top = viewport_next_line(vp, top);
+    }
+
+    vp->top = top;
+    vp->follow = (top >= tail);
+}
+
+/*
+ * Shows the line holding offset at the top of the viewport. Jumping
+ * past the last screenful resumes following the end of the stream.
+ */
+void viewport_jump(viewport *vp, long long offset)
+{
+    long long tail;
+
+    tail = tail_top(vp);
+
+    vp->top = viewport_line_start(vp, offset);
+    vp->follow = (vp->top >= tail);
+}
+
+/*
+ * Draws the label column of a line: the arrival time and length of the
+ * datagram the line starts, or blanks for the other lines.
+ */
+static void render_label(viewport *vp, WINDOW *wnd, long long offset)
+{
+    history_record *r;
+    char label[64], hms[16];
+    time_t t;
+
+    r = vp->source.find_record(vp->source.ctx, offset);
+    if ((r == NULL) || (r->offset != offset))
+    {
+        wprintw(wnd, "%*s", VIEWPORT_LABEL_WIDTH, "");
+        return;
+    }
+
+    t = r->ns / 1000000000ULL;
+    strftime(hms, sizeof(hms), "%H:%M:%S", localtime(&t));
+    snprintf(label, sizeof(label), "%s.%03d %5d ", hms,
+             (int)((r->ns / 1000000ULL) % 1000), r->len);
+    waddnstr(wnd, label, VIEWPORT_LABEL_WIDTH);
+}
+
+/*
+ * Draws the visible lines of the viewport into a window.
+ */
+void viewport_render(viewport *vp, WINDOW *wnd)
+{
+    static unsigned char buf[VIEWPORT_MAX_COLS];
+    static char cells[FORMAT_BUFFER_SIZE(VIEWPORT_MAX_COLS)];
+    long long offset, next;
+    int row, n, len;
+
+    /* nothing to show before a source has been attached */
+    if (vp->source.read == NULL)
+    {
+        return;
+    }
+
+    getmaxyx(wnd, vp->rows, vp->cols);
+    if (vp->cols > VIEWPORT_MAX_COLS)
+    {
+        vp->cols = VIEWPORT_MAX_COLS;
+    }
+
+    offset = current_top(vp);
+    if (!vp->follow)
+    {
+        vp->top = offset;
+    }
+
+    for (row = 0; row < vp->rows; row++)
+    {
+        wmove(wnd, row, 0);
+
+        next = viewport_next_line(vp, offset);
+        if ((vp->source.find_record != NULL) && (next > offset))
+        {
+            render_label(vp, wnd, offset);
+        }
+        n = vp->source.read(vp->source.ctx, offset, buf, next - offset);
+        if (n > 0)
+        {
+            len = vp->format->formatter(buf, n, cells);
+            if ((len > 0) && (cells[len - 1] == '\n'))
+            {
+                len--;
+            }
+            waddnstr(wnd, cells, len);
+        }
+
+        /* a full line leaves the cursor on the next row already */
+        if (getcury(wnd) == row)
+        {
+            wclrtoeol(wnd);
+        }
+        offset = next;
+    }
+}